@@ -129,11 +129,19 @@ static thread_local float midi_scratch[MIDI_SCRATCH_FRAMES];
 
 #define OBJECT_CHUNK		8
 #define RECYCLE_THRESHOLD	128
+#define OBJECT_HASH_SIZE	512	/* power of 2 */
 
 typedef void (*mix_func) (float *dst, float *src[], uint32_t n_src, bool aligned, uint32_t n_samples);
 
 struct object {
 	struct spa_list link;
+	struct spa_list id_link;
+	struct spa_list serial_link;
+	struct object_name {
+		struct spa_list link;
+		struct object *object;
+		const char *name;
+	} name_link[4];		/* name, alias1, alias2, system */
 
 	struct client *client;
 
@@ -307,6 +315,11 @@ struct context {
 	pthread_mutex_t lock;		/* protects map and lists below, in addition to thread_lock */
 	struct spa_list objects;
 	uint32_t free_count;
+	struct spa_list id_hash[OBJECT_HASH_SIZE];
+	struct spa_list serial_hash[OBJECT_HASH_SIZE];	/* also has the removed objects */
+	struct spa_list name_hash[OBJECT_HASH_SIZE];	/* ports by name and aliases */
+	struct pw_array sorted_ports;			/* ports in jack_get_ports() order */
+	bool ports_changed;
 };
 
 #define GET_DIRECTION(f)	((f) & JackPortIsInput ? SPA_DIRECTION_INPUT : SPA_DIRECTION_OUTPUT)
@@ -510,6 +523,66 @@ int pw_jack_match_rules(const char *rules, size_t size, const struct spa_dict *p
 		int (*matched) (void *data, const char *action, const char *val, int len),
 		void *data);
 
+static inline uint32_t hash_name(const char *name)
+{
+	uint32_t h = 2166136261u;
+	while (*name)
+		h = (h ^ (uint8_t)*name++) * 16777619u;
+	return h & (OBJECT_HASH_SIZE - 1);
+}
+
+static inline void hash_unlink(struct spa_list *link)
+{
+	if (link->next != NULL) {
+		spa_list_remove(link);
+		spa_zero(*link);
+	}
+}
+
+/* called with the context lock */
+static void object_unlink_names(struct object *o)
+{
+	uint32_t i;
+	for (i = 0; i < SPA_N_ELEMENTS(o->name_link); i++)
+		hash_unlink(&o->name_link[i].link);
+}
+
+static void object_update_names(struct client *c, struct object *o)
+{
+	const char *names[] = { o->port.name, o->port.alias1,
+		o->port.alias2, o->port.system };
+	uint32_t i;
+
+	pthread_mutex_lock(&c->context.lock);
+	object_unlink_names(o);
+	if (o->type == INTERFACE_Port && !o->removed) {
+		for (i = 0; i < SPA_N_ELEMENTS(names); i++) {
+			struct object_name *n = &o->name_link[i];
+			if (names[i][0] == '\0')
+				continue;
+			n->object = o;
+			n->name = names[i];
+			spa_list_append(&c->context.name_hash[hash_name(n->name)], &n->link);
+		}
+	}
+	pthread_mutex_unlock(&c->context.lock);
+}
+
+static void object_set_id(struct client *c, struct object *o, uint32_t id, uint32_t serial)
+{
+	pthread_mutex_lock(&c->context.lock);
+	hash_unlink(&o->id_link);
+	hash_unlink(&o->serial_link);
+	o->id = id;
+	o->serial = serial;
+	if (id != SPA_ID_INVALID)
+		spa_list_append(&c->context.id_hash[id & (OBJECT_HASH_SIZE - 1)], &o->id_link);
+	spa_list_append(&c->context.serial_hash[serial & (OBJECT_HASH_SIZE - 1)], &o->serial_link);
+	if (o->type == INTERFACE_Port)
+		c->context.ports_changed = true;
+	pthread_mutex_unlock(&c->context.lock);
+}
+
 static struct object * alloc_object(struct client *c, int type)
 {
 	struct object *o;
@@ -548,6 +621,7 @@ static void recycle_objects(struct client *c, uint32_t remain)
 				c->context.free_count, remain);
 		if (o->removed) {
 			spa_list_remove(&o->link);
+			hash_unlink(&o->serial_link);
 			memset(o, 0, sizeof(struct object));
 			spa_list_append(&globals.free_objects, &o->link);
 			if (--c->context.free_count == remain)
@@ -566,9 +640,13 @@ static void free_object(struct client *c, struct object *o)
 			c->context.free_count, RECYCLE_THRESHOLD);
 	pthread_mutex_lock(&c->context.lock);
 	spa_list_remove(&o->link);
+	hash_unlink(&o->id_link);
+	object_unlink_names(o);
 	o->removed = true;
 	o->id = SPA_ID_INVALID;
 	spa_list_append(&c->context.objects, &o->link);
+	if (o->type == INTERFACE_Port)
+		c->context.ports_changed = true;
 	if (++c->context.free_count >= RECYCLE_THRESHOLD)
 		recycle_objects(c, RECYCLE_THRESHOLD / 2);
 	pthread_mutex_unlock(&c->context.lock);
@@ -786,6 +864,7 @@ static struct port * alloc_port(struct client *c, enum spa_direction direction)
 
 	pthread_mutex_lock(&c->context.lock);
 	spa_list_append(&c->context.objects, &o->link);
+	c->context.ports_changed = true;
 	pthread_mutex_unlock(&c->context.lock);
 
 	return p;
@@ -845,18 +924,17 @@ static inline bool client_port_visible(struct client *c, struct object *o)
 
 static struct object *find_port_by_name(struct client *c, const char *name)
 {
-	struct object *o;
+	struct object_name *n;
 
-	spa_list_for_each(o, &c->context.objects, link) {
-		if (o->type != INTERFACE_Port || o->removed ||
-		    (!client_port_visible(c, o)))
+	spa_list_for_each(n, &c->context.name_hash[hash_name(name)], link) {
+		struct object *o = n->object;
+		if (o->removed || !client_port_visible(c, o) ||
+		    !spa_streq(n->name, name))
 			continue;
-		if (spa_streq(o->port.name, name) ||
-		    spa_streq(o->port.alias1, name) ||
-		    spa_streq(o->port.alias2, name))
-			return o;
-		if (is_port_default(c, o) && spa_streq(o->port.system, name))
-			return o;
+		/* the system name only exists for the default device */
+		if (n == &o->name_link[3] && !is_port_default(c, o))
+			continue;
+		return o;
 	}
 	return NULL;
 }
@@ -864,7 +942,7 @@ static struct object *find_port_by_name(struct client *c, const char *name)
 static struct object *find_by_id(struct client *c, uint32_t id)
 {
 	struct object *o;
-	spa_list_for_each(o, &c->context.objects, link) {
+	spa_list_for_each(o, &c->context.id_hash[id & (OBJECT_HASH_SIZE - 1)], id_link) {
 		if (o->id == id)
 			return o;
 	}
@@ -874,7 +952,7 @@ static struct object *find_by_id(struct client *c, uint32_t id)
 static struct object *find_by_serial(struct client *c, uint32_t serial)
 {
 	struct object *o;
-	spa_list_for_each(o, &c->context.objects, link) {
+	spa_list_for_each(o, &c->context.serial_hash[serial & (OBJECT_HASH_SIZE - 1)], serial_link) {
 		if (o->serial == serial)
 			return o;
 	}
@@ -3501,6 +3579,8 @@ static int metadata_property(void *data, uint32_t id,
 			if (value == NULL)
 				c->metadata->default_audio_source[0] = '\0';
 		}
+		/* the default ports are sorted first */
+		c->context.ports_changed = true;
 	} else {
 		if ((o = find_id(c, id, true)) == NULL)
 			return -EINVAL;
@@ -3538,6 +3618,7 @@ static void metadata_proxy_destroy(void *data)
 	spa_hook_remove(&c->metadata->proxy_listener);
 	spa_hook_remove(&c->metadata->listener);
 	c->metadata = NULL;
+	c->context.ports_changed = true;
 }
 
 static const struct pw_proxy_events metadata_proxy_events = {
@@ -3932,6 +4013,8 @@ static void registry_event_global(void *data, uint32_t id,
 		o->port.node_id = node_id;
 		o->port.is_monitor = is_monitor;
 
+		object_update_names(c, o);
+
 		pw_log_debug("%p: %p add port %d name:%s %d", c, o, id,
 				o->port.name, type_id);
 	}
@@ -4027,8 +4110,7 @@ static void registry_event_global(void *data, uint32_t id,
 		goto exit;
 	}
 
-	o->id = id;
-	o->serial = serial;
+	object_set_id(c, o, id, serial);
 
 	switch (o->type) {
 	case INTERFACE_Node:
@@ -4089,6 +4171,7 @@ static void registry_event_global_remove(void *data, uint32_t id)
 				c->metadata->default_audio_sink[0] = '\0';
 			if (spa_streq(o->node.node_name, c->metadata->default_audio_source))
 				c->metadata->default_audio_source[0] = '\0';
+			c->context.ports_changed = true;
 		}
 		if (find_node(c, o->node.name) == NULL) {
 			pw_log_info("%p: client %u removed \"%s\"", c, o->id, o->node.name);
@@ -4162,7 +4245,7 @@ jack_client_t * jack_client_open (const char *client_name,
 {
 	struct client *client;
 	const struct spa_support *support;
-	uint32_t n_support;
+	uint32_t i, n_support;
 	const char *str;
 	struct spa_cpu *cpu_iface;
 	const struct pw_properties *props;
@@ -4189,6 +4272,13 @@ jack_client_t * jack_client_open (const char *client_name,
 
 	pthread_mutex_init(&client->context.lock, NULL);
 	spa_list_init(&client->context.objects);
+	for (i = 0; i < OBJECT_HASH_SIZE; i++) {
+		spa_list_init(&client->context.id_hash[i]);
+		spa_list_init(&client->context.serial_hash[i]);
+		spa_list_init(&client->context.name_hash[i]);
+	}
+	pw_array_init(&client->context.sorted_ports, sizeof(void*) * 64);
+	client->context.ports_changed = true;
 
 	client->node_id = SPA_ID_INVALID;
 
@@ -4602,6 +4692,7 @@ int jack_client_close (jack_client_t *client)
 	pw_map_clear(&c->ports[SPA_DIRECTION_INPUT]);
 	pw_map_clear(&c->ports[SPA_DIRECTION_OUTPUT]);
 
+	pw_array_clear(&c->context.sorted_ports);
 	pthread_mutex_destroy(&c->context.lock);
 	pthread_mutex_destroy(&c->rt_lock);
 	pw_properties_free(c->props);
@@ -5468,6 +5559,7 @@ jack_port_t * jack_port_register (jack_client_t *client,
 	o->port.flags = flags;
 	strcpy(o->port.name, name);
 	o->port.type_id = type_id;
+	object_update_names(c, o);
 
 	init_buffer(p, c->max_frames);
 
@@ -6115,6 +6207,7 @@ int jack_port_rename (jack_client_t* client, jack_port_t *port, const char *port
 
 	pw_properties_set(p->props, PW_KEY_PORT_NAME, port_name);
 	snprintf(o->port.name, sizeof(o->port.name), "%s:%s", c->name, port_name);
+	object_update_names(c, o);
 
 	p->info.change_mask |= SPA_PORT_CHANGE_MASK_PROPS;
 	p->info.props = &p->props->dict;
@@ -6169,6 +6262,7 @@ int jack_port_set_alias (jack_port_t *port, const char *alias)
 		res = -1;
 		goto done;
 	}
+	object_update_names(c, o);
 
 	pw_properties_set(p->props, key, alias);
 
@@ -6781,6 +6875,23 @@ static int port_compare_func(const void *v1, const void *v2)
 	return res;
 }
 
+/* called with the context lock */
+static void update_sorted_ports(struct client *c)
+{
+	struct object *o;
+
+	pw_array_reset(&c->context.sorted_ports);
+	spa_list_for_each(o, &c->context.objects, link) {
+		if (o->type != INTERFACE_Port || o->removed)
+			continue;
+		pw_array_add_ptr(&c->context.sorted_ports, o);
+	}
+	qsort(c->context.sorted_ports.data,
+			pw_array_get_len(&c->context.sorted_ports, struct object *),
+			sizeof(struct object *), port_compare_func);
+	c->context.ports_changed = false;
+}
+
 SPA_EXPORT
 const char ** jack_get_ports (jack_client_t *client,
                               const char *port_name_pattern,
@@ -6789,7 +6900,7 @@ const char ** jack_get_ports (jack_client_t *client,
 {
 	struct client *c = (struct client *) client;
 	const char **res;
-	struct object *o;
+	struct object **op, *o;
 	struct pw_array tmp;
 	const char *str;
 	uint32_t i, count;
@@ -6820,8 +6931,12 @@ const char ** jack_get_ports (jack_client_t *client,
 	pw_array_init(&tmp, sizeof(void*) * 32);
 	count = 0;
 
-	spa_list_for_each(o, &c->context.objects, link) {
-		if (o->type != INTERFACE_Port || o->removed || !o->visible)
+	if (c->context.ports_changed)
+		update_sorted_ports(c);
+
+	pw_array_for_each(op, &c->context.sorted_ports) {
+		o = *op;
+		if (!o->visible)
 			continue;
 		pw_log_debug("%p: check port type:%d flags:%08lx name:\"%s\"", c,
 				o->port.type_id, o->port.flags, o->port.name);
@@ -6857,7 +6972,6 @@ const char ** jack_get_ports (jack_client_t *client,
 	pthread_mutex_unlock(&c->context.lock);
 
 	if (count > 0) {
-		qsort(tmp.data, count, sizeof(struct object *), port_compare_func);
 		pw_array_add_ptr(&tmp, NULL);
 		res = tmp.data;
 		for (i = 0; i < count; i++)
@@ -54,6 +54,16 @@ enum spa_profiler {
 							  *      Int : driver status,
 							  *      Fraction : latency,
 							  *      Int : xrun_count))  */
+	SPA_PROFILER_criticalPath,			/**< the chain of followers that took the
+							  *  longest to complete in the cycle
+							  *  (Struct(
+							  *      Long : start time, driver signal,
+							  *      Long : end time, finish of the last node,
+							  *      Long : busy time of the nodes on the path,
+							  *      Struct(
+							  *        Int : id of the first node,
+							  *        ...
+							  *        Int : id of the last node)))  */
 
 	SPA_PROFILER_START_Follower	= 0x20000,	/**< follower related profiler properties */
 	SPA_PROFILER_followerBlock,			/**< generic follower info block
@@ -36,6 +36,7 @@
 #include "volume-ops.h"
 #include "fmt-ops.h"
 #include "channelmix-ops.h"
+#include "peaks-ops.h"
 #include "resample.h"
 #include "wavfile.h"
 
@@ -51,6 +52,11 @@ SPA_LOG_TOPIC_DEFINE_STATIC(log_topic, "spa.audioconvert");
 #define MAX_DATAS	SPA_AUDIO_MAX_CHANNELS
 #define MAX_PORTS	(SPA_AUDIO_MAX_CHANNELS+1)
 #define MAX_STAGES	64
+/* when the stages can be run in blocks, the intermediate data of all channels
+ * of one block should fit in this many bytes so that it stays in the cache */
+#define BLOCK_BYTES	8192
+#define MIN_BLOCK_SIZE	64u
+#define MAX_BLOCK_SIZE	256u
 #define MAX_GRAPH	9	/* 8 active + 1 replacement slot */
 
 #define DEFAULT_MUTE		false
@@ -254,6 +260,7 @@ struct impl {
 
 	struct stage stages[MAX_STAGES];
 	uint32_t n_stages;
+	uint32_t block_size;
 
 	uint32_t cpu_flags;
 	uint32_t max_align;
@@ -285,6 +292,7 @@ struct impl {
 	struct channelmix mix;
 	struct resample resample;
 	struct volume volume;
+	struct peaks peaks;
 	double rate_scale;
 	struct spa_pod_sequence *vol_ramp_sequence;
 	uint32_t vol_ramp_offset;
@@ -301,6 +309,7 @@ struct impl {
 	unsigned int port_ignore_latency:1;
 	unsigned int monitor_passthrough:1;
 	unsigned int resample_passthrough:1;
+	unsigned int detect_silence:1;
 
 	bool recalc;
 
@@ -3297,7 +3306,34 @@ static void run_src_convert_stage(struct stage *s, struct stage_context *c)
 	}
 	convert_process(&dir->conv, dst, (const void**)c->datas[s->in_idx], c->n_samples);
 }
-static void add_src_convert_stage(struct impl *impl, struct stage_context *ctx)
+
+/* input convert with the channelmix volumes applied in the same pass, used
+ * when channelmix only applies a volume per channel */
+static void run_src_convert_gain_stage(struct stage *s, struct stage_context *c)
+{
+	struct impl *impl = s->impl;
+	struct dir *dir = &impl->dir[SPA_DIRECTION_INPUT];
+	void *remap_src_datas[MAX_PORTS], **dst;
+	float gain[MAX_PORTS];
+	uint32_t i;
+
+	spa_log_trace_fp(impl->log, "%p: input convert gain %d", impl, c->n_samples);
+	if (dir->need_remap) {
+		for (i = 0; i < dir->conv.n_channels; i++) {
+			remap_src_datas[i] = c->datas[s->out_idx][dir->remap[i]];
+			gain[i] = impl->mix.matrix[dir->remap[i]][dir->remap[i]];
+		}
+		dst = remap_src_datas;
+	} else {
+		for (i = 0; i < dir->conv.n_channels; i++)
+			gain[i] = impl->mix.matrix[i][i];
+		dst = c->datas[s->out_idx];
+	}
+	convert_process_gain(&dir->conv, dst, (const void**)c->datas[s->in_idx],
+			gain, c->n_samples);
+}
+
+static void add_src_convert_stage(struct impl *impl, struct stage_context *ctx, bool gain)
 {
 	struct stage *s = &impl->stages[impl->n_stages];
 	s->impl = impl;
@@ -3307,7 +3343,7 @@ static void add_src_convert_stage(struct impl *impl, struct stage_context *ctx)
 	s->n_in = ctx->n_datas;
 	s->n_out = ctx->n_datas;
 	s->data = NULL;
-	s->run = run_src_convert_stage;
+	s->run = gain ? run_src_convert_gain_stage : run_src_convert_stage;
 	spa_log_trace(impl->log, "%p: stage %d", impl, impl->n_stages);
 	impl->n_stages++;
 	ctx->src_idx = ctx->dst_idx;
@@ -3447,10 +3483,11 @@ static void recalc_stages(struct impl *this, struct stage_context *ctx)
 {
 	struct dir *dir;
 	bool filter_passthrough, in_passthrough, mix_passthrough, resample_passthrough, out_passthrough;
+	bool mix_sequence, mix_gain, wav;
 	int tmp = 0;
 	struct port *ctrlport = ctx->ctrlport;
 	bool in_need_remap, out_need_remap;
-	uint32_t i;
+	uint32_t i, n_channels;
 
 	this->recalc = false;
 	this->n_stages = 0;
@@ -3466,17 +3503,27 @@ static void recalc_stages(struct impl *this, struct stage_context *ctx)
 	resample_passthrough = resample_is_passthrough(this);
 	filter_passthrough = this->n_graph == 0;
 	this->resample_passthrough = resample_passthrough;
-	mix_passthrough = SPA_FLAG_IS_SET(this->mix.flags, CHANNELMIX_FLAG_IDENTITY) &&
-		(ctrlport == NULL || ctrlport->ctrl == NULL) && (this->vol_ramp_sequence == NULL);
+	mix_sequence = (ctrlport != NULL && ctrlport->ctrl != NULL) || (this->vol_ramp_sequence != NULL);
+	mix_passthrough = SPA_FLAG_IS_SET(this->mix.flags, CHANNELMIX_FLAG_IDENTITY) && !mix_sequence;
+	wav = this->props.wav_path[0] || this->wav_file != NULL;
 
 	if (in_passthrough && filter_passthrough && mix_passthrough && resample_passthrough)
 		out_passthrough = false;
 
+	/* when channelmix only applies a volume, do this while converting the
+	 * input when it comes right after the input conversion */
+	mix_gain = !in_passthrough && !mix_passthrough && !mix_sequence &&
+		SPA_FLAG_IS_SET(this->mix.flags, CHANNELMIX_FLAG_DIAGONAL) &&
+		filter_passthrough &&
+		(this->direction == SPA_DIRECTION_OUTPUT || resample_passthrough) &&
+		this->dir[SPA_DIRECTION_INPUT].conv.process_gain != NULL;
+	if (mix_gain)
+		mix_passthrough = true;
+
 	if (out_passthrough && out_need_remap)
 		add_dst_remap_stage(this, ctx);
 
-	if (this->direction == SPA_DIRECTION_INPUT &&
-	    (this->props.wav_path[0] || this->wav_file != NULL))
+	if (this->direction == SPA_DIRECTION_INPUT && wav)
 		add_wav_stage(this, ctx);
 
 	if (!in_passthrough) {
@@ -3485,7 +3532,7 @@ static void recalc_stages(struct impl *this, struct stage_context *ctx)
 		else
 			ctx->dst_idx = CTX_DATA_TMP_0 + ((tmp++) & 1);
 
-		add_src_convert_stage(this, ctx);
+		add_src_convert_stage(this, ctx, mix_gain);
 	} else {
 		if (in_need_remap)
 			add_src_remap_stage(this, ctx);
@@ -3536,11 +3583,59 @@ static void recalc_stages(struct impl *this, struct stage_context *ctx)
 	if (!out_passthrough) {
 		add_dst_convert_stage(this, ctx);
 	}
-	if (this->direction == SPA_DIRECTION_OUTPUT &&
-	    (this->props.wav_path[0] || this->wav_file != NULL))
+	if (this->direction == SPA_DIRECTION_OUTPUT && wav)
 		add_wav_stage(this, ctx);
 
-	spa_log_trace(this->log, "got %u processing stages", this->n_stages);
+	/* Without resampler, filters and control sequences, the stages don't
+	 * depend on the number of samples they process. Run them in small
+	 * blocks so that the intermediate buffers stay in the cache. */
+	if (tmp > 0 && this->resample_passthrough && filter_passthrough &&
+	    !mix_sequence && !wav) {
+		n_channels = SPA_MAX(this->mix.src_chan, this->mix.dst_chan);
+		this->block_size = SPA_ROUND_DOWN_N(BLOCK_BYTES / (SPA_MAX(n_channels, 1u) * sizeof(float)),
+				MIN_BLOCK_SIZE);
+		this->block_size = SPA_CLAMP(this->block_size, MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+	} else {
+		this->block_size = 0;
+	}
+
+	spa_log_trace(this->log, "got %u processing stages block:%u gain:%d",
+			this->n_stages, this->block_size, mix_gain);
+}
+
+static void run_stages(struct impl *this, struct stage_context *ctx)
+{
+	uint32_t i;
+	for (i = 0; i < this->n_stages; i++) {
+		struct stage *s = &this->stages[i];
+		s->run(s, ctx);
+	}
+}
+
+/* run the stages on blocks of block_size samples. The stages read from the
+ * src datas and write to the dst datas, move them to the block and let the
+ * stages use the start of the tmp buffers for all blocks. */
+static void run_stages_blocked(struct impl *this, struct stage_context *ctx,
+		uint32_t n_src_datas, uint32_t src_stride,
+		uint32_t n_dst_datas, uint32_t dst_stride)
+{
+	void **src = ctx->datas[CTX_DATA_SRC], **dst = ctx->datas[CTX_DATA_DST];
+	void *src_base[MAX_PORTS], *dst_base[MAX_PORTS];
+	uint32_t i, offs, n_samples = ctx->n_samples;
+
+	memcpy(src_base, src, n_src_datas * sizeof(void*));
+	memcpy(dst_base, dst, n_dst_datas * sizeof(void*));
+
+	for (offs = 0; offs < n_samples; offs += this->block_size) {
+		for (i = 0; i < n_src_datas; i++)
+			src[i] = SPA_PTROFF(src_base[i], offs * src_stride, void);
+		for (i = 0; i < n_dst_datas; i++)
+			dst[i] = SPA_PTROFF(dst_base[i], offs * dst_stride, void);
+
+		ctx->n_samples = SPA_MIN(this->block_size, n_samples - offs);
+		run_stages(this, ctx);
+	}
+	ctx->in_samples = ctx->n_samples = n_samples;
 }
 
 static int impl_node_process(void *object)
@@ -3549,7 +3644,7 @@ static int impl_node_process(void *object)
 	const void *src_datas[MAX_PORTS];
 	void *dst_datas[MAX_PORTS], *remap_src_datas[MAX_PORTS], *remap_dst_datas[MAX_PORTS];
 	uint32_t i, j, n_src_datas = 0, n_dst_datas = 0, n_mon_datas = 0, remap;
-	uint32_t n_samples, max_in, n_out, max_out, quant_samples;
+	uint32_t n_samples, max_in, n_out, max_out, quant_samples, in_stride = 0, out_stride = 0;
 	struct port *port, *ctrlport = NULL;
 	struct buffer *buf, *out_bufs[MAX_PORTS];
 	struct spa_data *bd;
@@ -3638,6 +3733,7 @@ static int impl_node_process(void *object)
 				} else {
 					remap = n_src_datas++;
 					src_datas[remap] = SPA_PTR_ALIGN(this->empty, MAX_ALIGN, void);
+					in_stride = port->stride;
 					spa_log_trace_fp(this->log, "%p: empty input %d->%d", this,
 							i * port->blocks + j, remap);
 					max_in = SPA_MIN(max_in, this->scratch_size / port->stride);
@@ -3674,6 +3770,7 @@ static int impl_node_process(void *object)
 					remap = n_src_datas++;
 					offs += this->in_offset * port->stride;
 					src_datas[remap] = SPA_PTROFF(bd->data, offs, void);
+					in_stride = port->stride;
 
 					spa_log_trace_fp(this->log, "%p: input %d:%d:%d %d %d %d->%d", this,
 							offs, size, port->stride, this->in_offset, max_in,
@@ -3740,6 +3837,7 @@ static int impl_node_process(void *object)
 				} else {
 					remap = n_dst_datas++;
 					dst_datas[remap] = SPA_PTR_ALIGN(this->scratch, MAX_ALIGN, void);
+					out_stride = port->stride;
 					spa_log_trace_fp(this->log, "%p: empty output %d->%d", this,
 						i * port->blocks + j, remap);
 					max_out = SPA_MIN(max_out, this->scratch_size / port->stride);
@@ -3786,6 +3884,7 @@ static int impl_node_process(void *object)
 					remap = n_dst_datas++;
 					dst_datas[remap] = SPA_PTROFF(bd->data,
 							this->out_offset * port->stride, void);
+					out_stride = port->stride;
 					max_out = SPA_MIN(max_out, bd->maxsize / port->stride);
 
 					spa_log_trace_fp(this->log, "%p: output %d offs:%d %d->%d", this,
@@ -3837,10 +3936,11 @@ static int impl_node_process(void *object)
 	if (this->recalc)
 		recalc_stages(this, &ctx);
 
-	for (i = 0; i < this->n_stages; i++) {
-		struct stage *s = &this->stages[i];
-		s->run(s, &ctx);
-	}
+	if (this->block_size > 0 && n_samples > this->block_size)
+		run_stages_blocked(this, &ctx, n_src_datas, in_stride,
+				n_dst_datas, out_stride);
+	else
+		run_stages(this, &ctx);
 	this->in_offset += ctx.in_samples;
 	this->out_offset += ctx.n_samples;
 
@@ -3881,10 +3981,17 @@ static int impl_node_process(void *object)
 			dequeue_buffer(this, port, buf);
 
 			for (j = 0; j < port->blocks; j++) {
+				bool empty = in_empty;
+
 				bd = &buf->buf->datas[j];
 				bd->chunk->size = this->out_offset * port->stride;
 				bd->chunk->stride = port->stride;
-				SPA_FLAG_UPDATE(bd->chunk->flags, SPA_CHUNK_FLAG_EMPTY, in_empty);
+				/* flag silent dsp output so that the mixer can skip it */
+				if (!empty && this->detect_silence && port->is_dsp)
+					empty = peaks_abs_max(&this->peaks,
+							SPA_PTROFF(bd->data, bd->chunk->offset, float),
+							this->out_offset, 0.0f) == 0.0f;
+				SPA_FLAG_UPDATE(bd->chunk->flags, SPA_CHUNK_FLAG_EMPTY, empty);
 				spa_log_trace_fp(this->log, "out: offs:%d stride:%d size:%d",
 						this->out_offset, port->stride, bd->chunk->size);
 			}
@@ -3989,6 +4096,8 @@ static int impl_clear(struct spa_handle *handle)
 
 	if (this->resample.free)
 		resample_free(&this->resample);
+	if (this->peaks.free)
+		peaks_free(&this->peaks);
 	if (this->wav_file != NULL)
 		wav_file_close(this->wav_file);
 	free (this->vol_ramp_sequence);
@@ -4013,6 +4122,7 @@ impl_init(const struct spa_handle_factory *factory,
 	uint32_t i;
 	const char *str;
 	bool filter_graph_disabled;
+	int res;
 
 	spa_return_val_if_fail(factory != NULL, -EINVAL);
 	spa_return_val_if_fail(handle != NULL, -EINVAL);
@@ -4075,6 +4185,8 @@ impl_init(const struct spa_handle_factory *factory,
 			spa_scnprintf(this->group_name, sizeof(this->group_name), "%s", s);
 		else if (spa_streq(k, "monitor.passthrough"))
 			this->monitor_passthrough = spa_atob(s);
+		else if (spa_streq(k, "convert.detect-silence"))
+			this->detect_silence = spa_atob(s);
 		else if (spa_streq(k, "audioconvert.filter-graph.disable"))
 			filter_graph_disabled = spa_atob(s);
 		else
@@ -4113,6 +4225,11 @@ impl_init(const struct spa_handle_factory *factory,
 	this->volume.cpu_flags = this->cpu_flags;
 	volume_init(&this->volume);
 
+	this->peaks.log = this->log;
+	this->peaks.cpu_flags = this->cpu_flags;
+	if ((res = peaks_init(&this->peaks)) < 0)
+		return res;
+
 	this->rate_scale = 1.0;
 
 	reconfigure_mode(this, SPA_PARAM_PORT_CONFIG_MODE_convert, SPA_DIRECTION_INPUT, false, false, NULL);
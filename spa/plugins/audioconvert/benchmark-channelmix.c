@@ -0,0 +1,219 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "test-helper.h"
+#include "channelmix-ops.h"
+
+static uint32_t cpu_flags;
+
+typedef void (*channelmix_func_t) (struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples);
+
+struct stats {
+	uint32_t n_samples;
+	uint32_t src_chan;
+	uint32_t dst_chan;
+	uint64_t perf;
+	const char *name;
+	const char *impl;
+};
+
+#define MAX_SAMPLES	4096
+#define MAX_CHANNELS	16
+
+#define MAX_COUNT 100
+
+static float samp_in[MAX_CHANNELS][MAX_SAMPLES] SPA_ALIGNED(64);
+static float samp_out[MAX_CHANNELS][MAX_SAMPLES] SPA_ALIGNED(64);
+
+static const int sample_sizes[] = { 0, 1, 128, 513, 1024, 4096 };
+
+#define MAX_RESULTS	SPA_N_ELEMENTS(sample_sizes) * 64
+
+static uint32_t n_results = 0;
+static struct stats results[MAX_RESULTS];
+
+static void run_test1(const char *name, const char *impl, struct channelmix *mix,
+		channelmix_func_t func, int n_samples)
+{
+	uint32_t i, j;
+	const void *ip[mix->src_chan];
+	void *op[mix->dst_chan];
+	struct timespec ts;
+	uint64_t count, t1, t2;
+
+	for (j = 0; j < mix->src_chan; j++)
+		ip[j] = samp_in[j];
+	for (j = 0; j < mix->dst_chan; j++)
+		op[j] = samp_out[j];
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	count = 0;
+	for (i = 0; i < MAX_COUNT; i++) {
+		func(mix, op, ip, n_samples);
+		count++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	spa_assert(n_results < MAX_RESULTS);
+
+	results[n_results++] = (struct stats) {
+		.n_samples = n_samples,
+		.src_chan = mix->src_chan,
+		.dst_chan = mix->dst_chan,
+		.perf = count * (uint64_t)SPA_NSEC_PER_SEC / SPA_MAX(t2 - t1, 1u),
+		.name = name,
+		.impl = impl
+	};
+}
+
+static void run_test(const char *name, const char *impl,
+		uint32_t src_chan, uint64_t src_mask, uint32_t dst_chan, uint64_t dst_mask,
+		channelmix_func_t func)
+{
+	struct channelmix mix;
+	uint32_t i, j;
+
+	spa_zero(mix);
+	mix.src_chan = src_chan;
+	mix.src_mask = src_mask;
+	mix.dst_chan = dst_chan;
+	mix.dst_mask = dst_mask;
+	mix.freq = 48000;
+	spa_assert_se(channelmix_init(&mix) == 0);
+
+	if (src_mask == 0 || dst_mask == 0) {
+		/* make a dense matrix for the generic case */
+		for (i = 0; i < dst_chan; i++)
+			for (j = 0; j < src_chan; j++)
+				mix.matrix_orig[i][j] = (float)(drand48() - 0.5f);
+	}
+	channelmix_set_volume(&mix, 1.0f, false, 0, NULL);
+
+	SPA_FOR_EACH_ELEMENT_VAR(sample_sizes, s)
+		run_test1(name, impl, &mix, func, *s);
+
+	channelmix_free(&mix);
+}
+
+static void test_copy(void)
+{
+	run_test("test_copy", "c", 2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_test("test_copy", "sse", 2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_sse);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test("test_copy", "avx", 2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_avx);
+#endif
+}
+
+static void test_n_m(void)
+{
+	run_test("test_n_m", "c", 16, 0, 12, 0, channelmix_f32_n_m_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_test("test_n_m", "sse", 16, 0, 12, 0, channelmix_f32_n_m_sse);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test("test_n_m", "avx", 16, 0, 12, 0, channelmix_f32_n_m_avx);
+#endif
+#if defined (HAVE_AVX512)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX512))
+		run_test("test_n_m", "avx512", 16, 0, 12, 0, channelmix_f32_n_m_avx512);
+#endif
+}
+
+static void test_upmix(void)
+{
+	run_test("test_2_5p1", "c", 2, MASK_STEREO, 6, MASK_5_1, channelmix_f32_2_5p1_c);
+	run_test("test_2_7p1", "c", 2, MASK_STEREO, 8, MASK_7_1, channelmix_f32_2_7p1_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE) {
+		run_test("test_2_5p1", "sse", 2, MASK_STEREO, 6, MASK_5_1, channelmix_f32_2_5p1_sse);
+		run_test("test_2_7p1", "sse", 2, MASK_STEREO, 8, MASK_7_1, channelmix_f32_2_7p1_sse);
+	}
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3)) {
+		run_test("test_2_5p1", "avx", 2, MASK_STEREO, 6, MASK_5_1, channelmix_f32_2_5p1_avx);
+		run_test("test_2_7p1", "avx", 2, MASK_STEREO, 8, MASK_7_1, channelmix_f32_2_7p1_avx);
+	}
+#endif
+}
+
+static void test_downmix(void)
+{
+	run_test("test_5p1_2", "c", 6, MASK_5_1, 2, MASK_STEREO, channelmix_f32_5p1_2_c);
+	run_test("test_5p1_3p1", "c", 6, MASK_5_1, 4, MASK_3_1, channelmix_f32_5p1_3p1_c);
+	run_test("test_7p1_2", "c", 8, MASK_7_1, 2, MASK_STEREO, channelmix_f32_7p1_2_c);
+	run_test("test_7p1_3p1", "c", 8, MASK_7_1, 4, MASK_3_1, channelmix_f32_7p1_3p1_c);
+	run_test("test_7p1_4", "c", 8, MASK_7_1, 4, MASK_QUAD, channelmix_f32_7p1_4_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE) {
+		run_test("test_5p1_2", "sse", 6, MASK_5_1, 2, MASK_STEREO, channelmix_f32_5p1_2_sse);
+		run_test("test_5p1_3p1", "sse", 6, MASK_5_1, 4, MASK_3_1, channelmix_f32_5p1_3p1_sse);
+	}
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3)) {
+		run_test("test_5p1_2", "avx", 6, MASK_5_1, 2, MASK_STEREO, channelmix_f32_5p1_2_avx);
+		run_test("test_5p1_3p1", "avx", 6, MASK_5_1, 4, MASK_3_1, channelmix_f32_5p1_3p1_avx);
+		run_test("test_7p1_2", "avx", 8, MASK_7_1, 2, MASK_STEREO, channelmix_f32_7p1_2_avx);
+		run_test("test_7p1_3p1", "avx", 8, MASK_7_1, 4, MASK_3_1, channelmix_f32_7p1_3p1_avx);
+		run_test("test_7p1_4", "avx", 8, MASK_7_1, 4, MASK_QUAD, channelmix_f32_7p1_4_avx);
+	}
+#endif
+}
+
+static int compare_func(const void *_a, const void *_b)
+{
+	const struct stats *a = _a, *b = _b;
+	int diff;
+	if ((diff = strcmp(a->name, b->name)) != 0) return diff;
+	if ((diff = a->n_samples - b->n_samples) != 0) return diff;
+	if ((diff = a->src_chan - b->src_chan) != 0) return diff;
+	if ((diff = b->perf - a->perf) != 0) return diff;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t i, j;
+
+	cpu_flags = get_cpu_flags();
+	printf("got get CPU flags %d\n", cpu_flags);
+
+	for (i = 0; i < MAX_CHANNELS; i++)
+		for (j = 0; j < MAX_SAMPLES; j++)
+			samp_in[i][j] = (float)(drand48() - 0.5f);
+
+	test_copy();
+	test_n_m();
+	test_upmix();
+	test_downmix();
+
+	qsort(results, n_results, sizeof(struct stats), compare_func);
+
+	for (i = 0; i < n_results; i++) {
+		struct stats *s = &results[i];
+		fprintf(stderr, "%-12."PRIu64" \t%-16.16s %s \t samples %d, channels %d->%d\n",
+				s->perf, s->name, s->impl, s->n_samples, s->src_chan, s->dst_chan);
+	}
+	return 0;
+}
@@ -15,7 +15,7 @@
 #include "resample.h"
 
 #define MAX_SAMPLES	4096
-#define MAX_CHANNELS	11
+#define MAX_CHANNELS	32
 
 #define MAX_COUNT 200
 
@@ -37,12 +37,13 @@ static float samp_out[MAX_SAMPLES * MAX_CHANNELS];
 static const int sample_sizes[] = { 0, 1, 128, 513, 4096 };
 static const int in_rates[] = { 44100, 44100, 48000, 96000, 22050, 96000 };
 static const int out_rates[] = { 44100, 48000, 44100, 48000, 48000, 44100 };
+static const int channel_counts[] = { 1, 2, 8, 32 };
 
-
-#define MAX_RESAMPLER	5
+#define MAX_RESAMPLER	6
 #define MAX_SIZES	SPA_N_ELEMENTS(sample_sizes)
 #define MAX_RATES	SPA_N_ELEMENTS(in_rates)
-#define MAX_RESULTS	MAX_RESAMPLER * MAX_SIZES * MAX_RATES
+#define MAX_COUNTS	SPA_N_ELEMENTS(channel_counts)
+#define MAX_RESULTS	MAX_RESAMPLER * MAX_SIZES * MAX_RATES * MAX_COUNTS
 
 static uint32_t n_results = 0;
 static struct stats results[MAX_RESULTS];
@@ -107,78 +108,59 @@ static int compare_func(const void *_a, const void *_b)
 	return 0;
 }
 
-int main(int argc, char *argv[])
+static void run_impl(const char *impl, uint32_t flags)
 {
 	struct resample r;
-	uint32_t i;
-
-	cpu_flags = get_cpu_flags();
-	printf("got get CPU flags %d\n", cpu_flags);
+	uint32_t i, j;
 
 	for (i = 0; i < SPA_N_ELEMENTS(in_rates); i++) {
-		spa_zero(r);
-		r.channels = 2;
-		r.cpu_flags = 0;
-		r.i_rate = in_rates[i];
-		r.o_rate = out_rates[i];
-		r.quality = RESAMPLE_DEFAULT_QUALITY;
-		resample_native_init(&r);
-		run_test("native", "c", &r);
-		resample_free(&r);
-	}
-#if defined (HAVE_SSE)
-	if (cpu_flags & SPA_CPU_FLAG_SSE) {
-		for (i = 0; i < SPA_N_ELEMENTS(in_rates); i++) {
+		for (j = 0; j < SPA_N_ELEMENTS(channel_counts); j++) {
 			spa_zero(r);
-			r.channels = 2;
-			r.cpu_flags = SPA_CPU_FLAG_SSE;
+			r.channels = channel_counts[j];
+			r.cpu_flags = flags;
 			r.i_rate = in_rates[i];
 			r.o_rate = out_rates[i];
 			r.quality = RESAMPLE_DEFAULT_QUALITY;
 			resample_native_init(&r);
-			run_test("native", "sse", &r);
+			run_test("native", impl, &r);
 			resample_free(&r);
 		}
 	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t i;
+
+	cpu_flags = get_cpu_flags();
+	printf("got get CPU flags %d\n", cpu_flags);
+
+	run_impl("c", 0);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_impl("sse", SPA_CPU_FLAG_SSE);
 #endif
 #if defined (HAVE_SSSE3)
-	if (cpu_flags & SPA_CPU_FLAG_SSSE3) {
-		for (i = 0; i < SPA_N_ELEMENTS(in_rates); i++) {
-			spa_zero(r);
-			r.channels = 2;
-			r.cpu_flags = SPA_CPU_FLAG_SSSE3 | SPA_CPU_FLAG_SLOW_UNALIGNED;
-			r.i_rate = in_rates[i];
-			r.o_rate = out_rates[i];
-			r.quality = RESAMPLE_DEFAULT_QUALITY;
-			resample_native_init(&r);
-			run_test("native", "ssse3", &r);
-			resample_free(&r);
-		}
-	}
+	if (cpu_flags & SPA_CPU_FLAG_SSSE3)
+		run_impl("ssse3", SPA_CPU_FLAG_SSSE3 | SPA_CPU_FLAG_SLOW_UNALIGNED);
 #endif
 #if defined (HAVE_AVX) && defined(HAVE_FMA)
-	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3)) {
-		for (i = 0; i < SPA_N_ELEMENTS(in_rates); i++) {
-			spa_zero(r);
-			r.channels = 2;
-			r.cpu_flags = SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3;
-			r.i_rate = in_rates[i];
-			r.o_rate = out_rates[i];
-			r.quality = RESAMPLE_DEFAULT_QUALITY;
-			resample_native_init(&r);
-			run_test("native", "avx", &r);
-			resample_free(&r);
-		}
-	}
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_impl("avx", SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3);
+#endif
+#if defined (HAVE_AVX512)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX512))
+		run_impl("avx512", SPA_CPU_FLAG_AVX512);
 #endif
 
 	qsort(results, n_results, sizeof(struct stats), compare_func);
 
 	for (i = 0; i < n_results; i++) {
 		struct stats *s = &results[i];
-		fprintf(stderr, "%-12."PRIu64" \t%-16.16s %s \t%d->%d samples %d, channels %d\n",
-				s->perf, s->name, s->impl, s->in_rate, s->out_rate,
-				s->n_samples, s->n_channels);
+		/* second column is the number of channels processed per second */
+		fprintf(stderr, "%-12."PRIu64" %-12."PRIu64" \t%-16.16s %s \t%d->%d samples %d, channels %d\n",
+				s->perf, s->perf * s->n_channels, s->name, s->impl,
+				s->in_rate, s->out_rate, s->n_samples, s->n_channels);
 	}
 	return 0;
 }
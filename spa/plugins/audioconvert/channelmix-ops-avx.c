@@ -0,0 +1,793 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "channelmix-ops.h"
+
+#include <immintrin.h>
+#include <float.h>
+#include <math.h>
+
+static inline void clear_avx(float *d, uint32_t n_samples)
+{
+	memset(d, 0, n_samples * sizeof(float));
+}
+
+static inline void copy_avx(float *d, const float *s, uint32_t n_samples)
+{
+	if (d != s)
+		spa_memcpy(d, s, n_samples * sizeof(float));
+}
+
+static inline void vol_avx(float *d, const float *s, float vol, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	if (vol == 0.0f) {
+		clear_avx(d, n_samples);
+	} else if (vol == 1.0f) {
+		copy_avx(d, s, n_samples);
+	} else {
+		const __m256 v = _mm256_set1_ps(vol);
+
+		if (SPA_IS_ALIGNED(d, 32) &&
+		    SPA_IS_ALIGNED(s, 32))
+			unrolled = n_samples & ~15;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 16) {
+			_mm256_store_ps(&d[n+0], _mm256_mul_ps(_mm256_load_ps(&s[n+0]), v));
+			_mm256_store_ps(&d[n+8], _mm256_mul_ps(_mm256_load_ps(&s[n+8]), v));
+		}
+		for(; n < n_samples; n++)
+			_mm_store_ss(&d[n], _mm_mul_ss(_mm_load_ss(&s[n]), _mm256_castps256_ps128(v)));
+	}
+}
+
+static inline void conv_avx(float *d, const float **s, float *c, uint32_t n_c, uint32_t n_samples)
+{
+	__m256 mi[n_c], sum[2];
+	uint32_t n, j, unrolled;
+	bool aligned = true;
+
+	for (j = 0; j < n_c; j++) {
+		mi[j] = _mm256_set1_ps(c[j]);
+		aligned &= SPA_IS_ALIGNED(s[j], 32);
+	}
+
+	if (aligned && SPA_IS_ALIGNED(d, 32))
+		unrolled = n_samples & ~15;
+	else
+		unrolled = 0;
+
+	for (n = 0; n < unrolled; n += 16) {
+		sum[0] = _mm256_mul_ps(_mm256_load_ps(&s[0][n + 0]), mi[0]);
+		sum[1] = _mm256_mul_ps(_mm256_load_ps(&s[0][n + 8]), mi[0]);
+		for (j = 1; j < n_c; j++) {
+			sum[0] = _mm256_fmadd_ps(_mm256_load_ps(&s[j][n + 0]), mi[j], sum[0]);
+			sum[1] = _mm256_fmadd_ps(_mm256_load_ps(&s[j][n + 8]), mi[j], sum[1]);
+		}
+		_mm256_store_ps(&d[n + 0], sum[0]);
+		_mm256_store_ps(&d[n + 8], sum[1]);
+	}
+	for (; n < n_samples; n++) {
+		__m128 t = _mm_setzero_ps();
+		for (j = 0; j < n_c; j++)
+			t = _mm_fmadd_ss(_mm_load_ss(&s[j][n]), _mm256_castps256_ps128(mi[j]), t);
+		_mm_store_ss(&d[n], t);
+	}
+}
+
+static inline void avg_avx(float *d, const float *s0, const float *s1, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	if (SPA_IS_ALIGNED(d, 32) &&
+	    SPA_IS_ALIGNED(s0, 32) &&
+	    SPA_IS_ALIGNED(s1, 32))
+		unrolled = n_samples & ~15;
+	else
+		unrolled = 0;
+
+	for (n = 0; n < unrolled; n += 16) {
+		_mm256_store_ps(&d[n + 0],
+				_mm256_mul_ps(
+					_mm256_add_ps(
+						_mm256_load_ps(&s0[n + 0]),
+						_mm256_load_ps(&s1[n + 0])),
+					half));
+		_mm256_store_ps(&d[n + 8],
+				_mm256_mul_ps(
+					_mm256_add_ps(
+						_mm256_load_ps(&s0[n + 8]),
+						_mm256_load_ps(&s1[n + 8])),
+					half));
+	}
+	for (; n < n_samples; n++)
+		d[n] = (s0[n] + s1[n]) * 0.5f;
+}
+
+static inline void sub_avx(float *d, const float *s0, const float *s1, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+
+	if (SPA_IS_ALIGNED(d, 32) &&
+	    SPA_IS_ALIGNED(s0, 32) &&
+	    SPA_IS_ALIGNED(s1, 32))
+		unrolled = n_samples & ~15;
+	else
+		unrolled = 0;
+
+	for (n = 0; n < unrolled; n += 16) {
+		_mm256_store_ps(&d[n + 0],
+			_mm256_sub_ps(_mm256_load_ps(&s0[n + 0]), _mm256_load_ps(&s1[n + 0])));
+		_mm256_store_ps(&d[n + 8],
+			_mm256_sub_ps(_mm256_load_ps(&s0[n + 8]), _mm256_load_ps(&s1[n + 8])));
+	}
+	for (; n < n_samples; n++)
+		d[n] = s0[n] - s1[n];
+}
+
+void channelmix_copy_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	for (i = 0; i < n_dst; i++)
+		vol_avx(d[i], s[i], mix->matrix[i][i], n_samples);
+}
+
+/* the filter is recursive over the samples, there is nothing to
+ * vectorize so this is the plain C version */
+static void lr4_process_avx(struct lr4 *lr4, float *dst, const float *src, const float vol, int samples)
+{
+	float x1 = lr4->x1;
+	float x2 = lr4->x2;
+	float y1 = lr4->y1;
+	float y2 = lr4->y2;
+	float b0 = lr4->bq.b0;
+	float b1 = lr4->bq.b1;
+	float b2 = lr4->bq.b2;
+	float a1 = lr4->bq.a1;
+	float a2 = lr4->bq.a2;
+	float x, y, z;
+	int i;
+
+	if (vol == 0.0f || !lr4->active) {
+		vol_avx(dst, src, vol, samples);
+		return;
+	}
+
+	for (i = 0; i < samples; i++) {
+		x  = src[i];
+		y  = b0 * x          + x1;
+		x1 = b1 * x - a1 * y + x2;
+		x2 = b2 * x - a2 * y;
+		z  = b0 * y          + y1;
+		y1 = b1 * y - a1 * z + y2;
+		y2 = b2 * y - a2 * z;
+		dst[i] = z * vol;
+	}
+#define F(x) (isnormal(x) ? (x) : 0.0f)
+	lr4->x1 = F(x1);
+	lr4->x2 = F(x2);
+	lr4->y1 = F(y1);
+	lr4->y2 = F(y2);
+#undef F
+}
+
+static inline void convolver_run(const float *src, float *dst,
+		const float *taps, uint32_t n_taps, const __m128 vol)
+{
+	__m128 t[1], sum[1];
+	uint32_t i;
+
+	sum[0] = _mm_setzero_ps();
+	for(i = 0; i < n_taps; i+=4) {
+		t[0] = _mm_loadu_ps(&src[i]);
+		sum[0] = _mm_fmadd_ps(_mm_load_ps(&taps[i]), t[0], sum[0]);
+	}
+	sum[0] = _mm_add_ps(sum[0], _mm_movehl_ps(sum[0], sum[0]));
+	sum[0] = _mm_add_ss(sum[0], _mm_shuffle_ps(sum[0], sum[0], 0x55));
+	t[0] = _mm_mul_ss(sum[0], vol);
+	_mm_store_ss(dst, t[0]);
+}
+
+static inline void delay_convolve_run_avx(float *buffer, uint32_t *pos,
+		uint32_t n_buffer, uint32_t delay,
+		const float *taps, uint32_t n_taps,
+		float *dst, const float *src, const float vol, uint32_t n_samples)
+{
+	__m128 t[1];
+	const __m128 v = _mm_set1_ps(vol);
+	uint32_t i;
+	uint32_t w = *pos;
+	uint32_t o = n_buffer - delay - n_taps-1;
+	uint32_t n, unrolled;
+
+	if (SPA_IS_ALIGNED(src, 16) &&
+	    SPA_IS_ALIGNED(dst, 16))
+		unrolled = n_samples & ~3;
+	else
+		unrolled = 0;
+
+	if (n_taps == 1) {
+		for(n = 0; n < unrolled; n += 4) {
+			t[0] = _mm_load_ps(&src[n]);
+			_mm_storeu_ps(&buffer[w], t[0]);
+			_mm_storeu_ps(&buffer[w+n_buffer], t[0]);
+			t[0] = _mm_loadu_ps(&buffer[w+o]);
+			t[0] = _mm_mul_ps(t[0], v);
+			_mm_store_ps(&dst[n], t[0]);
+			w += 4;
+			if (w >= n_buffer) {
+				w -= n_buffer;
+				t[0] = _mm_load_ps(&buffer[n_buffer]);
+				_mm_store_ps(&buffer[0], t[0]);
+			}
+		}
+		for(; n < n_samples; n++) {
+			t[0] = _mm_load_ss(&src[n]);
+			_mm_store_ss(&buffer[w], t[0]);
+			_mm_store_ss(&buffer[w+n_buffer], t[0]);
+			t[0] = _mm_load_ss(&buffer[w+o]);
+			t[0] = _mm_mul_ss(t[0], v);
+			_mm_store_ss(&dst[n], t[0]);
+			w = w + 1 >= n_buffer ? 0 : w + 1;
+		}
+	} else {
+		for(n = 0; n < unrolled; n += 4) {
+			t[0] = _mm_load_ps(&src[n]);
+			_mm_storeu_ps(&buffer[w], t[0]);
+			_mm_storeu_ps(&buffer[w+n_buffer], t[0]);
+			for(i = 0; i < 4; i++)
+				convolver_run(&buffer[w+o+i], &dst[n+i], taps, n_taps, v);
+			w += 4;
+			if (w >= n_buffer) {
+				w -= n_buffer;
+				t[0] = _mm_load_ps(&buffer[n_buffer]);
+				_mm_store_ps(&buffer[0], t[0]);
+			}
+		}
+		for(; n < n_samples; n++) {
+			t[0] = _mm_load_ss(&src[n]);
+			_mm_store_ss(&buffer[w], t[0]);
+			_mm_store_ss(&buffer[w+n_buffer], t[0]);
+			convolver_run(&buffer[w+o], &dst[n], taps, n_taps, v);
+			w = w + 1 >= n_buffer ? 0 : w + 1;
+		}
+	}
+	*pos = w;
+}
+
+void
+channelmix_f32_n_m_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	uint32_t i, j, n_dst = mix->dst_chan, n_src = mix->src_chan;
+
+	for (i = 0; i < n_dst; i++) {
+		float *di = d[i];
+		float mj[n_src];
+		const float *sj[n_src];
+		uint32_t n_j = 0;
+
+		for (j = 0; j < n_src; j++) {
+			if (mix->matrix[i][j] == 0.0f)
+				continue;
+			mj[n_j] = mix->matrix[i][j];
+			sj[n_j++] = s[j];
+		}
+		if (n_j == 0) {
+			clear_avx(di, n_samples);
+		} else if (n_j == 1) {
+			lr4_process_avx(&mix->lr4[i], di, sj[0], mj[0], n_samples);
+		} else {
+			conv_avx(di, sj, mj, n_j, n_samples);
+			lr4_process_avx(&mix->lr4[i], di, di, 1.0f, n_samples);
+		}
+	}
+}
+
+void
+channelmix_f32_2_3p1_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n, unrolled, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float v2 = (mix->matrix[2][0] + mix->matrix[2][1]) * 0.5f;
+	const float v3 = (mix->matrix[3][0] + mix->matrix[3][1]) * 0.5f;
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		if (mix->widen == 0.0f) {
+			vol_avx(d[0], s[0], v0, n_samples);
+			vol_avx(d[1], s[1], v1, n_samples);
+			avg_avx(d[2], s[0], s[1], n_samples);
+		} else {
+			const __m256 mv0 = _mm256_set1_ps(v0);
+			const __m256 mv1 = _mm256_set1_ps(v1);
+			const __m256 mw = _mm256_set1_ps(mix->widen);
+			const __m256 mh = _mm256_set1_ps(0.5f);
+			__m256 t0, t1, w, c;
+
+			if (SPA_IS_ALIGNED(s[0], 32) &&
+			    SPA_IS_ALIGNED(s[1], 32) &&
+			    SPA_IS_ALIGNED(d[0], 32) &&
+			    SPA_IS_ALIGNED(d[1], 32) &&
+			    SPA_IS_ALIGNED(d[2], 32))
+				unrolled = n_samples & ~7;
+			else
+				unrolled = 0;
+
+			for(n = 0; n < unrolled; n += 8) {
+				t0 = _mm256_load_ps(&s[0][n]);
+				t1 = _mm256_load_ps(&s[1][n]);
+				c = _mm256_add_ps(t0, t1);
+				w = _mm256_mul_ps(c, mw);
+				_mm256_store_ps(&d[0][n], _mm256_mul_ps(_mm256_sub_ps(t0, w), mv0));
+				_mm256_store_ps(&d[1][n], _mm256_mul_ps(_mm256_sub_ps(t1, w), mv1));
+				_mm256_store_ps(&d[2][n], _mm256_mul_ps(c, mh));
+			}
+			for (; n < n_samples; n++) {
+				float c = s[0][n] + s[1][n];
+				float w = c * mix->widen;
+				d[0][n] = (s[0][n] - w) * v0;
+				d[1][n] = (s[1][n] - w) * v1;
+				d[2][n] = c * 0.5f;
+			}
+		}
+		lr4_process_avx(&mix->lr4[3], d[3], d[2], v3, n_samples);
+		lr4_process_avx(&mix->lr4[2], d[2], d[2], v2, n_samples);
+	}
+}
+
+void
+channelmix_f32_2_5p1_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	const float v4 = mix->matrix[4][0];
+	const float v5 = mix->matrix[5][1];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		channelmix_f32_2_3p1_avx(mix, dst, src, n_samples);
+
+		if (mix->upmix != CHANNELMIX_UPMIX_PSD) {
+			vol_avx(d[4], s[0], v4, n_samples);
+			vol_avx(d[5], s[1], v5, n_samples);
+		} else {
+			sub_avx(d[4], s[0], s[1], n_samples);
+
+			delay_convolve_run_avx(mix->buffer[1], &mix->pos[1], BUFFER_SIZE, mix->delay,
+					mix->taps, mix->n_taps, d[5], d[4], -v5, n_samples);
+			delay_convolve_run_avx(mix->buffer[0], &mix->pos[0], BUFFER_SIZE, mix->delay,
+					mix->taps, mix->n_taps, d[4], d[4], v4, n_samples);
+		}
+	}
+}
+
+void
+channelmix_f32_2_7p1_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	const float v4 = mix->matrix[4][0];
+	const float v5 = mix->matrix[5][1];
+	const float v6 = mix->matrix[6][0];
+	const float v7 = mix->matrix[7][1];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		channelmix_f32_2_3p1_avx(mix, dst, src, n_samples);
+
+		vol_avx(d[4], s[0], v4, n_samples);
+		vol_avx(d[5], s[1], v5, n_samples);
+
+		if (mix->upmix != CHANNELMIX_UPMIX_PSD) {
+			vol_avx(d[6], s[0], v6, n_samples);
+			vol_avx(d[7], s[1], v7, n_samples);
+		} else {
+			sub_avx(d[6], s[0], s[1], n_samples);
+
+			delay_convolve_run_avx(mix->buffer[1], &mix->pos[1], BUFFER_SIZE, mix->delay,
+					mix->taps, mix->n_taps, d[7], d[6], -v7, n_samples);
+			delay_convolve_run_avx(mix->buffer[0], &mix->pos[0], BUFFER_SIZE, mix->delay,
+					mix->taps, mix->n_taps, d[6], d[6], v6, n_samples);
+		}
+	}
+}
+
+/* FL+FR+FC+LFE -> FL+FR */
+void
+channelmix_f32_3p1_2_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float m0 = mix->matrix[0][0];
+	const float m1 = mix->matrix[1][1];
+	const float m2 = (mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f;
+	const float m3 = (mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f;
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_avx(d[0], n_samples);
+		clear_avx(d[1], n_samples);
+	}
+	else {
+		const __m256 v0 = _mm256_set1_ps(m0);
+		const __m256 v1 = _mm256_set1_ps(m1);
+		const __m256 clev = _mm256_set1_ps(m2);
+		const __m256 llev = _mm256_set1_ps(m3);
+		__m256 ctr;
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[2], 32) &&
+		    SPA_IS_ALIGNED(s[3], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_mul_ps(_mm256_load_ps(&s[2][n]), clev);
+			ctr = _mm256_fmadd_ps(_mm256_load_ps(&s[3][n]), llev, ctr);
+			_mm256_store_ps(&d[0][n], _mm256_fmadd_ps(_mm256_load_ps(&s[0][n]), v0, ctr));
+			_mm256_store_ps(&d[1][n], _mm256_fmadd_ps(_mm256_load_ps(&s[1][n]), v1, ctr));
+		}
+		for(; n < n_samples; n++) {
+			const float ctr = m2 * s[2][n] + m3 * s[3][n];
+			d[0][n] = s[0][n] * m0 + ctr;
+			d[1][n] = s[1][n] * m1 + ctr;
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR -> FL+FR */
+void
+channelmix_f32_5p1_2_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float clev = (mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f;
+	const float llev = (mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f;
+	const float slev0 = mix->matrix[0][4];
+	const float slev1 = mix->matrix[1][5];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_avx(d[0], n_samples);
+		clear_avx(d[1], n_samples);
+	}
+	else {
+		const __m256 mv0 = _mm256_set1_ps(v0);
+		const __m256 mv1 = _mm256_set1_ps(v1);
+		const __m256 mclev = _mm256_set1_ps(clev);
+		const __m256 mllev = _mm256_set1_ps(llev);
+		const __m256 mslev0 = _mm256_set1_ps(slev0);
+		const __m256 mslev1 = _mm256_set1_ps(slev1);
+		__m256 in, ctr;
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[2], 32) &&
+		    SPA_IS_ALIGNED(s[3], 32) &&
+		    SPA_IS_ALIGNED(s[4], 32) &&
+		    SPA_IS_ALIGNED(s[5], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_mul_ps(_mm256_load_ps(&s[2][n]), mclev);
+			ctr = _mm256_fmadd_ps(_mm256_load_ps(&s[3][n]), mllev, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[4][n]), mslev0, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[0][n]), mv0, in);
+			_mm256_store_ps(&d[0][n], in);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[5][n]), mslev1, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[1][n]), mv1, in);
+			_mm256_store_ps(&d[1][n], in);
+		}
+		for(; n < n_samples; n++) {
+			const float ctr = clev * s[2][n] + llev * s[3][n];
+			d[0][n] = s[0][n] * v0 + ctr + (slev0 * s[4][n]);
+			d[1][n] = s[1][n] * v1 + ctr + (slev1 * s[5][n]);
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR -> FL+FR+FC+LFE*/
+void
+channelmix_f32_5p1_3p1_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n, unrolled, n_dst = mix->dst_chan;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float v4 = mix->matrix[0][4];
+	const float v5 = mix->matrix[1][5];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		const __m256 mv0 = _mm256_set1_ps(v0);
+		const __m256 mv1 = _mm256_set1_ps(v1);
+		const __m256 slev0 = _mm256_set1_ps(v4);
+		const __m256 slev1 = _mm256_set1_ps(v5);
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[4], 32) &&
+		    SPA_IS_ALIGNED(s[5], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			_mm256_store_ps(&d[0][n], _mm256_fmadd_ps(
+					_mm256_load_ps(&s[0][n]), mv0,
+					_mm256_mul_ps(_mm256_load_ps(&s[4][n]), slev0)));
+			_mm256_store_ps(&d[1][n], _mm256_fmadd_ps(
+					_mm256_load_ps(&s[1][n]), mv1,
+					_mm256_mul_ps(_mm256_load_ps(&s[5][n]), slev1)));
+		}
+		for(; n < n_samples; n++) {
+			d[0][n] = s[0][n] * v0 + s[4][n] * v4;
+			d[1][n] = s[1][n] * v1 + s[5][n] * v5;
+		}
+		vol_avx(d[2], s[2], mix->matrix[2][2], n_samples);
+		vol_avx(d[3], s[3], mix->matrix[3][3], n_samples);
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR -> FL+FR+RL+RR*/
+void
+channelmix_f32_5p1_4_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v4 = mix->matrix[2][4];
+	const float v5 = mix->matrix[3][5];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		channelmix_f32_3p1_2_avx(mix, dst, src, n_samples);
+
+		vol_avx(d[2], s[4], v4, n_samples);
+		vol_avx(d[3], s[5], v5, n_samples);
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR+RL+RR -> FL+FR */
+void
+channelmix_f32_7p1_2_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float clev = (mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f;
+	const float llev = (mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f;
+	const float slev0 = mix->matrix[0][4];
+	const float slev1 = mix->matrix[1][5];
+	const float rlev0 = mix->matrix[0][6];
+	const float rlev1 = mix->matrix[1][7];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_avx(d[0], n_samples);
+		clear_avx(d[1], n_samples);
+	}
+	else {
+		const __m256 mv0 = _mm256_set1_ps(v0);
+		const __m256 mv1 = _mm256_set1_ps(v1);
+		const __m256 mclev = _mm256_set1_ps(clev);
+		const __m256 mllev = _mm256_set1_ps(llev);
+		const __m256 mslev0 = _mm256_set1_ps(slev0);
+		const __m256 mslev1 = _mm256_set1_ps(slev1);
+		const __m256 mrlev0 = _mm256_set1_ps(rlev0);
+		const __m256 mrlev1 = _mm256_set1_ps(rlev1);
+		__m256 in, ctr;
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[2], 32) &&
+		    SPA_IS_ALIGNED(s[3], 32) &&
+		    SPA_IS_ALIGNED(s[4], 32) &&
+		    SPA_IS_ALIGNED(s[5], 32) &&
+		    SPA_IS_ALIGNED(s[6], 32) &&
+		    SPA_IS_ALIGNED(s[7], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_mul_ps(_mm256_load_ps(&s[2][n]), mclev);
+			ctr = _mm256_fmadd_ps(_mm256_load_ps(&s[3][n]), mllev, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[4][n]), mslev0, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[6][n]), mrlev0, in);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[0][n]), mv0, in);
+			_mm256_store_ps(&d[0][n], in);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[5][n]), mslev1, ctr);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[7][n]), mrlev1, in);
+			in = _mm256_fmadd_ps(_mm256_load_ps(&s[1][n]), mv1, in);
+			_mm256_store_ps(&d[1][n], in);
+		}
+		for(; n < n_samples; n++) {
+			const float ctr = clev * s[2][n] + llev * s[3][n];
+			d[0][n] = s[0][n] * v0 + ctr + s[4][n] * slev0 + s[6][n] * rlev0;
+			d[1][n] = s[1][n] * v1 + ctr + s[5][n] * slev1 + s[7][n] * rlev1;
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR+RL+RR -> FL+FR+FC+LFE*/
+void
+channelmix_f32_7p1_3p1_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n, unrolled, n_dst = mix->dst_chan;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float v4 = (mix->matrix[0][4] + mix->matrix[0][6]) * 0.5f;
+	const float v5 = (mix->matrix[1][5] + mix->matrix[1][7]) * 0.5f;
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		const __m256 mv0 = _mm256_set1_ps(v0);
+		const __m256 mv1 = _mm256_set1_ps(v1);
+		const __m256 mv4 = _mm256_set1_ps(v4);
+		const __m256 mv5 = _mm256_set1_ps(v5);
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[4], 32) &&
+		    SPA_IS_ALIGNED(s[5], 32) &&
+		    SPA_IS_ALIGNED(s[6], 32) &&
+		    SPA_IS_ALIGNED(s[7], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			_mm256_store_ps(&d[0][n], _mm256_fmadd_ps(
+					_mm256_load_ps(&s[0][n]), mv0,
+					_mm256_mul_ps(_mm256_add_ps(
+							_mm256_load_ps(&s[4][n]),
+							_mm256_load_ps(&s[6][n])), mv4)));
+			_mm256_store_ps(&d[1][n], _mm256_fmadd_ps(
+					_mm256_load_ps(&s[1][n]), mv1,
+					_mm256_mul_ps(_mm256_add_ps(
+							_mm256_load_ps(&s[5][n]),
+							_mm256_load_ps(&s[7][n])), mv5)));
+		}
+		for(; n < n_samples; n++) {
+			d[0][n] = s[0][n] * v0 + (s[4][n] + s[6][n]) * v4;
+			d[1][n] = s[1][n] * v1 + (s[5][n] + s[7][n]) * v5;
+		}
+		vol_avx(d[2], s[2], mix->matrix[2][2], n_samples);
+		vol_avx(d[3], s[3], mix->matrix[3][3], n_samples);
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR+RL+RR -> FL+FR+RL+RR*/
+void
+channelmix_f32_7p1_4_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n, unrolled, n_dst = mix->dst_chan;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float v0 = mix->matrix[0][0];
+	const float v1 = mix->matrix[1][1];
+	const float clev = (mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f;
+	const float llev = (mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f;
+	const float slev0 = mix->matrix[2][4];
+	const float slev1 = mix->matrix[3][5];
+	const float rlev0 = mix->matrix[2][6];
+	const float rlev1 = mix->matrix[3][7];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		for (i = 0; i < n_dst; i++)
+			clear_avx(d[i], n_samples);
+	}
+	else {
+		const __m256 mv0 = _mm256_set1_ps(v0);
+		const __m256 mv1 = _mm256_set1_ps(v1);
+		const __m256 mclev = _mm256_set1_ps(clev);
+		const __m256 mllev = _mm256_set1_ps(llev);
+		const __m256 mslev0 = _mm256_set1_ps(slev0);
+		const __m256 mslev1 = _mm256_set1_ps(slev1);
+		const __m256 mrlev0 = _mm256_set1_ps(rlev0);
+		const __m256 mrlev1 = _mm256_set1_ps(rlev1);
+		__m256 ctr, sl, sr;
+
+		if (SPA_IS_ALIGNED(s[0], 32) &&
+		    SPA_IS_ALIGNED(s[1], 32) &&
+		    SPA_IS_ALIGNED(s[2], 32) &&
+		    SPA_IS_ALIGNED(s[3], 32) &&
+		    SPA_IS_ALIGNED(s[4], 32) &&
+		    SPA_IS_ALIGNED(s[5], 32) &&
+		    SPA_IS_ALIGNED(s[6], 32) &&
+		    SPA_IS_ALIGNED(s[7], 32) &&
+		    SPA_IS_ALIGNED(d[0], 32) &&
+		    SPA_IS_ALIGNED(d[1], 32) &&
+		    SPA_IS_ALIGNED(d[2], 32) &&
+		    SPA_IS_ALIGNED(d[3], 32))
+			unrolled = n_samples & ~7;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_mul_ps(_mm256_load_ps(&s[2][n]), mclev);
+			ctr = _mm256_fmadd_ps(_mm256_load_ps(&s[3][n]), mllev, ctr);
+			sl = _mm256_mul_ps(_mm256_load_ps(&s[4][n]), mslev0);
+			sr = _mm256_mul_ps(_mm256_load_ps(&s[5][n]), mslev1);
+			_mm256_store_ps(&d[0][n], _mm256_fmadd_ps(_mm256_load_ps(&s[0][n]), mv0,
+						_mm256_add_ps(ctr, sl)));
+			_mm256_store_ps(&d[1][n], _mm256_fmadd_ps(_mm256_load_ps(&s[1][n]), mv1,
+						_mm256_add_ps(ctr, sr)));
+			_mm256_store_ps(&d[2][n], _mm256_fmadd_ps(_mm256_load_ps(&s[6][n]), mrlev0, sl));
+			_mm256_store_ps(&d[3][n], _mm256_fmadd_ps(_mm256_load_ps(&s[7][n]), mrlev1, sr));
+		}
+		for(; n < n_samples; n++) {
+			const float ctr = s[2][n] * clev + s[3][n] * llev;
+			const float sl = s[4][n] * slev0;
+			const float sr = s[5][n] * slev1;
+			d[0][n] = s[0][n] * v0 + ctr + sl;
+			d[1][n] = s[1][n] * v1 + ctr + sr;
+			d[2][n] = s[6][n] * rlev0 + sl;
+			d[3][n] = s[7][n] * rlev1 + sr;
+		}
+	}
+}
@@ -0,0 +1,134 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "channelmix-ops.h"
+
+#include <immintrin.h>
+#include <float.h>
+#include <math.h>
+
+static inline void clear_avx512(float *d, uint32_t n_samples)
+{
+	memset(d, 0, n_samples * sizeof(float));
+}
+
+static inline void vol_avx512(float *d, const float *s, float vol, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	if (vol == 0.0f) {
+		clear_avx512(d, n_samples);
+	} else if (vol == 1.0f) {
+		if (d != s)
+			spa_memcpy(d, s, n_samples * sizeof(float));
+	} else {
+		const __m512 v = _mm512_set1_ps(vol);
+
+		unrolled = n_samples & ~15;
+		for(n = 0; n < unrolled; n += 16)
+			_mm512_storeu_ps(&d[n], _mm512_mul_ps(_mm512_loadu_ps(&s[n]), v));
+		for(; n < n_samples; n++)
+			d[n] = s[n] * vol;
+	}
+}
+
+static inline void conv_avx512(float *d, const float **s, float *c, uint32_t n_c, uint32_t n_samples)
+{
+	__m512 mi[n_c], sum[2];
+	uint32_t n, j, unrolled;
+
+	for (j = 0; j < n_c; j++)
+		mi[j] = _mm512_set1_ps(c[j]);
+
+	/* buffers are only aligned to FMT_OPS_MAX_ALIGN, unaligned loads
+	 * on aligned data are as fast as aligned ones on avx512 hardware */
+	unrolled = n_samples & ~31;
+
+	for (n = 0; n < unrolled; n += 32) {
+		sum[0] = _mm512_mul_ps(_mm512_loadu_ps(&s[0][n +  0]), mi[0]);
+		sum[1] = _mm512_mul_ps(_mm512_loadu_ps(&s[0][n + 16]), mi[0]);
+		for (j = 1; j < n_c; j++) {
+			sum[0] = _mm512_fmadd_ps(_mm512_loadu_ps(&s[j][n +  0]), mi[j], sum[0]);
+			sum[1] = _mm512_fmadd_ps(_mm512_loadu_ps(&s[j][n + 16]), mi[j], sum[1]);
+		}
+		_mm512_storeu_ps(&d[n +  0], sum[0]);
+		_mm512_storeu_ps(&d[n + 16], sum[1]);
+	}
+	for (; n < n_samples; n += 16) {
+		__mmask16 m = n_samples - n >= 16 ? 0xffff : (1u << (n_samples - n)) - 1;
+		sum[0] = _mm512_mul_ps(_mm512_maskz_loadu_ps(m, &s[0][n]), mi[0]);
+		for (j = 1; j < n_c; j++)
+			sum[0] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, &s[j][n]), mi[j], sum[0]);
+		_mm512_mask_storeu_ps(&d[n], m, sum[0]);
+	}
+}
+
+/* the filter is recursive over the samples, there is nothing to
+ * vectorize so this is the plain C version */
+static void lr4_process_avx512(struct lr4 *lr4, float *dst, const float *src, const float vol, int samples)
+{
+	float x1 = lr4->x1;
+	float x2 = lr4->x2;
+	float y1 = lr4->y1;
+	float y2 = lr4->y2;
+	float b0 = lr4->bq.b0;
+	float b1 = lr4->bq.b1;
+	float b2 = lr4->bq.b2;
+	float a1 = lr4->bq.a1;
+	float a2 = lr4->bq.a2;
+	float x, y, z;
+	int i;
+
+	if (vol == 0.0f || !lr4->active) {
+		vol_avx512(dst, src, vol, samples);
+		return;
+	}
+
+	for (i = 0; i < samples; i++) {
+		x  = src[i];
+		y  = b0 * x          + x1;
+		x1 = b1 * x - a1 * y + x2;
+		x2 = b2 * x - a2 * y;
+		z  = b0 * y          + y1;
+		y1 = b1 * y - a1 * z + y2;
+		y2 = b2 * y - a2 * z;
+		dst[i] = z * vol;
+	}
+#define F(x) (isnormal(x) ? (x) : 0.0f)
+	lr4->x1 = F(x1);
+	lr4->x2 = F(x2);
+	lr4->y1 = F(y1);
+	lr4->y2 = F(y2);
+#undef F
+}
+
+void
+channelmix_f32_n_m_avx512(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	uint32_t i, j, n_dst = mix->dst_chan, n_src = mix->src_chan;
+
+	for (i = 0; i < n_dst; i++) {
+		float *di = d[i];
+		float mj[n_src];
+		const float *sj[n_src];
+		uint32_t n_j = 0;
+
+		for (j = 0; j < n_src; j++) {
+			if (mix->matrix[i][j] == 0.0f)
+				continue;
+			mj[n_j] = mix->matrix[i][j];
+			sj[n_j++] = s[j];
+		}
+		if (n_j == 0) {
+			clear_avx512(di, n_samples);
+		} else if (n_j == 1) {
+			lr4_process_avx512(&mix->lr4[i], di, sj[0], mj[0], n_samples);
+		} else {
+			conv_avx512(di, sj, mj, n_j, n_samples);
+			lr4_process_avx512(&mix->lr4[i], di, di, 1.0f, n_samples);
+		}
+	}
+}
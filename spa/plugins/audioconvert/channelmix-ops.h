@@ -49,6 +49,7 @@ struct channelmix {
 #define CHANNELMIX_FLAG_IDENTITY	(1<<1)		/**< identity matrix */
 #define CHANNELMIX_FLAG_EQUAL		(1<<2)		/**< all values are equal */
 #define CHANNELMIX_FLAG_COPY		(1<<3)		/**< 1 on diagonal, can be nxm */
+#define CHANNELMIX_FLAG_DIAGONAL	(1<<4)		/**< only the diagonal is used */
 	uint32_t flags;
 	float matrix_orig[SPA_AUDIO_MAX_CHANNELS][SPA_AUDIO_MAX_CHANNELS];
 	float matrix[SPA_AUDIO_MAX_CHANNELS][SPA_AUDIO_MAX_CHANNELS];
@@ -61,7 +62,8 @@ struct channelmix {
 	uint32_t hilbert_taps;				/* to phase shift, 0 disabled */
 	struct lr4 lr4[SPA_AUDIO_MAX_CHANNELS];
 
-	float buffer_mem[2 * BUFFER_SIZE*2 + CHANNELMIX_OPS_MAX_ALIGN/4];
+	/* vector code can write one vector past the end of each delay line */
+	float buffer_mem[2 * (BUFFER_SIZE*2 + CHANNELMIX_OPS_MAX_ALIGN/4) + CHANNELMIX_OPS_MAX_ALIGN/4];
 	float *buffer[2];
 	uint32_t pos[2];
 	uint32_t delay;
@@ -137,5 +139,22 @@ DEFINE_FUNCTION(f32_5p1_3p1, sse);
 DEFINE_FUNCTION(f32_5p1_4, sse);
 DEFINE_FUNCTION(f32_7p1_4, sse);
 #endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+DEFINE_FUNCTION(copy, avx);
+DEFINE_FUNCTION(f32_n_m, avx);
+DEFINE_FUNCTION(f32_2_3p1, avx);
+DEFINE_FUNCTION(f32_2_5p1, avx);
+DEFINE_FUNCTION(f32_2_7p1, avx);
+DEFINE_FUNCTION(f32_3p1_2, avx);
+DEFINE_FUNCTION(f32_5p1_2, avx);
+DEFINE_FUNCTION(f32_5p1_3p1, avx);
+DEFINE_FUNCTION(f32_5p1_4, avx);
+DEFINE_FUNCTION(f32_7p1_2, avx);
+DEFINE_FUNCTION(f32_7p1_3p1, avx);
+DEFINE_FUNCTION(f32_7p1_4, avx);
+#endif
+#if defined (HAVE_AVX512)
+DEFINE_FUNCTION(f32_n_m, avx512);
+#endif
 
 #undef DEFINE_FUNCTION
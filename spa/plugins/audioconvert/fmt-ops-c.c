@@ -76,6 +76,21 @@ void conv_ ##sname## _to_ ##dname## d_c(struct convert *conv,			\
 	}									\
 }
 
+/* same as MAKE_I_TO_D with a gain per channel applied to the result */
+#define MAKE_I_TO_D_GAIN(sname,stype,dname,dtype,func)				\
+void conv_ ##sname## _to_ ##dname## d_gain_c(struct convert *conv,		\
+		void * SPA_RESTRICT dst[], const void * SPA_RESTRICT src[],	\
+		const float *gain, uint32_t n_samples)				\
+{										\
+	const stype *s = src[0];						\
+	dtype **d = (dtype**)dst;						\
+	uint32_t i, j, n_channels = conv->n_channels;				\
+	for (j = 0; j < n_samples; j++) {					\
+		for (i = 0; i < n_channels; i++)				\
+			d[i][j] = func (*s++) * gain[i];			\
+	}									\
+}
+
 #define MAKE_D_TO_I(sname,stype,dname,dtype,func)				\
 void conv_ ##sname## d_to_ ##dname## _c(struct convert *conv,			\
 		void * SPA_RESTRICT dst[], const void * SPA_RESTRICT src[],	\
@@ -110,6 +125,7 @@ MAKE_I_TO_D(u16, uint16_t, f32, float, U16_TO_F32);
 MAKE_D_TO_D(s16, int16_t, f32, float, S16_TO_F32);
 MAKE_I_TO_I(s16, int16_t, f32, float, S16_TO_F32);
 MAKE_I_TO_D(s16, int16_t, f32, float, S16_TO_F32);
+MAKE_I_TO_D_GAIN(s16, int16_t, f32, float, S16_TO_F32);
 MAKE_D_TO_I(s16, int16_t, f32, float, S16_TO_F32);
 MAKE_I_TO_D(s16s, uint16_t, f32, float, S16S_TO_F32);
 
@@ -358,6 +358,39 @@ static struct conv_info conv_table[] =
 };
 #undef MAKE
 
+typedef void (*convert_gain_func_t) (struct convert *conv, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], const float *gain, uint32_t n_samples);
+
+struct conv_gain_info {
+	uint32_t src_fmt;
+	uint32_t dst_fmt;
+	uint32_t n_channels;
+
+	convert_gain_func_t process;
+	const char *name;
+
+	uint32_t cpu_flags;
+};
+
+#define MAKE(fmt1,fmt2,chan,func,...) \
+	{  SPA_AUDIO_FORMAT_ ##fmt1, SPA_AUDIO_FORMAT_ ##fmt2, chan, func, #func , __VA_ARGS__ }
+
+/* conversions with a gain per channel, used to apply the volume
+ * in the same pass as the conversion */
+static struct conv_gain_info conv_gain_table[] =
+{
+#if defined (HAVE_AVX2)
+	MAKE(S16, F32P, 2, conv_s16_to_f32d_2_gain_avx2, SPA_CPU_FLAG_AVX2),
+	MAKE(S16, F32P, 0, conv_s16_to_f32d_gain_avx2, SPA_CPU_FLAG_AVX2),
+#endif
+#if defined (HAVE_SSE2)
+	MAKE(S16, F32P, 2, conv_s16_to_f32d_2_gain_sse2, SPA_CPU_FLAG_SSE2),
+	MAKE(S16, F32P, 0, conv_s16_to_f32d_gain_sse2, SPA_CPU_FLAG_SSE2),
+#endif
+	MAKE(S16, F32P, 0, conv_s16_to_f32d_gain_c),
+};
+#undef MAKE
+
 #define MATCH_CHAN(a,b)		((a) == 0 || (a) == (b))
 #define MATCH_CPU_FLAGS(a,b)	((a) == 0 || ((a) & (b)) == a)
 #define MATCH_DITHER(a,b)	((a) == 0 || ((a) & (b)) == a)
@@ -376,6 +409,19 @@ static const struct conv_info *find_conv_info(uint32_t src_fmt, uint32_t dst_fmt
 	return NULL;
 }
 
+static const struct conv_gain_info *find_conv_gain_info(uint32_t src_fmt, uint32_t dst_fmt,
+		uint32_t n_channels, uint32_t cpu_flags)
+{
+	SPA_FOR_EACH_ELEMENT_VAR(conv_gain_table, c) {
+		if (c->src_fmt == src_fmt &&
+		    c->dst_fmt == dst_fmt &&
+		    MATCH_CHAN(c->n_channels, n_channels) &&
+		    MATCH_CPU_FLAGS(c->cpu_flags, cpu_flags))
+			return c;
+	}
+	return NULL;
+}
+
 typedef void (*noise_func_t) (struct convert *conv, float * noise, uint32_t n_samples);
 
 struct noise_info {
@@ -419,6 +465,7 @@ static const struct noise_info *find_noise_info(uint32_t method,
 static void impl_convert_free(struct convert *conv)
 {
 	conv->process = NULL;
+	conv->process_gain = NULL;
 	free(conv->data);
 	conv->data = NULL;
 }
@@ -490,6 +537,7 @@ static const struct dither_info *find_dither_info(uint32_t method, uint32_t rate
 int convert_init(struct convert *conv)
 {
 	const struct conv_info *info;
+	const struct conv_gain_info *ginfo;
 	const struct dither_info *dinfo;
 	const struct noise_info *ninfo;
 	uint32_t i, conv_flags, data_size[3];
@@ -545,6 +593,10 @@ int convert_init(struct convert *conv)
 	if (info == NULL)
 		return -ENOTSUP;
 
+	/* the gain versions don't dither */
+	ginfo = conv_flags == 0 ? find_conv_gain_info(conv->src_fmt, conv->dst_fmt,
+			conv->n_channels, conv->cpu_flags) : NULL;
+
 	ninfo = find_noise_info(conv->noise_method, conv->cpu_flags);
 	if (ninfo == NULL)
 		return -ENOTSUP;
@@ -571,6 +623,8 @@ int convert_init(struct convert *conv)
 	conv->cpu_flags = info->cpu_flags;
 	conv->update_noise = ninfo->noise;
 	conv->process = info->process;
+	conv->process_gain = ginfo ? ginfo->process : NULL;
+	conv->gain_func_name = ginfo ? ginfo->name : NULL;
 	conv->free = impl_convert_free;
 	conv->func_name = info->name;
 
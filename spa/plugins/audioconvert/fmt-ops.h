@@ -241,6 +241,10 @@ struct convert {
 	void (*update_noise) (struct convert *conv, float *noise, uint32_t n_samples);
 	void (*process) (struct convert *conv, void * SPA_RESTRICT dst[], const void * SPA_RESTRICT src[],
 			uint32_t n_samples);
+	/** convert and apply a gain per channel, NULL when not available */
+	void (*process_gain) (struct convert *conv, void * SPA_RESTRICT dst[], const void * SPA_RESTRICT src[],
+			const float *gain, uint32_t n_samples);
+	const char *gain_func_name;
 	void (*free) (struct convert *conv);
 
 	void *data;
@@ -278,6 +282,7 @@ static inline uint32_t dither_method_from_label(const char *label)
 
 #define convert_update_noise(conv,...)	(conv)->update_noise(conv, __VA_ARGS__)
 #define convert_process(conv,...)	(conv)->process(conv, __VA_ARGS__)
+#define convert_process_gain(conv,...)	(conv)->process_gain(conv, __VA_ARGS__)
 #define convert_free(conv)		(conv)->free(conv)
 
 #define DEFINE_NOISE_FUNCTION(name,arch)				\
@@ -490,3 +495,19 @@ DEFINE_FUNCTION(f32d_to_s16, avx2);
 #endif
 
 #undef DEFINE_FUNCTION
+
+#define DEFINE_GAIN_FUNCTION(name,arch)						\
+void conv_##name##_gain_##arch(struct convert *conv, void * SPA_RESTRICT dst[],	\
+		const void * SPA_RESTRICT src[], const float *gain, uint32_t n_samples)
+
+DEFINE_GAIN_FUNCTION(s16_to_f32d, c);
+#if defined(HAVE_SSE2)
+DEFINE_GAIN_FUNCTION(s16_to_f32d_2, sse2);
+DEFINE_GAIN_FUNCTION(s16_to_f32d, sse2);
+#endif
+#if defined(HAVE_AVX2)
+DEFINE_GAIN_FUNCTION(s16_to_f32d_2, avx2);
+DEFINE_GAIN_FUNCTION(s16_to_f32d, avx2);
+#endif
+
+#undef DEFINE_GAIN_FUNCTION
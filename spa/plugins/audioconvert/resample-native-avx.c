@@ -70,5 +70,118 @@ static inline void inner_product_ip_avx(float *d, const float * SPA_RESTRICT s,
 	_mm_store_ss(d, sx[0]);
 }
 
-MAKE_RESAMPLER_FULL(avx);
-MAKE_RESAMPLER_INTER(avx);
+#define FMADD_4(a,o,ty)							\
+	a[0] = _mm256_fmadd_ps(_mm256_loadu_ps(s0 + (o)), ty, a[0]);	\
+	a[1] = _mm256_fmadd_ps(_mm256_loadu_ps(s1 + (o)), ty, a[1]);	\
+	a[2] = _mm256_fmadd_ps(_mm256_loadu_ps(s2 + (o)), ty, a[2]);	\
+	a[3] = _mm256_fmadd_ps(_mm256_loadu_ps(s3 + (o)), ty, a[3]);
+
+/* the same as inner_product_avx for 4 channels, the taps are loaded
+ * once for all channels and the sums are done in the same order so
+ * that the result is identical. */
+static inline void inner_product_4_avx(float **d, uint32_t o,
+		const float **s, uint32_t index,
+		const float * SPA_RESTRICT taps, uint32_t n_taps)
+{
+	const float *s0 = s[0] + index, *s1 = s[1] + index;
+	const float *s2 = s[2] + index, *s3 = s[3] + index;
+	__m256 sa[4], sb[4], ty;
+	__m128 sx[4], sy[4], tx;
+	uint32_t i = 0, c;
+	uint32_t n_taps4 = n_taps & ~0xf;
+
+	for (c = 0; c < 4; c++)
+		sa[c] = sb[c] = _mm256_setzero_ps();
+
+	for (; i < n_taps4; i += 16) {
+		ty = _mm256_load_ps(taps + i + 0);
+		FMADD_4(sa, i + 0, ty);
+		ty = _mm256_load_ps(taps + i + 8);
+		FMADD_4(sb, i + 8, ty);
+	}
+	for (c = 0; c < 4; c++) {
+		sa[c] = _mm256_add_ps(sb[c], sa[c]);
+		sx[c] = _mm256_extractf128_ps(sa[c], 0);
+		sy[c] = _mm256_extractf128_ps(sa[c], 1);
+	}
+	for (; i < n_taps; i += 8) {
+		tx = _mm_load_ps(taps + i + 0);
+		sx[0] = _mm_fmadd_ps(_mm_loadu_ps(s0 + i), tx, sx[0]);
+		sx[1] = _mm_fmadd_ps(_mm_loadu_ps(s1 + i), tx, sx[1]);
+		sx[2] = _mm_fmadd_ps(_mm_loadu_ps(s2 + i), tx, sx[2]);
+		sx[3] = _mm_fmadd_ps(_mm_loadu_ps(s3 + i), tx, sx[3]);
+		tx = _mm_load_ps(taps + i + 4);
+		sy[0] = _mm_fmadd_ps(_mm_loadu_ps(s0 + i + 4), tx, sy[0]);
+		sy[1] = _mm_fmadd_ps(_mm_loadu_ps(s1 + i + 4), tx, sy[1]);
+		sy[2] = _mm_fmadd_ps(_mm_loadu_ps(s2 + i + 4), tx, sy[2]);
+		sy[3] = _mm_fmadd_ps(_mm_loadu_ps(s3 + i + 4), tx, sy[3]);
+	}
+	for (c = 0; c < 4; c++) {
+		sx[c] = _mm_add_ps(sx[c], sy[c]);
+		sx[c] = _mm_hadd_ps(sx[c], sx[c]);
+		sx[c] = _mm_hadd_ps(sx[c], sx[c]);
+		_mm_store_ss(&d[c][o], sx[c]);
+	}
+}
+
+static inline void inner_product_ip_4_avx(float **d, uint32_t o,
+	const float **s, uint32_t index,
+	const float * SPA_RESTRICT t0, const float * SPA_RESTRICT t1, float x,
+	uint32_t n_taps)
+{
+	const float *s0 = s[0] + index, *s1 = s[1] + index;
+	const float *s2 = s[2] + index, *s3 = s[3] + index;
+	__m256 sa[4], sb[4], ty[4], tf[2];
+	__m128 sx[4], sy[4], tx[4], tg[2];
+	uint32_t i, c, n_taps4 = n_taps & ~0xf;
+
+	for (c = 0; c < 4; c++)
+		sa[c] = sb[c] = _mm256_setzero_ps();
+
+	for (i = 0; i < n_taps4; i += 8) {
+		tf[0] = _mm256_load_ps(t0 + i);
+		tf[1] = _mm256_load_ps(t1 + i);
+		ty[0] = _mm256_loadu_ps(s0 + i);
+		ty[1] = _mm256_loadu_ps(s1 + i);
+		ty[2] = _mm256_loadu_ps(s2 + i);
+		ty[3] = _mm256_loadu_ps(s3 + i);
+		sa[0] = _mm256_fmadd_ps(ty[0], tf[0], sa[0]);
+		sa[1] = _mm256_fmadd_ps(ty[1], tf[0], sa[1]);
+		sa[2] = _mm256_fmadd_ps(ty[2], tf[0], sa[2]);
+		sa[3] = _mm256_fmadd_ps(ty[3], tf[0], sa[3]);
+		sb[0] = _mm256_fmadd_ps(ty[0], tf[1], sb[0]);
+		sb[1] = _mm256_fmadd_ps(ty[1], tf[1], sb[1]);
+		sb[2] = _mm256_fmadd_ps(ty[2], tf[1], sb[2]);
+		sb[3] = _mm256_fmadd_ps(ty[3], tf[1], sb[3]);
+	}
+	for (c = 0; c < 4; c++) {
+		sx[c] = _mm_add_ps(_mm256_extractf128_ps(sa[c], 0), _mm256_extractf128_ps(sa[c], 1));
+		sy[c] = _mm_add_ps(_mm256_extractf128_ps(sb[c], 0), _mm256_extractf128_ps(sb[c], 1));
+	}
+	for (; i < n_taps; i += 4) {
+		tg[0] = _mm_load_ps(t0 + i);
+		tg[1] = _mm_load_ps(t1 + i);
+		tx[0] = _mm_loadu_ps(s0 + i);
+		tx[1] = _mm_loadu_ps(s1 + i);
+		tx[2] = _mm_loadu_ps(s2 + i);
+		tx[3] = _mm_loadu_ps(s3 + i);
+		sx[0] = _mm_fmadd_ps(tx[0], tg[0], sx[0]);
+		sx[1] = _mm_fmadd_ps(tx[1], tg[0], sx[1]);
+		sx[2] = _mm_fmadd_ps(tx[2], tg[0], sx[2]);
+		sx[3] = _mm_fmadd_ps(tx[3], tg[0], sx[3]);
+		sy[0] = _mm_fmadd_ps(tx[0], tg[1], sy[0]);
+		sy[1] = _mm_fmadd_ps(tx[1], tg[1], sy[1]);
+		sy[2] = _mm_fmadd_ps(tx[2], tg[1], sy[2]);
+		sy[3] = _mm_fmadd_ps(tx[3], tg[1], sy[3]);
+	}
+	for (c = 0; c < 4; c++) {
+		sy[c] = _mm_mul_ps(_mm_sub_ps(sy[c], sx[c]), _mm_load1_ps(&x));
+		sx[c] = _mm_add_ps(sx[c], sy[c]);
+		sx[c] = _mm_hadd_ps(sx[c], sx[c]);
+		sx[c] = _mm_hadd_ps(sx[c], sx[c]);
+		_mm_store_ss(&d[c][o], sx[c]);
+	}
+}
+
+MAKE_RESAMPLER_FULL_4(avx);
+MAKE_RESAMPLER_INTER_4(avx);
@@ -0,0 +1,136 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "resample-native-impl.h"
+
+#include <assert.h>
+#include <immintrin.h>
+
+/* n_taps is a multiple of 8 and the filter rows are 64 bytes aligned,
+ * the last 8 taps are handled with a masked load */
+#define TAIL_MASK(n)	((n) >= 16 ? 0xffff : 0x00ff)
+
+static inline void inner_product_avx512(float *d, const float * SPA_RESTRICT s,
+		const float * SPA_RESTRICT taps, uint32_t n_taps)
+{
+	__m512 sz[2] = { _mm512_setzero_ps(), _mm512_setzero_ps() };
+	uint32_t i = 0;
+	uint32_t n_taps32 = n_taps & ~0x1f;
+
+	for (; i < n_taps32; i += 32) {
+		sz[0] = _mm512_fmadd_ps(_mm512_loadu_ps(s + i + 0),
+				_mm512_load_ps(taps + i + 0), sz[0]);
+		sz[1] = _mm512_fmadd_ps(_mm512_loadu_ps(s + i + 16),
+				_mm512_load_ps(taps + i + 16), sz[1]);
+	}
+	for (; i < n_taps; i += 16) {
+		__mmask16 m = TAIL_MASK(n_taps - i);
+		sz[0] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s + i),
+				_mm512_maskz_load_ps(m, taps + i), sz[0]);
+	}
+	*d = _mm512_reduce_add_ps(_mm512_add_ps(sz[0], sz[1]));
+}
+
+static inline void inner_product_ip_avx512(float *d, const float * SPA_RESTRICT s,
+	const float * SPA_RESTRICT t0, const float * SPA_RESTRICT t1, float x,
+	uint32_t n_taps)
+{
+	__m512 sz[2] = { _mm512_setzero_ps(), _mm512_setzero_ps() }, tz;
+	uint32_t i;
+	float sum[2];
+
+	for (i = 0; i < n_taps; i += 16) {
+		__mmask16 m = TAIL_MASK(n_taps - i);
+		tz = _mm512_maskz_loadu_ps(m, s + i);
+		sz[0] = _mm512_fmadd_ps(tz, _mm512_maskz_load_ps(m, t0 + i), sz[0]);
+		sz[1] = _mm512_fmadd_ps(tz, _mm512_maskz_load_ps(m, t1 + i), sz[1]);
+	}
+	sum[0] = _mm512_reduce_add_ps(sz[0]);
+	sum[1] = _mm512_reduce_add_ps(sz[1]);
+	*d = (sum[1] - sum[0]) * x + sum[0];
+}
+
+#define FMADD_4(a,m,o,tz)								\
+	a[0] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s0 + (o)), tz, a[0]);	\
+	a[1] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s1 + (o)), tz, a[1]);	\
+	a[2] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s2 + (o)), tz, a[2]);	\
+	a[3] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, s3 + (o)), tz, a[3]);
+
+/* the same as inner_product_avx512 for 4 channels, the taps are loaded
+ * once for all channels and the sums are done in the same order so
+ * that the result is identical. */
+static inline void inner_product_4_avx512(float **d, uint32_t o,
+		const float **s, uint32_t index,
+		const float * SPA_RESTRICT taps, uint32_t n_taps)
+{
+	const float *s0 = s[0] + index, *s1 = s[1] + index;
+	const float *s2 = s[2] + index, *s3 = s[3] + index;
+	__m512 sa[4], sb[4], tz;
+	uint32_t i = 0;
+	uint32_t n_taps32 = n_taps & ~0x1f;
+
+	sa[0] = sa[1] = sa[2] = sa[3] = _mm512_setzero_ps();
+	sb[0] = sb[1] = sb[2] = sb[3] = _mm512_setzero_ps();
+
+	for (; i < n_taps32; i += 32) {
+		tz = _mm512_load_ps(taps + i + 0);
+		FMADD_4(sa, 0xffff, i + 0, tz);
+		tz = _mm512_load_ps(taps + i + 16);
+		FMADD_4(sb, 0xffff, i + 16, tz);
+	}
+	for (; i < n_taps; i += 16) {
+		__mmask16 m = TAIL_MASK(n_taps - i);
+		tz = _mm512_maskz_load_ps(m, taps + i);
+		FMADD_4(sa, m, i, tz);
+	}
+	d[0][o] = _mm512_reduce_add_ps(_mm512_add_ps(sa[0], sb[0]));
+	d[1][o] = _mm512_reduce_add_ps(_mm512_add_ps(sa[1], sb[1]));
+	d[2][o] = _mm512_reduce_add_ps(_mm512_add_ps(sa[2], sb[2]));
+	d[3][o] = _mm512_reduce_add_ps(_mm512_add_ps(sa[3], sb[3]));
+}
+
+static inline void inner_product_ip_4_avx512(float **d, uint32_t o,
+	const float **s, uint32_t index,
+	const float * SPA_RESTRICT t0, const float * SPA_RESTRICT t1, float x,
+	uint32_t n_taps)
+{
+	const float *s0 = s[0] + index, *s1 = s[1] + index;
+	const float *s2 = s[2] + index, *s3 = s[3] + index;
+	__m512 sa[4], sb[4], tz[4], tf[2];
+	uint32_t i;
+	float sum[2];
+
+	sa[0] = sa[1] = sa[2] = sa[3] = _mm512_setzero_ps();
+	sb[0] = sb[1] = sb[2] = sb[3] = _mm512_setzero_ps();
+
+	for (i = 0; i < n_taps; i += 16) {
+		__mmask16 m = TAIL_MASK(n_taps - i);
+		tf[0] = _mm512_maskz_load_ps(m, t0 + i);
+		tf[1] = _mm512_maskz_load_ps(m, t1 + i);
+		tz[0] = _mm512_maskz_loadu_ps(m, s0 + i);
+		tz[1] = _mm512_maskz_loadu_ps(m, s1 + i);
+		tz[2] = _mm512_maskz_loadu_ps(m, s2 + i);
+		tz[3] = _mm512_maskz_loadu_ps(m, s3 + i);
+		sa[0] = _mm512_fmadd_ps(tz[0], tf[0], sa[0]);
+		sa[1] = _mm512_fmadd_ps(tz[1], tf[0], sa[1]);
+		sa[2] = _mm512_fmadd_ps(tz[2], tf[0], sa[2]);
+		sa[3] = _mm512_fmadd_ps(tz[3], tf[0], sa[3]);
+		sb[0] = _mm512_fmadd_ps(tz[0], tf[1], sb[0]);
+		sb[1] = _mm512_fmadd_ps(tz[1], tf[1], sb[1]);
+		sb[2] = _mm512_fmadd_ps(tz[2], tf[1], sb[2]);
+		sb[3] = _mm512_fmadd_ps(tz[3], tf[1], sb[3]);
+	}
+#define INTERP(c)						\
+	sum[0] = _mm512_reduce_add_ps(sa[c]);			\
+	sum[1] = _mm512_reduce_add_ps(sb[c]);			\
+	d[c][o] = (sum[1] - sum[0]) * x + sum[0];
+	INTERP(0);
+	INTERP(1);
+	INTERP(2);
+	INTERP(3);
+#undef INTERP
+}
+
+MAKE_RESAMPLER_FULL_4(avx512);
+MAKE_RESAMPLER_INTER_4(avx512);
@@ -37,7 +37,8 @@ struct native_data {
 	uint32_t hist;
 	float **history;
 	resample_func_t func;
-	float *filter;
+	const float *filter;
+	struct native_filter *shared_filter;
 	float *hist_mem;
 	const struct resample_info *info;
 };
@@ -91,7 +92,7 @@ DEFINE_RESAMPLER(full,arch)							\
 	index = ioffs;								\
 	phase = (uint32_t)data->phase;						\
 	for (o = ooffs; o < olen && index + n_taps <= ilen; o++) {		\
-		float *filter = &data->filter[phase * stride];			\
+		const float *filter = &data->filter[phase * stride];	\
 		for (c = 0; c < ch; c++) {					\
 			const float *s = src[c];				\
 			float *d = dst[c];					\
@@ -121,8 +122,8 @@ DEFINE_RESAMPLER(inter,arch)							\
 	for (o = ooffs; o < olen && index + n_taps <= ilen; o++) {		\
 		float ph = phase * n_phases / out_rate;				\
 		uint32_t offset = (uint32_t)floorf(ph);				\
-		float *filter0 = &data->filter[(offset+0) * stride];		\
-		float *filter1 = &data->filter[(offset+1) * stride];		\
+		const float *filter0 = &data->filter[(offset+0) * stride]; \
+		const float *filter1 = &data->filter[(offset+1) * stride]; \
 		float pho = ph - offset;					\
 		for (c = 0; c < ch; c++) {					\
 			const float *s = src[c];				\
@@ -137,6 +138,69 @@ DEFINE_RESAMPLER(inter,arch)							\
 	data->phase = phase;							\
 }
 
+/* same as MAKE_RESAMPLER_FULL but evaluates the phase for 4 channels in
+ * one pass over the filter taps with inner_product_4_##arch */
+#define MAKE_RESAMPLER_FULL_4(arch)						\
+DEFINE_RESAMPLER(full,arch)							\
+{										\
+	struct native_data *data = r->data;					\
+	uint32_t n_taps = data->n_taps, stride = data->filter_stride_os;	\
+	uint32_t index, phase, n_phases = data->out_rate;			\
+	uint32_t c, o, olen = *out_len, ilen = *in_len;				\
+	uint32_t inc = data->inc, frac = data->frac, ch = r->channels;		\
+	const float **s = (const float **)src;					\
+	float **d = (float **)dst;						\
+										\
+	index = ioffs;								\
+	phase = (uint32_t)data->phase;						\
+	for (o = ooffs; o < olen && index + n_taps <= ilen; o++) {		\
+		const float *filter = &data->filter[phase * stride];	\
+		for (c = 0; c + 4 <= ch; c += 4)				\
+			inner_product_4_##arch(&d[c], o, &s[c], index,		\
+					filter, n_taps);			\
+		for (; c < ch; c++)						\
+			inner_product_##arch(&d[c][o], &s[c][index],		\
+					filter, n_taps);			\
+		INC(index, phase, n_phases);					\
+	}									\
+	*in_len = index;							\
+	*out_len = o;								\
+	data->phase = phase;							\
+}
+
+#define MAKE_RESAMPLER_INTER_4(arch)						\
+DEFINE_RESAMPLER(inter,arch)							\
+{										\
+	struct native_data *data = r->data;					\
+	uint32_t index, stride = data->filter_stride;				\
+	uint32_t n_phases = data->n_phases, out_rate = data->out_rate;		\
+	uint32_t n_taps = data->n_taps;						\
+	uint32_t c, o, olen = *out_len, ilen = *in_len;				\
+	uint32_t inc = data->inc, frac = data->frac, ch = r->channels;          \
+	const float **s = (const float **)src;					\
+	float **d = (float **)dst;						\
+	float phase;								\
+										\
+	index = ioffs;								\
+	phase = data->phase;							\
+	for (o = ooffs; o < olen && index + n_taps <= ilen; o++) {		\
+		float ph = phase * n_phases / out_rate;				\
+		uint32_t offset = (uint32_t)floorf(ph);				\
+		const float *filter0 = &data->filter[(offset+0) * stride]; \
+		const float *filter1 = &data->filter[(offset+1) * stride]; \
+		float pho = ph - offset;					\
+		for (c = 0; c + 4 <= ch; c += 4)				\
+			inner_product_ip_4_##arch(&d[c], o, &s[c], index,	\
+					filter0, filter1, pho, n_taps);		\
+		for (; c < ch; c++)						\
+			inner_product_ip_##arch(&d[c][o], &s[c][index],	\
+					filter0, filter1, pho, n_taps);		\
+		INC(index, phase, out_rate);					\
+	}									\
+	*in_len = index;							\
+	*out_len = o;								\
+	data->phase = phase;							\
+}
 
 DEFINE_RESAMPLER(copy,c);
 DEFINE_RESAMPLER(full,c);
@@ -158,3 +222,7 @@ DEFINE_RESAMPLER(inter,ssse3);
 DEFINE_RESAMPLER(full,avx);
 DEFINE_RESAMPLER(inter,avx);
 #endif
+#if defined (HAVE_AVX512)
+DEFINE_RESAMPLER(full,avx512);
+DEFINE_RESAMPLER(inter,avx512);
+#endif
@@ -3,8 +3,10 @@
 /* SPDX-License-Identifier: MIT */
 
 #include <errno.h>
+#include <pthread.h>
 
 #include <spa/param/audio/format.h>
+#include <spa/utils/list.h>
 
 #include "resample-native-impl.h"
 #ifndef RESAMPLE_DISABLE_PRECOMP
@@ -82,6 +84,90 @@ static int build_filter(float *taps, uint32_t stride, uint32_t n_taps, uint32_t
 	return 0;
 }
 
+/* The filter only depends on the reduced rates and the quality and all
+ * implementations use the same layout, so the taps are shared between
+ * all resamplers in the process. Precomputed taps are used directly from
+ * the read-only data of the library. */
+struct native_filter {
+	struct spa_list link;
+	int ref;
+	uint32_t in_rate;
+	uint32_t out_rate;
+	int quality;
+	const float *taps;
+};
+
+static pthread_mutex_t filter_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct spa_list filter_list = { &filter_list, &filter_list };
+
+static struct native_filter *native_filter_ref(struct resample *r,
+		uint32_t in_rate, uint32_t out_rate, uint32_t stride,
+		uint32_t n_taps, uint32_t n_phases, double cutoff)
+{
+	struct native_filter *f;
+	const float *precomp = NULL;
+	uint32_t filter_size = stride * sizeof(float) * (n_phases + 1);
+
+	pthread_mutex_lock(&filter_lock);
+	spa_list_for_each(f, &filter_list, link) {
+		if (f->in_rate == in_rate &&
+		    f->out_rate == out_rate &&
+		    f->quality == r->quality) {
+			f->ref++;
+			spa_log_debug(r->log, "native %p: shared filter %p ref:%d",
+					r, f, f->ref);
+			goto done;
+		}
+	}
+
+#ifndef RESAMPLE_DISABLE_PRECOMP
+	/* See if we have precomputed coefficients */
+	for (uint32_t i = 0; precomp_coeffs[i].filter; i++) {
+		if (precomp_coeffs[i].in_rate == r->i_rate &&
+		    precomp_coeffs[i].out_rate == r->o_rate &&
+		    precomp_coeffs[i].quality == r->quality) {
+			precomp = precomp_coeffs[i].filter;
+			break;
+		}
+	}
+#endif
+	if (precomp) {
+		spa_log_debug(r->log, "using precomputed filter for %u->%u(%u)",
+				r->i_rate, r->o_rate, r->quality);
+		f = calloc(1, sizeof(struct native_filter));
+		if (f != NULL)
+			f->taps = precomp;
+	} else {
+		f = calloc(1, sizeof(struct native_filter) + filter_size + 64);
+		if (f != NULL) {
+			float *taps = SPA_PTROFF_ALIGN(f, sizeof(struct native_filter), 64, float);
+			build_filter(taps, stride, n_taps, n_phases, cutoff);
+			f->taps = taps;
+		}
+	}
+	if (f == NULL)
+		goto done;
+
+	f->ref = 1;
+	f->in_rate = in_rate;
+	f->out_rate = out_rate;
+	f->quality = r->quality;
+	spa_list_append(&filter_list, &f->link);
+done:
+	pthread_mutex_unlock(&filter_lock);
+	return f;
+}
+
+static void native_filter_unref(struct native_filter *f)
+{
+	pthread_mutex_lock(&filter_lock);
+	if (--f->ref == 0) {
+		spa_list_remove(&f->link);
+		free(f);
+	}
+	pthread_mutex_unlock(&filter_lock);
+}
+
 MAKE_RESAMPLER_COPY(c);
 
 #define MAKE(fmt,copy,full,inter,...) \
@@ -93,6 +179,9 @@ static struct resample_info resample_table[] =
 #if defined (HAVE_NEON)
 	MAKE(F32, copy_c, full_neon, inter_neon, SPA_CPU_FLAG_NEON),
 #endif
+#if defined(HAVE_AVX512)
+	MAKE(F32, copy_c, full_avx512, inter_avx512, SPA_CPU_FLAG_AVX512),
+#endif
 #if defined(HAVE_AVX) && defined(HAVE_FMA)
 	MAKE(F32, copy_c, full_avx, inter_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
 #endif
@@ -119,7 +208,11 @@ static const struct resample_info *find_resample_info(uint32_t format, uint32_t
 
 static void impl_native_free(struct resample *r)
 {
+	struct native_data *d = r->data;
+
 	spa_log_debug(r->log, "native %p: free", r);
+	if (d && d->shared_filter)
+		native_filter_unref(d->shared_filter);
 	free(r->data);
 	r->data = NULL;
 }
@@ -342,7 +435,7 @@ int resample_native_init(struct resample *r)
 	struct native_data *d;
 	const struct quality *q;
 	double scale;
-	uint32_t c, n_taps, n_phases, filter_size, in_rate, out_rate, gcd, filter_stride;
+	uint32_t c, n_taps, n_phases, in_rate, out_rate, gcd, filter_stride;
 	uint32_t history_stride, history_size, oversample;
 
 	r->quality = SPA_CLAMP(r->quality, 0, (int) SPA_N_ELEMENTS(window_qualities) - 1);
@@ -375,12 +468,10 @@ int resample_native_init(struct resample *r)
 	n_phases *= oversample;
 
 	filter_stride = SPA_ROUND_UP_N(n_taps * sizeof(float), 64);
-	filter_size = filter_stride * (n_phases + 1);
 	history_stride = SPA_ROUND_UP_N(2 * n_taps * sizeof(float), 64);
 	history_size = r->channels * history_stride;
 
 	d = calloc(1, sizeof(struct native_data) +
-			filter_size +
 			history_size +
 			(r->channels * sizeof(float*)) +
 			64);
@@ -393,33 +484,21 @@ int resample_native_init(struct resample *r)
 	d->n_phases = n_phases;
 	d->in_rate = in_rate;
 	d->out_rate = out_rate;
-	d->filter = SPA_PTROFF_ALIGN(d, sizeof(struct native_data), 64, float);
-	d->hist_mem = SPA_PTROFF_ALIGN(d->filter, filter_size, 64, float);
+	d->hist_mem = SPA_PTROFF_ALIGN(d, sizeof(struct native_data), 64, float);
 	d->history = SPA_PTROFF(d->hist_mem, history_size, float*);
 	d->filter_stride = filter_stride / sizeof(float);
 	d->filter_stride_os = d->filter_stride * oversample;
 	for (c = 0; c < r->channels; c++)
 		d->history[c] = SPA_PTROFF(d->hist_mem, c * history_stride, float);
 
-#ifndef RESAMPLE_DISABLE_PRECOMP
-	/* See if we have precomputed coefficients */
-	for (c = 0; precomp_coeffs[c].filter; c++) {
-		if (precomp_coeffs[c].in_rate == r->i_rate &&
-				precomp_coeffs[c].out_rate == r->o_rate &&
-				precomp_coeffs[c].quality == r->quality)
-			break;
+	d->shared_filter = native_filter_ref(r, in_rate, out_rate,
+			d->filter_stride, n_taps, n_phases, scale);
+	if (d->shared_filter == NULL) {
+		free(d);
+		r->data = NULL;
+		return -ENOMEM;
 	}
-
-	if (precomp_coeffs[c].filter) {
-		spa_log_debug(r->log, "using precomputed filter for %u->%u(%u)",
-				r->i_rate, r->o_rate, r->quality);
-		spa_memcpy(d->filter, precomp_coeffs[c].filter, filter_size);
-	} else {
-#endif
-		build_filter(d->filter, d->filter_stride, n_taps, n_phases, scale);
-#ifndef RESAMPLE_DISABLE_PRECOMP
-	}
-#endif
+	d->filter = d->shared_filter->taps;
 
 	d->info = find_resample_info(SPA_AUDIO_FORMAT_F32, r->cpu_flags);
 	if (SPA_UNLIKELY(d->info == NULL)) {
@@ -75,6 +75,7 @@ static void dump_header(void)
 	printf("/* This is a generated file, see spa-resample-dump-coeffs.c */");
 	printf("\n#include <stdint.h>\n");
 	printf("\n#include <stdlib.h>\n");
+	printf("\n#include <spa/utils/defs.h>\n");
 	printf("\n");
 	printf("struct resample_coeffs {\n");
 	printf("\tuint32_t in_rate;\n");
@@ -122,7 +123,9 @@ static void dump_coeffs(unsigned int in_rate, unsigned int out_rate, int quality
 	filter_size = d->filter_stride * (d->n_phases + 1);
 
 	printf("\n");
-	printf("static const float %s_%u_%u_%u[] = {", PREFIX, in_rate, out_rate, quality);
+	/* the taps are used in place by the resampler and need the same
+	 * alignment as the filters it builds */
+	printf("static const float %s_%u_%u_%u[] SPA_ALIGNED(64) = {", PREFIX, in_rate, out_rate, quality);
 	for (i = 0; i < filter_size; i++) {
 		printf("%a", d->filter[i]);
 		if (i != filter_size - 1)
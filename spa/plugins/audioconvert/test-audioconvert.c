@@ -1116,6 +1116,94 @@ static int test_convert_remap_conv(struct context *ctx)
 	return 0;
 }
 
+static int set_channel_volumes(struct context *ctx, uint32_t n_volumes, const float *volumes)
+{
+	struct spa_pod_builder b = { 0 };
+	uint8_t buffer[1024];
+	struct spa_pod *param;
+
+	spa_pod_builder_init(&b, buffer, sizeof(buffer));
+	param = spa_pod_builder_add_object(&b,
+		SPA_TYPE_OBJECT_Props, SPA_PARAM_Props,
+		SPA_PROP_channelVolumes,	SPA_POD_Array(sizeof(float), SPA_TYPE_Float,
+							n_volumes, volumes));
+	return spa_node_set_param(ctx->convert_node, SPA_PARAM_Props, 0, param);
+}
+
+#define N_BLOCK_SAMPLES	1037
+
+/* more samples than the block size and a volume, the volume is applied while
+ * converting the input and the output conversion runs in blocks */
+static int test_convert_volume_blocks(struct context *ctx)
+{
+	static int16_t s16[N_BLOCK_SAMPLES * 2];
+	static float f32p[2][N_BLOCK_SAMPLES], f32p_vol[2][N_BLOCK_SAMPLES];
+	static float f32p_unity[2][N_BLOCK_SAMPLES];
+	static int16_t s16_vol[N_BLOCK_SAMPLES * 2];
+	static const float volumes[] = { 0.5f, 0.25f }, unity[] = { 1.0f, 1.0f };
+	uint32_t i;
+
+	for (i = 0; i < N_BLOCK_SAMPLES; i++) {
+		int16_t v = (int16_t)((i * 37) % 4000) - 2000;
+
+		s16[2 * i + 0] = v;
+		s16[2 * i + 1] = -v;
+		/* all values are exact so that the result does not depend on
+		 * the rounding of the implementation */
+		f32p_unity[0][i] = v / 32768.0f;
+		f32p_unity[1][i] = -v / 32768.0f;
+		f32p_vol[0][i] = v / 32768.0f * volumes[0];
+		f32p_vol[1][i] = -v / 32768.0f * volumes[1];
+		f32p[0][i] = v * 4 / 32768.0f;
+		f32p[1][i] = -v * 4 / 32768.0f;
+		s16_vol[2 * i + 0] = (int16_t)(v * 4 * volumes[0]);
+		s16_vol[2 * i + 1] = (int16_t)(-v * 4 * volumes[1]);
+	}
+
+	struct data conv_s16 = {
+		.mode = SPA_PARAM_PORT_CONFIG_MODE_convert,
+		.info = SPA_AUDIO_INFO_RAW_INIT(
+			.format = SPA_AUDIO_FORMAT_S16,
+			.rate = 48000,
+			.channels = 2,
+			.position = { SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR }),
+		.ports = 1,
+		.planes = 1,
+		.data = { s16 },
+		.size = sizeof(s16)
+	};
+	struct data dsp_vol = {
+		.mode = SPA_PARAM_PORT_CONFIG_MODE_dsp,
+		.info = SPA_AUDIO_INFO_RAW_INIT(
+			.format = SPA_AUDIO_FORMAT_F32,
+			.rate = 48000,
+			.channels = 2,
+			.position = { SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR }),
+		.ports = 2,
+		.planes = 1,
+		.data = { f32p_vol[0], f32p_vol[1] },
+		.size = sizeof(f32p_vol[0])
+	};
+	struct data dsp = dsp_vol, dsp_unity = dsp_vol;
+	struct data conv_s16_vol = conv_s16;
+
+	dsp.data[0] = f32p[0];
+	dsp.data[1] = f32p[1];
+	dsp_unity.data[0] = f32p_unity[0];
+	dsp_unity.data[1] = f32p_unity[1];
+	conv_s16_vol.data[0] = s16_vol;
+
+	/* configure stereo first so that the volumes are not remapped */
+	run_convert(ctx, &conv_s16, &dsp_unity);
+
+	spa_assert_se(set_channel_volumes(ctx, 2, volumes) == 0);
+	run_convert(ctx, &conv_s16, &dsp_vol);
+	run_convert(ctx, &dsp, &conv_s16_vol);
+	spa_assert_se(set_channel_volumes(ctx, 2, unity) == 0);
+
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	struct context ctx;
@@ -1139,6 +1227,7 @@ int main(int argc, char *argv[])
 
 	test_convert_remap_dsp(&ctx);
 	test_convert_remap_conv(&ctx);
+	test_convert_volume_blocks(&ctx);
 
 	clean_context(&ctx);
 
@@ -323,6 +323,18 @@ static void run_n_m_impl(struct channelmix *mix, const void **src, uint32_t n_sa
 		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
 	}
 #endif
+#if defined(HAVE_AVX) && defined(HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3)) {
+		channelmix_f32_n_m_avx(mix, dst_x, src, n_samples);
+		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
+	}
+#endif
+#if defined(HAVE_AVX512)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX512)) {
+		channelmix_f32_n_m_avx512(mix, dst_x, src, n_samples);
+		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
+	}
+#endif
 }
 
 static void test_n_m_impl(void)
@@ -368,6 +380,90 @@ static void test_n_m_impl(void)
 	run_n_m_impl(&mix, (const void**)src, N_SAMPLES);
 }
 
+#if defined(HAVE_AVX) && defined(HAVE_FMA)
+typedef void (*mix_func_t) (struct channelmix *mix, void * SPA_RESTRICT dst[],
+			const void * SPA_RESTRICT src[], uint32_t n_samples);
+
+static void run_fixed_impl(uint32_t src_chan, uint64_t src_mask, uint32_t dst_chan, uint64_t dst_mask,
+		mix_func_t func_c, mix_func_t func_x)
+{
+	struct channelmix mix;
+	uint32_t i, j;
+#define N_FIXED_STRIDE	264
+#define N_FIXED_SAMPLES	259
+	float src_data[8][N_FIXED_STRIDE] SPA_ALIGNED(32);
+	float dst_c_data[8][N_FIXED_STRIDE] SPA_ALIGNED(32);
+	float dst_x_data[8][N_FIXED_STRIDE] SPA_ALIGNED(32);
+	void *src[8], *dst_c[8], *dst_x[8];
+
+	spa_log_debug(&logger.log, "start %d->%d", src_chan, dst_chan);
+
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < N_FIXED_SAMPLES; j++)
+			src_data[i][j] = (float)((drand48() - 0.5f) * 2.5f);
+		src[i] = src_data[i];
+		dst_c[i] = dst_c_data[i];
+		dst_x[i] = dst_x_data[i];
+	}
+
+	spa_zero(mix);
+	mix.src_chan = src_chan;
+	mix.dst_chan = dst_chan;
+	mix.src_mask = src_mask;
+	mix.dst_mask = dst_mask;
+	mix.log = &logger.log;
+	mix.cpu_flags = cpu_flags;
+	spa_assert_se(channelmix_init(&mix) == 0);
+	channelmix_set_volume(&mix, 1.0f, false, 0, NULL);
+
+	/* aligned, full vectors and tail */
+	func_c(&mix, dst_c, (const void**)src, N_FIXED_SAMPLES);
+	func_x(&mix, dst_x, (const void**)src, N_FIXED_SAMPLES);
+	check_samples((float**)dst_c, (float**)dst_x, dst_chan, N_FIXED_SAMPLES);
+
+	/* unaligned */
+	for (i = 0; i < 8; i++) {
+		src[i] = &src_data[i][1];
+		dst_c[i] = &dst_c_data[i][1];
+		dst_x[i] = &dst_x_data[i][1];
+	}
+	func_c(&mix, dst_c, (const void**)src, N_FIXED_SAMPLES - 1);
+	func_x(&mix, dst_x, (const void**)src, N_FIXED_SAMPLES - 1);
+	check_samples((float**)dst_c, (float**)dst_x, dst_chan, N_FIXED_SAMPLES - 1);
+}
+#endif
+
+static void test_fixed_impl(void)
+{
+#if defined(HAVE_AVX) && defined(HAVE_FMA)
+	if (!SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		return;
+
+	run_fixed_impl(2, MASK_STEREO, 2, MASK_STEREO,
+			channelmix_copy_c, channelmix_copy_avx);
+	run_fixed_impl(2, MASK_STEREO, 4, MASK_3_1,
+			channelmix_f32_2_3p1_c, channelmix_f32_2_3p1_avx);
+	run_fixed_impl(2, MASK_STEREO, 6, MASK_5_1,
+			channelmix_f32_2_5p1_c, channelmix_f32_2_5p1_avx);
+	run_fixed_impl(2, MASK_STEREO, 8, MASK_7_1,
+			channelmix_f32_2_7p1_c, channelmix_f32_2_7p1_avx);
+	run_fixed_impl(4, MASK_3_1, 2, MASK_STEREO,
+			channelmix_f32_3p1_2_c, channelmix_f32_3p1_2_avx);
+	run_fixed_impl(6, MASK_5_1, 2, MASK_STEREO,
+			channelmix_f32_5p1_2_c, channelmix_f32_5p1_2_avx);
+	run_fixed_impl(6, MASK_5_1, 4, MASK_3_1,
+			channelmix_f32_5p1_3p1_c, channelmix_f32_5p1_3p1_avx);
+	run_fixed_impl(6, MASK_5_1, 4, MASK_QUAD,
+			channelmix_f32_5p1_4_c, channelmix_f32_5p1_4_avx);
+	run_fixed_impl(8, MASK_7_1, 2, MASK_STEREO,
+			channelmix_f32_7p1_2_c, channelmix_f32_7p1_2_avx);
+	run_fixed_impl(8, MASK_7_1, 4, MASK_3_1,
+			channelmix_f32_7p1_3p1_c, channelmix_f32_7p1_3p1_avx);
+	run_fixed_impl(8, MASK_7_1, 4, MASK_QUAD,
+			channelmix_f32_7p1_4_c, channelmix_f32_7p1_4_avx);
+#endif
+}
+
 int main(int argc, char *argv[])
 {
 	struct timespec ts;
@@ -391,6 +487,7 @@ int main(int argc, char *argv[])
 	test_7p1_N();
 
 	test_n_m_impl();
+	test_fixed_impl();
 
 	return 0;
 }
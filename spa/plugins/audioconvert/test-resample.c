@@ -2,25 +2,30 @@
 /* SPDX-FileCopyrightText: Copyright © 2019 Wim Taymans */
 /* SPDX-License-Identifier: MIT */
 
+#include "config.h"
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
 #include <time.h>
+#include <math.h>
 
 #include <spa/support/log-impl.h>
 #include <spa/debug/mem.h>
 
 SPA_LOG_IMPL(logger);
 
-#include "resample.h"
+#include "test-helper.h"
+#include "resample-native-impl.h"
 
 #define N_SAMPLES	253
 #define N_CHANNELS	11
 
 static float samp_in[N_SAMPLES * 4];
 static float samp_out[N_SAMPLES * 4];
+static float samp_in_channels[1024];
 
 static void feed_1(struct resample *r)
 {
@@ -146,12 +151,135 @@ static void test_in_len(void)
 	resample_free(&r);
 }
 
+static void run_channels(uint32_t cpu_flags, double rate, float *ref, uint32_t *ref_len)
+{
+	struct resample r1, rn;
+	static float in[N_CHANNELS][1024], out[N_CHANNELS][1024];
+	const void *src[N_CHANNELS];
+	void *dst[N_CHANNELS];
+	uint32_t c, in_len, out_len, in_len1, out_len1;
+
+	for (c = 0; c < N_CHANNELS; c++) {
+		memcpy(in[c], samp_in_channels, sizeof(in[c]));
+		src[c] = in[c];
+		dst[c] = out[c];
+	}
+
+	spa_zero(r1);
+	r1.log = &logger.log;
+	r1.channels = 1;
+	r1.cpu_flags = cpu_flags;
+	r1.i_rate = 44100;
+	r1.o_rate = 48000;
+	r1.quality = RESAMPLE_DEFAULT_QUALITY;
+	spa_assert_se(resample_native_init(&r1) == 0);
+	resample_update_rate(&r1, rate);
+
+	spa_zero(rn);
+	rn.log = &logger.log;
+	rn.channels = N_CHANNELS;
+	rn.cpu_flags = cpu_flags;
+	rn.i_rate = 44100;
+	rn.o_rate = 48000;
+	rn.quality = RESAMPLE_DEFAULT_QUALITY;
+	spa_assert_se(resample_native_init(&rn) == 0);
+	resample_update_rate(&rn, rate);
+
+	spa_log_info(&logger.log, "channels %d: %s", N_CHANNELS, rn.func_name);
+
+	in_len1 = in_len = 1024;
+	out_len1 = out_len = 1024;
+	resample_process(&r1, src, &in_len1, dst, &out_len1);
+	memcpy(ref, out[0], out_len1 * sizeof(float));
+	resample_process(&rn, src, &in_len, dst, &out_len);
+
+	/* all channels are processed in the same way, batched or not */
+	spa_assert_se(in_len == in_len1);
+	spa_assert_se(out_len == out_len1);
+	for (c = 0; c < N_CHANNELS; c++)
+		spa_assert_se(memcmp(out[c], ref, out_len * sizeof(float)) == 0);
+
+	*ref_len = out_len;
+
+	resample_free(&r1);
+	resample_free(&rn);
+}
+
+static void test_channels(void)
+{
+	static float ref_c[1024], ref_x[1024];
+	uint32_t i, cpu_flags, len_c, len_x;
+	double rates[] = { 1.0, 0.99 };
+
+	cpu_flags = get_cpu_flags();
+
+	for (i = 0; i < 1024; i++)
+		samp_in_channels[i] = (float)(drand48() * 2.0 - 1.0);
+
+	for (i = 0; i < SPA_N_ELEMENTS(rates); i++) {
+		uint32_t j;
+
+		run_channels(0, rates[i], ref_c, &len_c);
+		run_channels(cpu_flags, rates[i], ref_x, &len_x);
+
+		spa_assert_se(len_c == len_x);
+		for (j = 0; j < len_c; j++)
+			spa_assert_se(fabsf(ref_c[j] - ref_x[j]) < 0.00001f);
+	}
+}
+
+static void init_native(struct resample *r, uint32_t in_rate, uint32_t out_rate, int quality)
+{
+	spa_zero(*r);
+	r->log = &logger.log;
+	r->channels = 2;
+	r->i_rate = in_rate;
+	r->o_rate = out_rate;
+	r->quality = quality;
+	spa_assert_se(resample_native_init(r) == 0);
+}
+
+static void test_shared_filter(void)
+{
+	struct resample r1, r2, r3, r4;
+	struct native_data *d1, *d2, *d3, *d4;
+
+	/* same reduced rates and quality share the filter */
+	init_native(&r1, 44100, 48000, 4);
+	init_native(&r2, 88200, 96000, 4);
+	/* other quality makes a new filter */
+	init_native(&r3, 44100, 48000, 6);
+
+	d1 = r1.data;
+	d2 = r2.data;
+	d3 = r3.data;
+	spa_assert_se(d1->filter == d2->filter);
+	spa_assert_se(d1->filter != d3->filter);
+	spa_assert_se(SPA_IS_ALIGNED(d1->filter, 64));
+	spa_assert_se(SPA_IS_ALIGNED(d3->filter, 64));
+
+	resample_free(&r1);
+
+	/* the filter stays alive as long as it is used */
+	init_native(&r4, 88200, 96000, 4);
+	d4 = r4.data;
+	spa_assert_se(d2->filter == d4->filter);
+	spa_assert_se(d2->n_taps == d4->n_taps);
+	spa_assert_se(d2->n_phases == d4->n_phases);
+
+	resample_free(&r2);
+	resample_free(&r3);
+	resample_free(&r4);
+}
+
 int main(int argc, char *argv[])
 {
 	logger.log.level = SPA_LOG_LEVEL_TRACE;
 
 	test_native();
 	test_in_len();
+	test_channels();
+	test_shared_filter();
 
 	return 0;
 }
@@ -112,6 +112,15 @@ struct impl {
 	struct spa_audio_info format;
 	uint32_t stride;
 
+	/* skipped work, logged when paused */
+	struct {
+		uint64_t cycles;
+		uint64_t mixed;
+		uint64_t skipped;
+		uint64_t passthrough;
+		uint64_t silent;
+	} stats;
+
 	unsigned int have_format:1;
 	unsigned int started:1;
 };
@@ -168,6 +177,11 @@ static int impl_node_send_command(void *object, const struct spa_command *comman
 		break;
 	case SPA_NODE_COMMAND_Pause:
 		this->started = false;
+		spa_log_debug(this->log, "%p: cycles:%"PRIu64" mixed:%"PRIu64" "
+				"skipped:%"PRIu64" passthrough:%"PRIu64" silent:%"PRIu64,
+				this, this->stats.cycles, this->stats.mixed,
+				this->stats.skipped, this->stats.passthrough,
+				this->stats.silent);
 		break;
 	default:
 		return -ENOTSUP;
@@ -772,9 +786,12 @@ static int impl_node_process(void *object)
 				offs, size, (int)sizeof(float),
 				bd->chunk->flags);
 
+		/* empty buffers contain silence and don't need to be mixed */
 		if (!SPA_FLAG_IS_SET(bd->chunk->flags, SPA_CHUNK_FLAG_EMPTY)) {
 			datas[n_buffers] = SPA_PTROFF(bd->data, offs, void);
 			buffers[n_buffers++] = inb;
+		} else {
+			this->stats.skipped++;
 		}
 		inio->status = SPA_STATUS_NEED_DATA;
 	}
@@ -787,8 +804,12 @@ static int impl_node_process(void *object)
 		return -EPIPE;
 	}
 
+	this->stats.cycles++;
+
 	if (n_buffers == 1) {
+		/* one input with data, pass it without copying */
 		*outb->buffer = *buffers[0]->buffer;
+		this->stats.passthrough++;
 	} else {
 		struct spa_data *d = outb->buf.datas;
 
@@ -803,6 +824,10 @@ static int impl_node_process(void *object)
 
 		spa_log_trace_fp(this->log, "%p: %d mix %d", this, n_buffers, maxsize);
 
+		if (n_buffers == 0)
+			this->stats.silent++;
+		this->stats.mixed += n_buffers;
+
 		mix_ops_process(&this->ops, d[0].data,
 				datas, n_buffers, maxsize / sizeof(float));
 	}
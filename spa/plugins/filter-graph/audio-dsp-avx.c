@@ -234,6 +234,214 @@ void dsp_sum_avx(void *obj, float *r, const float *a, const float *b, uint32_t n
 	}
 }
 
+/* the channels that don't fill the 8 lanes are done with SSE */
+MAKE_BIQUAD_RUN_FUNC(sse);
+
+#define BQ_SET8(bq,s,f)	_mm256_setr_ps(bq[0].f, bq[s].f, bq[2*s].f, bq[3*s].f,	\
+				bq[4*s].f, bq[5*s].f, bq[6*s].f, bq[7*s].f)
+
+/* transpose 8 samples of 8 channels into 8 samples with all channels */
+static inline void transpose8_avx(__m256 r[8])
+{
+	__m256 t[8], u[8];
+
+	t[0] = _mm256_unpacklo_ps(r[0], r[1]);
+	t[1] = _mm256_unpackhi_ps(r[0], r[1]);
+	t[2] = _mm256_unpacklo_ps(r[2], r[3]);
+	t[3] = _mm256_unpackhi_ps(r[2], r[3]);
+	t[4] = _mm256_unpacklo_ps(r[4], r[5]);
+	t[5] = _mm256_unpackhi_ps(r[4], r[5]);
+	t[6] = _mm256_unpacklo_ps(r[6], r[7]);
+	t[7] = _mm256_unpackhi_ps(r[6], r[7]);
+
+	u[0] = _mm256_shuffle_ps(t[0], t[2], _MM_SHUFFLE(1,0,1,0));
+	u[1] = _mm256_shuffle_ps(t[0], t[2], _MM_SHUFFLE(3,2,3,2));
+	u[2] = _mm256_shuffle_ps(t[1], t[3], _MM_SHUFFLE(1,0,1,0));
+	u[3] = _mm256_shuffle_ps(t[1], t[3], _MM_SHUFFLE(3,2,3,2));
+	u[4] = _mm256_shuffle_ps(t[4], t[6], _MM_SHUFFLE(1,0,1,0));
+	u[5] = _mm256_shuffle_ps(t[4], t[6], _MM_SHUFFLE(3,2,3,2));
+	u[6] = _mm256_shuffle_ps(t[5], t[7], _MM_SHUFFLE(1,0,1,0));
+	u[7] = _mm256_shuffle_ps(t[5], t[7], _MM_SHUFFLE(3,2,3,2));
+
+	r[0] = _mm256_permute2f128_ps(u[0], u[4], 0x20);
+	r[1] = _mm256_permute2f128_ps(u[1], u[5], 0x20);
+	r[2] = _mm256_permute2f128_ps(u[2], u[6], 0x20);
+	r[3] = _mm256_permute2f128_ps(u[3], u[7], 0x20);
+	r[4] = _mm256_permute2f128_ps(u[0], u[4], 0x31);
+	r[5] = _mm256_permute2f128_ps(u[1], u[5], 0x31);
+	r[6] = _mm256_permute2f128_ps(u[2], u[6], 0x31);
+	r[7] = _mm256_permute2f128_ps(u[3], u[7], 0x31);
+}
+
+#define BQ_STEP(x,y,z,b0,b1,b2,a1,a2,x1,x2)					\
+do {										\
+	y = _mm256_mul_ps(x, b0);	/* y = x * b0 */			\
+	y = _mm256_add_ps(y, x1);	/* y = x * b0 + x1*/			\
+	z = _mm256_mul_ps(y, a1);	/* z = a1 * y */			\
+	x1 = _mm256_mul_ps(x, b1);	/* x1 = x * b1 */			\
+	x1 = _mm256_add_ps(x1, x2);	/* x1 = x * b1 + x2*/			\
+	x1 = _mm256_sub_ps(x1, z);	/* x1 = x * b1 + x2 - a1 * y*/		\
+	z = _mm256_mul_ps(y, a2);	/* z = a2 * y */			\
+	x2 = _mm256_mul_ps(x, b2);	/* x2 = x * b2 */			\
+	x2 = _mm256_sub_ps(x2, z);	/* x2 = x * b2 - a2 * y*/		\
+} while (0)
+
+static void dsp_biquad_run8_avx(void *obj, struct biquad *bq, uint32_t bq_stride,
+		float **out, const float **in, uint32_t n_samples)
+{
+	__m256 x, y, z;
+	__m256 b0, b1, b2;
+	__m256 a1, a2;
+	__m256 x1, x2;
+	__m256 v[8];
+	float t1[8], t2[8];
+	uint32_t i, j, unrolled = n_samples & ~7;
+
+	b0 = BQ_SET8(bq, bq_stride, b0);
+	b1 = BQ_SET8(bq, bq_stride, b1);
+	b2 = BQ_SET8(bq, bq_stride, b2);
+	a1 = BQ_SET8(bq, bq_stride, a1);
+	a2 = BQ_SET8(bq, bq_stride, a2);
+	x1 = BQ_SET8(bq, bq_stride, x1);
+	x2 = BQ_SET8(bq, bq_stride, x2);
+
+	for (i = 0; i < unrolled; i += 8) {
+		for (j = 0; j < 8; j++)
+			v[j] = _mm256_loadu_ps(&in[j][i]);
+		transpose8_avx(v);
+		for (j = 0; j < 8; j++) {
+			x = v[j];
+			BQ_STEP(x, y, z, b0, b1, b2, a1, a2, x1, x2);
+			v[j] = y;
+		}
+		transpose8_avx(v);
+		for (j = 0; j < 8; j++)
+			_mm256_storeu_ps(&out[j][i], v[j]);
+	}
+	for (; i < n_samples; i++) {
+		x = _mm256_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i],
+				in[4][i], in[5][i], in[6][i], in[7][i]);
+		BQ_STEP(x, y, z, b0, b1, b2, a1, a2, x1, x2);
+		for (j = 0; j < 8; j++)
+			out[j][i] = y[j];
+	}
+	_mm256_storeu_ps(t1, x1);
+	_mm256_storeu_ps(t2, x2);
+#define F(x) (isnormal(x) ? (x) : 0.0f)
+	for (j = 0; j < 8; j++) {
+		bq[j*bq_stride].x1 = F(t1[j]);
+		bq[j*bq_stride].x2 = F(t2[j]);
+	}
+#undef F
+}
+
+static void dsp_biquad2_run8_avx(void *obj, struct biquad *bq, uint32_t bq_stride,
+		float **out, const float **in, uint32_t n_samples)
+{
+	__m256 x, y, z;
+	__m256 b00, b01, b02, b10, b11, b12;
+	__m256 a01, a02, a11, a12;
+	__m256 x01, x02, x11, x12;
+	__m256 v[8];
+	float t[4][8];
+	uint32_t i, j, unrolled = n_samples & ~7;
+
+	b00 = BQ_SET8(bq, bq_stride, b0);
+	b01 = BQ_SET8(bq, bq_stride, b1);
+	b02 = BQ_SET8(bq, bq_stride, b2);
+	a01 = BQ_SET8(bq, bq_stride, a1);
+	a02 = BQ_SET8(bq, bq_stride, a2);
+	x01 = BQ_SET8(bq, bq_stride, x1);
+	x02 = BQ_SET8(bq, bq_stride, x2);
+
+	b10 = BQ_SET8((&bq[1]), bq_stride, b0);
+	b11 = BQ_SET8((&bq[1]), bq_stride, b1);
+	b12 = BQ_SET8((&bq[1]), bq_stride, b2);
+	a11 = BQ_SET8((&bq[1]), bq_stride, a1);
+	a12 = BQ_SET8((&bq[1]), bq_stride, a2);
+	x11 = BQ_SET8((&bq[1]), bq_stride, x1);
+	x12 = BQ_SET8((&bq[1]), bq_stride, x2);
+
+	for (i = 0; i < unrolled; i += 8) {
+		for (j = 0; j < 8; j++)
+			v[j] = _mm256_loadu_ps(&in[j][i]);
+		transpose8_avx(v);
+		for (j = 0; j < 8; j++) {
+			x = v[j];
+			BQ_STEP(x, y, z, b00, b01, b02, a01, a02, x01, x02);
+			x = y;
+			BQ_STEP(x, y, z, b10, b11, b12, a11, a12, x11, x12);
+			v[j] = y;
+		}
+		transpose8_avx(v);
+		for (j = 0; j < 8; j++)
+			_mm256_storeu_ps(&out[j][i], v[j]);
+	}
+	for (; i < n_samples; i++) {
+		x = _mm256_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i],
+				in[4][i], in[5][i], in[6][i], in[7][i]);
+		BQ_STEP(x, y, z, b00, b01, b02, a01, a02, x01, x02);
+		x = y;
+		BQ_STEP(x, y, z, b10, b11, b12, a11, a12, x11, x12);
+		for (j = 0; j < 8; j++)
+			out[j][i] = y[j];
+	}
+	_mm256_storeu_ps(t[0], x01);
+	_mm256_storeu_ps(t[1], x02);
+	_mm256_storeu_ps(t[2], x11);
+	_mm256_storeu_ps(t[3], x12);
+#define F(x) (isnormal(x) ? (x) : 0.0f)
+	for (j = 0; j < 8; j++) {
+		bq[j*bq_stride+0].x1 = F(t[0][j]);
+		bq[j*bq_stride+0].x2 = F(t[1][j]);
+		bq[j*bq_stride+1].x1 = F(t[2][j]);
+		bq[j*bq_stride+1].x2 = F(t[3][j]);
+	}
+#undef F
+}
+#undef BQ_STEP
+#undef BQ_SET8
+
+void dsp_biquad_run_avx(void *obj, struct biquad *bq, uint32_t n_bq, uint32_t bq_stride,
+		float * SPA_RESTRICT out[], const float * SPA_RESTRICT in[],
+		uint32_t n_src, uint32_t n_samples)
+{
+	uint32_t i, j, k, bqs8 = bq_stride*8;
+	uint32_t iunrolled8 = n_src & ~7;
+	uint32_t junrolled2 = n_bq & ~1;
+
+	for (i = 0; i < iunrolled8; i+=8, bq+=bqs8) {
+		const float *s[8];
+		float *d[8];
+
+		for (k = 0; k < 8; k++) {
+			s[k] = in[i+k];
+			d[k] = out[i+k];
+			if (s[k] == NULL || d[k] == NULL)
+				break;
+		}
+		if (k < 8)
+			break;
+
+		j = 0;
+		if (j < junrolled2) {
+			dsp_biquad2_run8_avx(obj, &bq[j], bq_stride, d, s, n_samples);
+			for (k = 0; k < 8; k++)
+				s[k] = d[k];
+			j+=2;
+		}
+		for (; j < junrolled2; j+=2) {
+			dsp_biquad2_run8_avx(obj, &bq[j], bq_stride, d, s, n_samples);
+		}
+		if (j < n_bq) {
+			dsp_biquad_run8_avx(obj, &bq[j], bq_stride, d, s, n_samples);
+		}
+	}
+	if (i < n_src)
+		dsp_biquad_run_sse(obj, bq, n_bq, bq_stride, &out[i], &in[i],
+				n_src - i, n_samples);
+}
+
 inline static __m256 _mm256_mul_pz(__m256 ab, __m256 cd)
 {
 	__m256 aa, bb, dc, x0, x1;
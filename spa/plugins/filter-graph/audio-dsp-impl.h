@@ -87,6 +87,7 @@ MAKE_FFT_CMULADD_FUNC(sse);
 #if defined (HAVE_AVX)
 MAKE_MIX_GAIN_FUNC(avx);
 MAKE_SUM_FUNC(avx);
+MAKE_BIQUAD_RUN_FUNC(avx);
 MAKE_FFT_CMUL_FUNC(avx);
 MAKE_FFT_CMULADD_FUNC(avx);
 #endif
@@ -28,7 +28,7 @@ static const struct dsp_info dsp_table[] =
 		.funcs.clear = dsp_clear_c,
 		.funcs.copy = dsp_copy_c,
 		.funcs.mix_gain = dsp_mix_gain_avx,
-		.funcs.biquad_run = dsp_biquad_run_sse,
+		.funcs.biquad_run = dsp_biquad_run_avx,
 		.funcs.sum = dsp_sum_avx,
 		.funcs.linear = dsp_linear_c,
 		.funcs.mult = dsp_mult_c,
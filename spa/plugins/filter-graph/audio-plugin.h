@@ -70,6 +70,8 @@ struct spa_fga_descriptor {
 	void (*deactivate) (void *instance);
 
 	void (*run) (void *instance, unsigned long SampleCount);
+	/* optional, run n_instances of the descriptor at once */
+	void (*run_multi) (void **instances, uint32_t n_instances, unsigned long SampleCount);
 };
 
 static inline void spa_fga_descriptor_free(const struct spa_fga_descriptor *desc)
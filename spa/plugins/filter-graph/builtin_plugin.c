@@ -32,6 +32,7 @@ struct plugin {
 
 	struct spa_fga_dsp *dsp;
 	struct spa_log *log;
+	struct spa_thread_utils *thread_utils;
 };
 
 struct builtin {
@@ -523,13 +524,8 @@ static void bq_activate(void * Instance)
 	}
 }
 
-static void bq_run(void *Instance, unsigned long samples)
+static void bq_update(struct builtin *impl)
 {
-	struct builtin *impl = Instance;
-	struct biquad *bq = &impl->bq;
-	float *out = impl->port[0];
-	float *in = impl->port[1];
-
 	if (impl->type == BQ_NONE) {
 		float b0, b1, b2, a0, a1, a2;
 		b0 = impl->port[5][0];
@@ -549,9 +545,48 @@ static void bq_run(void *Instance, unsigned long samples)
 		if (impl->freq != freq || impl->Q != Q || impl->gain != gain)
 			bq_freq_update(impl, impl->type, freq, Q, gain);
 	}
+}
+
+static void bq_run(void *Instance, unsigned long samples)
+{
+	struct builtin *impl = Instance;
+	struct biquad *bq = &impl->bq;
+	float *out = impl->port[0];
+	float *in = impl->port[1];
+
+	bq_update(impl);
 	spa_fga_dsp_biquad_run(impl->dsp, bq, 1, 0, &out, (const float **)&in, 1, samples);
 }
 
+/* Run the biquads of all channels of a node together, the dsp functions
+ * then process the channels in the SIMD lanes. */
+#define BQ_MAX_MULTI	8
+static void bq_run_multi(void **Instances, uint32_t n_instances, unsigned long samples)
+{
+	struct builtin *impl = Instances[0];
+	struct biquad bq[BQ_MAX_MULTI];
+	float *out[BQ_MAX_MULTI];
+	const float *in[BQ_MAX_MULTI];
+	uint32_t i, j, n;
+
+	for (i = 0; i < n_instances; i += n) {
+		n = SPA_MIN(n_instances - i, (uint32_t)BQ_MAX_MULTI);
+		for (j = 0; j < n; j++) {
+			struct builtin *b = Instances[i + j];
+			bq_update(b);
+			bq[j] = b->bq;
+			out[j] = b->port[0];
+			in[j] = b->port[1];
+		}
+		spa_fga_dsp_biquad_run(impl->dsp, bq, 1, 1, out, in, n, samples);
+		for (j = 0; j < n; j++) {
+			struct builtin *b = Instances[i + j];
+			b->bq.x1 = bq[j].x1;
+			b->bq.x2 = bq[j].x2;
+		}
+	}
+}
+
 /** bq_lowpass */
 static const struct spa_fga_descriptor bq_lowpass_desc = {
 	.name = "bq_lowpass",
@@ -563,6 +598,7 @@ static const struct spa_fga_descriptor bq_lowpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -577,6 +613,7 @@ static const struct spa_fga_descriptor bq_highpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -591,6 +628,7 @@ static const struct spa_fga_descriptor bq_bandpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -605,6 +643,7 @@ static const struct spa_fga_descriptor bq_lowshelf_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -619,6 +658,7 @@ static const struct spa_fga_descriptor bq_highshelf_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -633,6 +673,7 @@ static const struct spa_fga_descriptor bq_peaking_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -647,6 +688,7 @@ static const struct spa_fga_descriptor bq_notch_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -662,6 +704,7 @@ static const struct spa_fga_descriptor bq_allpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -676,6 +719,7 @@ static const struct spa_fga_descriptor bq_raw_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -917,13 +961,14 @@ static void * convolver_instantiate(const struct spa_fga_plugin *plugin, const s
 	struct plugin *pl = SPA_CONTAINER_OF(plugin, struct plugin, plugin);
 	struct convolver_impl *impl;
 	float *samples;
-	int offset = 0, length = 0, channel = index, n_samples = 0, len;
+	int offset = 0, length = 0, channel = index, n_samples = 0, len, res;
 	uint32_t i = 0;
 	struct spa_json it[2];
 	const char *val;
 	char key[256], v[256];
 	char *filenames[MAX_RATES] = { 0 };
 	int blocksize = 0, tailsize = 0;
+	bool background = false;
 	int resample_quality = RESAMPLE_DEFAULT_QUALITY;
 	float gain = 1.0f, delay = 0.0f;
 	unsigned long rate;
@@ -952,6 +997,12 @@ static void * convolver_instantiate(const struct spa_fga_plugin *plugin, const s
 				return NULL;
 			}
 		}
+		else if (spa_streq(key, "background")) {
+			if (spa_json_parse_bool(val, len, &background) <= 0) {
+				spa_log_error(pl->log, "convolver:background requires a boolean");
+				return NULL;
+			}
+		}
 		else if (spa_streq(key, "gain")) {
 			if (spa_json_parse_float(val, len, &gain) <= 0) {
 				spa_log_error(pl->log, "convolver:gain requires a number");
@@ -1067,6 +1118,11 @@ static void * convolver_instantiate(const struct spa_fga_plugin *plugin, const s
 	if (impl->conv == NULL)
 		goto error;
 
+	if (background &&
+	    (res = convolver_start_background(impl->conv, pl->thread_utils)) < 0)
+		spa_log_warn(pl->log, "convolver: can't start background thread: %s",
+				spa_strerror(res));
+
 	free(samples);
 
 	return impl;
@@ -2582,6 +2638,7 @@ impl_init(const struct spa_handle_factory *factory,
 
 	impl->log = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_Log);
 	impl->dsp = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_FILTER_GRAPH_AudioDSP);
+	impl->thread_utils = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_ThreadUtils);
 
 	for (uint32_t i = 0; info && i < info->n_items; i++) {
 		const char *k = info->items[i].key;
@@ -7,8 +7,11 @@
 #include "convolver.h"
 
 #include <spa/utils/defs.h>
+#include <spa/support/thread.h>
 
 #include <math.h>
+#include <errno.h>
+#include <semaphore.h>
 
 struct convolver1 {
 	int blockSize;
@@ -237,8 +240,115 @@ struct convolver
 	float *tailInput;
 	int tailInputFill;
 	int precalculatedPos;
+
+	/* the tail convolver can run in a thread, it then has a complete
+	 * tail block to produce the output for the next tail block. The
+	 * input and output of the thread are double buffered and swapped
+	 * at the tail block boundaries after the thread completed. */
+	struct spa_thread_utils *thread_utils;
+	struct spa_thread *thread;
+	sem_t start;
+	sem_t done;
+	float *tailBackgroundInput;
+	uint32_t overruns;		/* times we had to wait for the thread */
+	bool busy;			/* a block was started and not collected */
+	bool quit;
+	unsigned int background:1;
 };
 
+/* wait for the thread to complete the block it is working on */
+static void tail_sync(struct convolver *conv)
+{
+	if (!conv->busy)
+		return;
+	while (sem_wait(&conv->done) < 0 && errno == EINTR);
+	conv->busy = false;
+}
+
+/* called at a tail block boundary. The result of the previous block is
+ * needed for the next block, when the thread did not finish it yet we wait
+ * for it. Skipping it would make the tail late and leave a hole in the
+ * input history of the tail convolver. */
+static void tail_swap(struct convolver *conv)
+{
+	if (conv->busy && sem_trywait(&conv->done) == 0)
+		conv->busy = false;
+	if (conv->busy) {
+		conv->overruns++;
+		tail_sync(conv);
+	}
+	SPA_SWAP(conv->tailPrecalculated, conv->tailOutput);
+	SPA_SWAP(conv->tailBackgroundInput, conv->tailInput);
+	conv->busy = true;
+	sem_post(&conv->start);
+}
+
+static void *tail_thread(void *data)
+{
+	struct convolver *conv = data;
+
+	while (true) {
+		while (sem_wait(&conv->start) < 0 && errno == EINTR);
+		if (conv->quit)
+			break;
+		convolver1_run(conv->dsp, conv->tailConvolver, conv->tailBackgroundInput,
+				conv->tailOutput, conv->tailBlockSize);
+		sem_post(&conv->done);
+	}
+	return NULL;
+}
+
+int convolver_start_background(struct convolver *conv, struct spa_thread_utils *thread_utils)
+{
+	struct spa_fga_dsp *dsp = conv->dsp;
+
+	if (conv->tailConvolver == NULL || conv->background)
+		return 0;
+	if (thread_utils == NULL)
+		return -ENOTSUP;
+
+	conv->tailBackgroundInput = spa_fga_dsp_fft_memalloc(dsp, conv->tailBlockSize, true);
+	if (conv->tailBackgroundInput == NULL)
+		return -errno;
+
+	sem_init(&conv->start, 0, 0);
+	sem_init(&conv->done, 0, 0);
+	conv->busy = false;
+	conv->quit = false;
+	conv->thread_utils = thread_utils;
+
+	conv->thread = spa_thread_utils_create(thread_utils,
+			&SPA_DICT_ITEMS(
+				SPA_DICT_ITEM(SPA_KEY_THREAD_NAME, "pw-convolver")),
+			tail_thread, conv);
+	if (conv->thread == NULL) {
+		int res = -errno;
+		sem_destroy(&conv->start);
+		sem_destroy(&conv->done);
+		spa_fga_dsp_fft_memfree(dsp, conv->tailBackgroundInput);
+		conv->tailBackgroundInput = NULL;
+		return res;
+	}
+	spa_thread_utils_acquire_rt(thread_utils, conv->thread, -1);
+	conv->background = true;
+	return 0;
+}
+
+static void convolver_stop_background(struct convolver *conv)
+{
+	if (!conv->background)
+		return;
+
+	tail_sync(conv);
+	conv->quit = true;
+	sem_post(&conv->start);
+	spa_thread_utils_join(conv->thread_utils, conv->thread, NULL);
+	sem_destroy(&conv->start);
+	sem_destroy(&conv->done);
+	spa_fga_dsp_fft_memfree(conv->dsp, conv->tailBackgroundInput);
+	conv->background = false;
+}
+
 void convolver_reset(struct convolver *conv)
 {
 	struct spa_fga_dsp *dsp = conv->dsp;
@@ -251,6 +361,7 @@ void convolver_reset(struct convolver *conv)
 		spa_fga_dsp_fft_memclear(dsp, conv->tailPrecalculated0, conv->tailBlockSize, true);
 	}
 	if (conv->tailConvolver) {
+		tail_sync(conv);
 		convolver1_reset(dsp, conv->tailConvolver);
 		spa_fga_dsp_fft_memclear(dsp, conv->tailOutput, conv->tailBlockSize, true);
 		spa_fga_dsp_fft_memclear(dsp, conv->tailPrecalculated, conv->tailBlockSize, true);
@@ -329,6 +440,8 @@ void convolver_free(struct convolver *conv)
 {
 	struct spa_fga_dsp *dsp = conv->dsp;
 
+	convolver_stop_background(conv);
+
 	if (conv->headConvolver)
 		convolver1_free(dsp, conv->headConvolver);
 	if (conv->tailConvolver0)
@@ -381,9 +494,13 @@ int convolver_run(struct convolver *conv, const float *input, float *output, int
 
 			if (conv->tailPrecalculated &&
 			    conv->tailInputFill == conv->tailBlockSize) {
-				SPA_SWAP(conv->tailPrecalculated, conv->tailOutput);
-				convolver1_run(dsp, conv->tailConvolver, conv->tailInput,
-						conv->tailOutput, conv->tailBlockSize);
+				if (conv->background) {
+					tail_swap(conv);
+				} else {
+					SPA_SWAP(conv->tailPrecalculated, conv->tailOutput);
+					convolver1_run(dsp, conv->tailConvolver, conv->tailInput,
+							conv->tailOutput, conv->tailBlockSize);
+				}
 			}
 			if (conv->tailInputFill == conv->tailBlockSize) {
 				conv->tailInputFill = 0;
@@ -5,10 +5,14 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <spa/support/thread.h>
+
 #include "audio-dsp.h"
 
 struct convolver *convolver_new(struct spa_fga_dsp *dsp, int block, int tail, const float *ir, int irlen);
 void convolver_free(struct convolver *conv);
 
+int convolver_start_background(struct convolver *conv, struct spa_thread_utils *thread_utils);
+
 void convolver_reset(struct convolver *conv);
 int convolver_run(struct convolver *conv, const float *input, float *output, int length);
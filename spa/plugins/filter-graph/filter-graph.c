@@ -12,6 +12,7 @@
 #include <unistd.h>
 #include <limits.h>
 #include <math.h>
+#include <semaphore.h>
 
 #include "config.h"
 
@@ -20,6 +21,7 @@
 #include <spa/utils/json.h>
 #include <spa/support/cpu.h>
 #include <spa/support/plugin-loader.h>
+#include <spa/support/thread.h>
 #include <spa/param/latency-utils.h>
 #include <spa/param/tag-utils.h>
 #include <spa/param/audio/raw.h>
@@ -39,6 +41,7 @@
 SPA_LOG_TOPIC_DEFINE_STATIC(log_topic, "spa.filter-graph");
 
 #define MAX_HNDL 64
+#define MAX_THREADS 16u
 
 #define DEFAULT_RATE	48000
 
@@ -92,10 +95,11 @@ struct port {
 	struct spa_list link_list;
 	uint32_t n_links;
 	uint32_t external;
+	uint32_t buffer;
+	uint32_t n_readers;
 
 	float control_data[MAX_HNDL];
 	float *audio_data[MAX_HNDL];
-	void *audio_mem[MAX_HNDL];
 };
 
 struct node {
@@ -114,10 +118,13 @@ struct node {
 
 	uint32_t n_hndl;
 	void *hndl[MAX_HNDL];
+	uint32_t job[MAX_HNDL];
 
 	unsigned int n_deps;
+	uint32_t group;
 	unsigned int visited:1;
 	unsigned int disabled:1;
+	unsigned int elided:1;
 	unsigned int control_changed:1;
 };
 
@@ -141,6 +148,12 @@ struct graph_port {
 struct graph_hndl {
 	const struct spa_fga_descriptor *desc;
 	void **hndl;
+	uint32_t n_hndl;
+};
+
+struct graph_job {
+	uint32_t start;
+	uint32_t end;
 };
 
 struct volume {
@@ -172,9 +185,15 @@ struct graph {
 	uint32_t n_hndl;
 	struct graph_hndl *hndl;
 
+	uint32_t n_job;
+	struct graph_job *job;
+
 	uint32_t n_control;
 	struct port **control_port;
 
+	uint32_t n_buffers;
+	void *buffer_mem;
+
 	struct volume volume[2];
 
 	unsigned activated:1;
@@ -189,6 +208,7 @@ struct impl {
 	struct spa_cpu *cpu;
 	struct spa_fga_dsp *dsp;
 	struct spa_plugin_loader *loader;
+	struct spa_thread_utils *thread_utils;
 
 	uint64_t info_all;
 	struct spa_filter_graph_info info;
@@ -203,6 +223,17 @@ struct impl {
 
 	float *silence_data;
 	float *discard_data;
+	uint32_t n_discard;
+
+	uint32_t n_threads;
+	uint32_t n_workers;
+	struct spa_thread *workers[MAX_THREADS];
+	sem_t start;
+	sem_t done;
+	uint32_t next_job;
+	uint32_t pending;
+	uint32_t n_samples;
+	bool quit;
 };
 
 static void emit_filter_graph_info(struct impl *impl, bool full)
@@ -235,6 +266,52 @@ impl_add_listener(void *object,
 	return 0;
 }
 
+static inline void run_hndl(struct graph *graph, uint32_t start, uint32_t end,
+		uint32_t n_samples)
+{
+	uint32_t i;
+	for (i = start; i < end; i++) {
+		struct graph_hndl *hndl = &graph->hndl[i];
+		if (hndl->n_hndl > 1)
+			hndl->desc->run_multi(hndl->hndl, hndl->n_hndl, n_samples);
+		else
+			hndl->desc->run(*hndl->hndl, n_samples);
+	}
+}
+
+/* take jobs until there are none left. Returns true when this
+ * thread completed the last job of the cycle. */
+static bool run_jobs(struct impl *impl)
+{
+	struct graph *graph = &impl->graph;
+	struct graph_job *job;
+	uint32_t j;
+	bool last = false;
+
+	while ((j = __atomic_fetch_add(&impl->next_job, 1, __ATOMIC_ACQUIRE)) < graph->n_job) {
+		job = &graph->job[j];
+		run_hndl(graph, job->start, job->end, impl->n_samples);
+		if (__atomic_sub_fetch(&impl->pending, 1, __ATOMIC_ACQ_REL) == 0)
+			last = true;
+	}
+	return last;
+}
+
+static void *worker_thread(void *data)
+{
+	struct impl *impl = data;
+
+	while (true) {
+		if (sem_wait(&impl->start) < 0)
+			continue;
+		if (impl->quit)
+			break;
+		if (run_jobs(impl))
+			sem_post(&impl->done);
+	}
+	return NULL;
+}
+
 static int impl_process(void *object,
 		const void *in[], void *out[], uint32_t n_samples)
 {
@@ -263,9 +340,17 @@ static int impl_process(void *object,
 		else
 			memset(out[i], 0, n_samples * sizeof(float));
 	}
-	for (i = 0; i < n_hndl; i++) {
-		struct graph_hndl *hndl = &graph->hndl[i];
-		hndl->desc->run(*hndl->hndl, n_samples);
+	if (impl->n_workers > 0) {
+		/* the workers and this thread take jobs until all are done */
+		impl->n_samples = n_samples;
+		__atomic_store_n(&impl->pending, graph->n_job, __ATOMIC_RELAXED);
+		__atomic_store_n(&impl->next_job, 0, __ATOMIC_RELEASE);
+		for (i = 0; i < impl->n_workers; i++)
+			sem_post(&impl->start);
+		if (!run_jobs(impl))
+			while (sem_wait(&impl->done) < 0);
+	} else {
+		run_hndl(graph, 0, n_hndl, n_samples);
 	}
 	return 0;
 }
@@ -571,16 +656,20 @@ static int impl_reset(void *object)
 {
 	struct impl *impl = object;
 	struct graph *graph = &impl->graph;
-	uint32_t i;
+	uint32_t i, j;
 	for (i = 0; i < graph->n_hndl; i++) {
 		struct graph_hndl *hndl = &graph->hndl[i];
 		const struct spa_fga_descriptor *d = hndl->desc;
-		if (hndl->hndl == NULL || *hndl->hndl == NULL)
+		if (hndl->hndl == NULL)
 			continue;
-		if (d->deactivate)
-			d->deactivate(*hndl->hndl);
-		if (d->activate)
-			d->activate(*hndl->hndl);
+		for (j = 0; j < hndl->n_hndl; j++) {
+			if (hndl->hndl[j] == NULL)
+				continue;
+			if (d->deactivate)
+				d->deactivate(hndl->hndl[j]);
+			if (d->activate)
+				d->activate(hndl->hndl[j]);
+		}
 	}
 	return 0;
 }
@@ -1360,44 +1449,23 @@ static void node_cleanup(struct node *node)
 	}
 }
 
-static int port_ensure_data(struct port *port, uint32_t i, uint32_t max_samples)
+/* find the port that produces the data for a link, skipping the
+ * copy nodes that were elided */
+static struct port *link_source(struct link *link)
 {
-	float *data;
-	struct node *node = port->node;
-	const struct spa_fga_descriptor *d = node->desc->desc;
-	struct impl *impl = node->graph->impl;
+	struct port *port = link->output;
 
-	if ((data = port->audio_mem[i]) == NULL) {
-		data = calloc(max_samples, sizeof(float) + impl->max_align);
-		if (data == NULL) {
-			spa_log_error(impl->log, "cannot create port data: %m");
-			return -errno;
-		}
-		port->audio_mem[i] = data;
-		port->audio_data[i] = SPA_PTR_ALIGN(data, impl->max_align, void);
+	while (port->node->elided) {
+		link = spa_list_first(&port->node->input_port[0].link_list,
+				struct link, input_link);
+		port = link->output;
 	}
-	spa_log_info(impl->log, "connect output port %s[%d]:%s %p",
-			node->name, i, d->ports[port->p].name, port->audio_data[i]);
-	d->connect_port(port->node->hndl[i], port->p, port->audio_data[i]);
-	return 0;
-}
-
-static void port_free_data(struct port *port, uint32_t i)
-{
-	free(port->audio_mem[i]);
-	port->audio_mem[i] = NULL;
-	port->audio_data[i] = NULL;
+	return port;
 }
 
 static void node_free(struct node *node)
 {
-	uint32_t i, j;
-
 	spa_list_remove(&node->link);
-	for (i = 0; i < node->n_hndl; i++) {
-		for (j = 0; j < node->desc->n_output; j++)
-			port_free_data(&node->output_port[j], i);
-	}
 	node_cleanup(node);
 	descriptor_unref(node->desc);
 	free(node->input_port);
@@ -1408,6 +1476,64 @@ static void node_free(struct node *node)
 	free(node);
 }
 
+static void stop_workers(struct impl *impl)
+{
+	uint32_t i;
+
+	if (impl->n_workers == 0)
+		return;
+
+	impl->quit = true;
+	for (i = 0; i < impl->n_workers; i++)
+		sem_post(&impl->start);
+	for (i = 0; i < impl->n_workers; i++)
+		spa_thread_utils_join(impl->thread_utils, impl->workers[i], NULL);
+	impl->n_workers = 0;
+
+	sem_destroy(&impl->start);
+	sem_destroy(&impl->done);
+}
+
+static void start_workers(struct impl *impl)
+{
+	struct graph *graph = &impl->graph;
+	uint32_t i, n_workers;
+
+	if (impl->n_threads == 0 || graph->n_job < 2)
+		return;
+	if (impl->thread_utils == NULL) {
+		spa_log_warn(impl->log, "no thread utils, can't start worker threads");
+		return;
+	}
+	/* the processing thread also takes jobs */
+	n_workers = SPA_MIN(impl->n_threads, graph->n_job - 1);
+
+	sem_init(&impl->start, 0, 0);
+	sem_init(&impl->done, 0, 0);
+	impl->quit = false;
+
+	for (i = 0; i < n_workers; i++) {
+		struct spa_thread *thr;
+
+		thr = spa_thread_utils_create(impl->thread_utils,
+				&SPA_DICT_ITEMS(
+					SPA_DICT_ITEM(SPA_KEY_THREAD_NAME, "pw-filter-graph")),
+				worker_thread, impl);
+		if (thr == NULL) {
+			spa_log_warn(impl->log, "can't create worker thread: %m");
+			break;
+		}
+		spa_thread_utils_acquire_rt(impl->thread_utils, thr, -1);
+		impl->workers[impl->n_workers++] = thr;
+	}
+	if (impl->n_workers == 0) {
+		sem_destroy(&impl->start);
+		sem_destroy(&impl->done);
+	}
+	spa_log_info(impl->log, "using %d worker threads for %d jobs",
+			impl->n_workers, graph->n_job);
+}
+
 static int impl_deactivate(void *object)
 {
 	struct impl *impl = object;
@@ -1418,6 +1544,7 @@ static int impl_deactivate(void *object)
 		return 0;
 
 	graph->activated = false;
+	stop_workers(impl);
 	spa_list_for_each(node, &graph->node_list, link)
 		node_cleanup(node);
 	return 0;
@@ -1433,7 +1560,7 @@ static int impl_activate(void *object, const struct spa_dict *props)
 	struct descriptor *desc;
 	const struct spa_fga_descriptor *d;
 	const struct spa_fga_plugin *p;
-	uint32_t i, j, max_samples = impl->quantum_limit;
+	uint32_t i, j;
 	int res;
 	float *sd, *dd, *data;
 	const char *rate;
@@ -1469,21 +1596,23 @@ static int impl_activate(void *object, const struct spa_dict *props)
 	spa_list_for_each(node, &graph->node_list, link) {
 		desc = node->desc;
 		d = desc->desc;
-		if (d->flags & SPA_FGA_DESCRIPTOR_SUPPORTS_NULL_DATA) {
-			sd = dd = NULL;
-		}
-		else {
-			sd = impl->silence_data;
-			dd = impl->discard_data;
-		}
 		for (i = 0; i < node->n_hndl; i++) {
+			if (d->flags & SPA_FGA_DESCRIPTOR_SUPPORTS_NULL_DATA) {
+				sd = dd = NULL;
+			}
+			else {
+				sd = impl->silence_data;
+				/* jobs can run at the same time, give each job
+				 * its own discard buffer */
+				dd = impl->n_discard > 1 ?
+					impl->discard_data + node->job[i] * impl->quantum_limit :
+					impl->discard_data;
+			}
 			for (j = 0; j < desc->n_input; j++) {
 				port = &node->input_port[j];
 				if (!spa_list_is_empty(&port->link_list)) {
 					link = spa_list_first(&port->link_list, struct link, input_link);
-					if ((res = port_ensure_data(link->output, i, max_samples)) < 0)
-						goto error;
-					data = link->output->audio_data[i];
+					data = link_source(link)->audio_data[i];
 				} else {
 					data = sd;
 				}
@@ -1493,11 +1622,10 @@ static int impl_activate(void *object, const struct spa_dict *props)
 			}
 			for (j = 0; j < desc->n_output; j++) {
 				port = &node->output_port[j];
-				if (port->audio_data[i] == NULL) {
-					spa_log_info(impl->log, "connect output port %s[%d]:%s %p",
-						node->name, i, d->ports[port->p].name, dd);
-					d->connect_port(node->hndl[i], port->p, dd);
-				}
+				data = port->audio_data[i] ? port->audio_data[i] : dd;
+				spa_log_info(impl->log, "connect output port %s[%d]:%s %p",
+					node->name, i, d->ports[port->p].name, data);
+				d->connect_port(node->hndl[i], port->p, data);
 			}
 			for (j = 0; j < desc->n_control; j++) {
 				port = &node->control_port[j];
@@ -1534,6 +1662,7 @@ static int impl_activate(void *object, const struct spa_dict *props)
 				d->control_changed(node->hndl[i]);
 		}
 	}
+	start_workers(impl);
 
 	spa_filter_graph_emit_props_changed(&impl->hooks, SPA_DIRECTION_INPUT);
 	return 0;
@@ -1570,6 +1699,104 @@ static struct node *find_next_node(struct graph *graph)
 	return NULL;
 }
 
+/* count the input ports that read the data of an output port */
+static uint32_t port_count_readers(struct port *port)
+{
+	struct link *link;
+	uint32_t n_readers = 0;
+
+	spa_list_for_each(link, &port->link_list, output_link) {
+		struct node *peer = link->input->node;
+		if (peer->elided)
+			n_readers += port_count_readers(&peer->output_port[0]);
+		else
+			n_readers++;
+	}
+	return n_readers;
+}
+
+/* Assign the output buffers in the order the nodes run. A buffer is
+ * reused when all its readers have run. Inputs are only released after
+ * the outputs are assigned, so that the plugins never process in-place. */
+static void node_setup_buffers(struct node *node, uint32_t *free_buffers, uint32_t *n_free)
+{
+	struct graph *graph = node->graph;
+	struct descriptor *desc = node->desc;
+	struct port *port, *src;
+	struct link *link;
+	uint32_t i;
+
+	for (i = 0; i < desc->n_output; i++) {
+		port = &node->output_port[i];
+		if (spa_list_is_empty(&port->link_list))
+			continue;
+		port->n_readers = port_count_readers(port);
+		port->buffer = *n_free > 0 ? free_buffers[--(*n_free)] : graph->n_buffers++;
+	}
+	for (i = 0; i < desc->n_input; i++) {
+		port = &node->input_port[i];
+		if (spa_list_is_empty(&port->link_list))
+			continue;
+		link = spa_list_first(&port->link_list, struct link, input_link);
+		src = link_source(link);
+		if (src->buffer != SPA_ID_INVALID && --src->n_readers == 0)
+			free_buffers[(*n_free)++] = src->buffer;
+	}
+	for (i = 0; i < desc->n_output; i++) {
+		port = &node->output_port[i];
+		if (port->buffer != SPA_ID_INVALID && port->n_readers == 0)
+			free_buffers[(*n_free)++] = port->buffer;
+	}
+}
+
+static int setup_buffers(struct graph *graph, uint32_t n_hndl)
+{
+	struct impl *impl = graph->impl;
+	struct node *node;
+	struct port *port;
+	uint32_t i, j, n_ports = 0;
+	size_t stride;
+	void *data;
+
+	/* ports that did not get a buffer from the ordering are ports of nodes
+	 * that are not run, give them their own buffer so that they
+	 * stay silent. */
+	spa_list_for_each(node, &graph->node_list, link) {
+		for (j = 0; j < node->desc->n_output; j++) {
+			port = &node->output_port[j];
+			if (spa_list_is_empty(&port->link_list) || node->elided)
+				continue;
+			if (port->buffer == SPA_ID_INVALID)
+				port->buffer = graph->n_buffers++;
+			n_ports++;
+		}
+	}
+	spa_log_info(impl->log, "using %d buffers for %d linked ports",
+			graph->n_buffers, n_ports);
+
+	if (graph->n_buffers == 0)
+		return 0;
+
+	stride = SPA_ROUND_UP_N(impl->quantum_limit * sizeof(float), impl->max_align);
+	graph->buffer_mem = calloc(1, graph->n_buffers * n_hndl * stride + impl->max_align);
+	if (graph->buffer_mem == NULL)
+		return -errno;
+
+	data = SPA_PTR_ALIGN(graph->buffer_mem, impl->max_align, void);
+
+	spa_list_for_each(node, &graph->node_list, link) {
+		for (j = 0; j < node->desc->n_output; j++) {
+			port = &node->output_port[j];
+			if (port->buffer == SPA_ID_INVALID)
+				continue;
+			for (i = 0; i < n_hndl; i++)
+				port->audio_data[i] = SPA_PTROFF(data,
+						(port->buffer * n_hndl + i) * stride, float);
+		}
+	}
+	return 0;
+}
+
 static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_json *outputs)
 {
 	struct impl *impl = graph->impl;
@@ -1578,7 +1805,10 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 	struct link *link;
 	struct graph_port *gp;
 	struct graph_hndl *gh;
-	uint32_t i, j, n_nodes, n_input, n_output, n_control, n_hndl = 0;
+	uint32_t i, j, k, l, n_nodes, n_input, n_output, n_control, n_hndl = 0;
+	uint32_t n_ports, n_free, n_order, *free_buffers = NULL;
+	struct node **order = NULL;
+	bool changed;
 	int res;
 	struct descriptor *desc;
 	const struct spa_fga_descriptor *d;
@@ -1662,12 +1892,16 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 	/* now go over all nodes and create instances. */
 	n_control = 0;
 	n_nodes = 0;
+	n_ports = 0;
 	spa_list_for_each(node, &graph->node_list, link) {
 		node->n_hndl = n_hndl;
 		desc = node->desc;
 		n_control += desc->n_control;
+		n_ports += desc->n_output;
 		n_nodes++;
 		setup_node_controls(node);
+		for (i = 0; i < desc->n_output; i++)
+			node->output_port[i].buffer = SPA_ID_INVALID;
 	}
 	graph->n_input = 0;
 	graph->input = calloc(n_input * 16 * n_hndl, sizeof(struct graph_port));
@@ -1805,25 +2039,45 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 		}
 	}
 
+	/* a copy between two nodes does not need to run, the peers of the
+	 * copy can read the data of its input directly */
+	spa_list_for_each(node, &graph->node_list, link) {
+		desc = node->desc;
+		if (node->disabled || !(desc->desc->flags & SPA_FGA_DESCRIPTOR_COPY) ||
+		    desc->n_input != 1 || desc->n_output != 1 ||
+		    spa_list_is_empty(&node->input_port[0].link_list) ||
+		    node->input_port[0].external != SPA_ID_INVALID ||
+		    node->output_port[0].external != SPA_ID_INVALID)
+			continue;
+		spa_log_info(impl->log, "elide copy node %s", node->name);
+		node->disabled = true;
+		node->elided = true;
+	}
+
 	/* order all nodes based on dependencies */
 	graph->n_hndl = 0;
 	graph->hndl = calloc(n_nodes * n_hndl, sizeof(struct graph_hndl));
+	graph->n_job = 0;
+	graph->job = calloc(n_nodes * n_hndl, sizeof(struct graph_job));
 	graph->n_control = 0;
 	graph->control_port = calloc(n_control, sizeof(struct port *));
+	order = calloc(n_nodes, sizeof(struct node *));
+	free_buffers = calloc(n_ports, sizeof(uint32_t));
+	if (graph->hndl == NULL || graph->job == NULL || order == NULL ||
+	    (n_ports > 0 && free_buffers == NULL)) {
+		res = -errno;
+		goto error;
+	}
+	n_order = 0;
 	while (true) {
 		if ((node = find_next_node(graph)) == NULL)
 			break;
 
 		desc = node->desc;
-		d = desc->desc;
 
-		if (!node->disabled) {
-			for (i = 0; i < n_hndl; i++) {
-				gh = &graph->hndl[graph->n_hndl++];
-				gh->hndl = &node->hndl[i];
-				gh->desc = d;
-			}
-		}
+		node->group = n_order;
+		order[n_order++] = node;
+
 		for (i = 0; i < desc->n_output; i++) {
 			spa_list_for_each(link, &node->output_port[i].link_list, output_link)
 				link->input->node->n_deps--;
@@ -1839,8 +2093,88 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 			graph->n_control++;
 		}
 	}
-	res = 0;
+
+	/* nodes that are linked are in the same group. The group is the
+	 * position of the first node of the group in the order. */
+	do {
+		changed = false;
+		spa_list_for_each(link, &graph->link_list, link) {
+			struct node *out = link->output->node, *in = link->input->node;
+			uint32_t group;
+
+			if (!out->visited || !in->visited || out->group == in->group)
+				continue;
+			group = SPA_MIN(out->group, in->group);
+			out->group = in->group = group;
+			changed = true;
+		}
+	} while (changed);
+
+	/* The groups do not share data and can run at the same time. Each
+	 * instance of a group is also independent, unless the group has
+	 * nodes that run all instances in one go. Make a job for each
+	 * independent part. */
+	for (i = 0; i < n_order; i++) {
+		bool multi = false;
+
+		if (order[i]->group != i)
+			continue;
+
+		n_free = 0;
+		for (j = i; j < n_order; j++) {
+			node = order[j];
+			if (node->group != i || node->disabled)
+				continue;
+			node_setup_buffers(node, free_buffers, &n_free);
+			if (node->desc->desc->run_multi != NULL && n_hndl > 1)
+				multi = true;
+		}
+		for (k = 0; k < (multi ? 1u : n_hndl); k++) {
+			uint32_t start = graph->n_hndl;
+
+			for (j = i; j < n_order; j++) {
+				node = order[j];
+				if (node->group != i || node->disabled)
+					continue;
+
+				d = node->desc->desc;
+				if (multi && d->run_multi != NULL) {
+					/* run the instances of all channels in one go */
+					gh = &graph->hndl[graph->n_hndl++];
+					gh->hndl = &node->hndl[0];
+					gh->n_hndl = n_hndl;
+					gh->desc = d;
+					for (l = 0; l < n_hndl; l++)
+						node->job[l] = graph->n_job;
+				} else if (multi) {
+					for (l = 0; l < n_hndl; l++) {
+						gh = &graph->hndl[graph->n_hndl++];
+						gh->hndl = &node->hndl[l];
+						gh->n_hndl = 1;
+						gh->desc = d;
+						node->job[l] = graph->n_job;
+					}
+				} else {
+					gh = &graph->hndl[graph->n_hndl++];
+					gh->hndl = &node->hndl[k];
+					gh->n_hndl = 1;
+					gh->desc = d;
+					node->job[k] = graph->n_job;
+				}
+			}
+			if (graph->n_hndl > start) {
+				struct graph_job *job = &graph->job[graph->n_job++];
+				job->start = start;
+				job->end = graph->n_hndl;
+			}
+		}
+	}
+	spa_log_info(impl->log, "%d handles in %d jobs", graph->n_hndl, graph->n_job);
+
+	res = setup_buffers(graph, n_hndl);
 error:
+	free(order);
+	free(free_buffers);
 	return res;
 }
 
@@ -1994,7 +2328,9 @@ static void graph_free(struct graph *graph)
 	free(graph->input);
 	free(graph->output);
 	free(graph->hndl);
+	free(graph->job);
 	free(graph->control_port);
+	free(graph->buffer_mem);
 }
 
 static const struct spa_filter_graph_methods impl_filter_graph = {
@@ -2030,6 +2366,7 @@ static int impl_clear(struct spa_handle *handle)
 {
 	struct impl *impl = (struct impl *) handle;
 
+	stop_workers(impl);
 	graph_free(&impl->graph);
 
 	if (impl->dsp)
@@ -2073,6 +2410,7 @@ impl_init(const struct spa_handle_factory *factory,
 	impl->dsp = spa_fga_dsp_new(impl->cpu ? spa_cpu_get_flags(impl->cpu) : 0);
 
 	impl->loader = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_PluginLoader);
+	impl->thread_utils = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_ThreadUtils);
 
 	spa_list_init(&impl->plugin_list);
 
@@ -2085,7 +2423,10 @@ impl_init(const struct spa_handle_factory *factory,
 			spa_atou32(s, &impl->info.n_inputs, 0);
 		if (spa_streq(k, "filter-graph.n_outputs"))
 			spa_atou32(s, &impl->info.n_outputs, 0);
+		if (spa_streq(k, "filter-graph.threads"))
+			spa_atou32(s, &impl->n_threads, 0);
 	}
+	impl->n_threads = SPA_MIN(impl->n_threads, MAX_THREADS);
 	if (impl->quantum_limit == 0)
 		return -EINVAL;
 
@@ -2095,14 +2436,16 @@ impl_init(const struct spa_handle_factory *factory,
 		goto error;
 	}
 
-	impl->discard_data = calloc(impl->quantum_limit, sizeof(float));
-	if (impl->discard_data == NULL) {
-		res = -errno;
+	if ((res = load_graph(&impl->graph, info)) < 0) {
+		spa_log_error(impl->log, "can't load graph: %s", spa_strerror(res));
 		goto error;
 	}
 
-	if ((res = load_graph(&impl->graph, info)) < 0) {
-		spa_log_error(impl->log, "can't load graph: %s", spa_strerror(res));
+	impl->n_discard = impl->n_threads > 0 ? SPA_MAX(impl->graph.n_job, 1u) : 1u;
+	impl->discard_data = calloc(impl->n_discard * impl->quantum_limit, sizeof(float));
+	if (impl->discard_data == NULL) {
+		res = -errno;
+		graph_free(&impl->graph);
 		goto error;
 	}
 
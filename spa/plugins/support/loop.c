@@ -101,7 +101,16 @@ struct impl {
 	uint32_t count;
 	uint32_t flush_count;
 
+	/* shared timers, multiplexed on one timerfd */
+	struct spa_source *timer;
+	uint64_t timer_expire;		/* when the timerfd is armed, 0 is disarmed */
+	struct source_impl **timers;	/* min-heap of armed timers */
+	uint32_t n_timers;		/* number of armed timers in the heap */
+	uint32_t max_timers;		/* number of allocated heap entries */
+	uint32_t timer_count;		/* number of shared timers */
+
 	unsigned int polling:1;
+	unsigned int shared_timers:1;
 };
 
 struct queue {
@@ -136,6 +145,11 @@ struct source_impl {
 
 	struct spa_source *fallback;
 
+	/* for shared timers */
+	uint64_t expire;
+	uint64_t interval;
+	uint32_t heap_idx;
+
 	bool close;
 	bool enabled;
 };
@@ -945,6 +959,257 @@ static int loop_signal_event(void *object, struct spa_source *source)
 	return res;
 }
 
+/* Shared timers don't have a timerfd. The armed timers are kept in a min-heap
+ * sorted on the expiration time and one timerfd is armed for the first timer
+ * in the heap. */
+static inline bool heap_less(struct impl *impl, uint32_t a, uint32_t b)
+{
+	return impl->timers[a]->expire < impl->timers[b]->expire;
+}
+
+static inline void heap_swap(struct impl *impl, uint32_t a, uint32_t b)
+{
+	struct source_impl *t = impl->timers[a];
+	impl->timers[a] = impl->timers[b];
+	impl->timers[b] = t;
+	impl->timers[a]->heap_idx = a;
+	impl->timers[b]->heap_idx = b;
+}
+
+static void heap_sift_up(struct impl *impl, uint32_t idx)
+{
+	while (idx > 0) {
+		uint32_t parent = (idx - 1) / 2;
+		if (!heap_less(impl, idx, parent))
+			break;
+		heap_swap(impl, idx, parent);
+		idx = parent;
+	}
+}
+
+static void heap_sift_down(struct impl *impl, uint32_t idx)
+{
+	while (true) {
+		uint32_t l = 2 * idx + 1, r = l + 1, min = idx;
+		if (l < impl->n_timers && heap_less(impl, l, min))
+			min = l;
+		if (r < impl->n_timers && heap_less(impl, r, min))
+			min = r;
+		if (min == idx)
+			break;
+		heap_swap(impl, idx, min);
+		idx = min;
+	}
+}
+
+static void heap_insert(struct impl *impl, struct source_impl *s)
+{
+	s->heap_idx = impl->n_timers++;
+	impl->timers[s->heap_idx] = s;
+	heap_sift_up(impl, s->heap_idx);
+}
+
+static void heap_remove(struct impl *impl, struct source_impl *s)
+{
+	uint32_t idx = s->heap_idx, last = --impl->n_timers;
+
+	s->heap_idx = SPA_ID_INVALID;
+	if (idx == last)
+		return;
+	impl->timers[idx] = impl->timers[last];
+	impl->timers[idx]->heap_idx = idx;
+	heap_sift_down(impl, idx);
+	heap_sift_up(impl, idx);
+}
+
+static int shared_timer_arm(struct impl *impl)
+{
+	struct itimerspec its;
+	uint64_t expire = impl->n_timers > 0 ? impl->timers[0]->expire : 0;
+	int res;
+
+	if (expire == impl->timer_expire)
+		return 0;
+
+	spa_zero(its);
+	its.it_value.tv_sec = expire / SPA_NSEC_PER_SEC;
+	its.it_value.tv_nsec = expire % SPA_NSEC_PER_SEC;
+	if ((res = spa_system_timerfd_settime(impl->system, impl->timer->fd,
+				SPA_FD_TIMER_ABSTIME, &its, NULL)) < 0)
+		return res;
+
+	impl->timer_expire = expire;
+	return 0;
+}
+
+static void shared_timer_func(void *data, uint64_t expirations)
+{
+	struct impl *impl = data;
+	uint64_t now = get_time_ns(impl->system), count;
+	uint32_t max = impl->n_timers;
+
+	impl->timer_expire = 0;
+
+	/* only dispatch the timers that were armed when we started, timers that
+	 * are rearmed in the past from the callbacks are handled in the next
+	 * iteration */
+	while (impl->n_timers > 0 && max-- > 0) {
+		struct source_impl *s = impl->timers[0];
+
+		if (s->expire > now)
+			break;
+
+		heap_remove(impl, s);
+		if (s->interval > 0) {
+			count = 1 + (now - s->expire) / s->interval;
+			s->expire += count * s->interval;
+			heap_insert(impl, s);
+		} else {
+			count = 1;
+		}
+		/* the source can be destroyed from the callback */
+		s->func.timer(s->source.data, count);
+	}
+	shared_timer_arm(impl);
+}
+
+static void source_shared_timer_func(struct spa_source *source)
+{
+	/* never called, shared timers are not added to the poll */
+}
+
+static int do_add_shared_timer(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data)
+{
+	struct impl *impl = user_data;
+
+	if (impl->timer_count >= impl->max_timers) {
+		uint32_t max = SPA_MAX(impl->max_timers * 2, 64u);
+		struct source_impl **timers;
+
+		timers = reallocarray(impl->timers, max, sizeof(struct source_impl *));
+		if (timers == NULL)
+			return -errno;
+		impl->timers = timers;
+		impl->max_timers = max;
+	}
+	impl->timer_count++;
+	return 0;
+}
+
+static struct spa_source *loop_add_shared_timer(struct impl *impl,
+					 spa_source_timer_func_t func, void *data)
+{
+	struct source_impl *source;
+	int res;
+
+	source = calloc(1, sizeof(struct source_impl));
+	if (source == NULL) {
+		res = -errno;
+		goto error_exit;
+	}
+
+	/* the heap can only be resized from the thread of the loop */
+	if (loop_check(impl))
+		res = do_add_shared_timer(&impl->loop, false, 0, NULL, 0, impl);
+	else
+		res = loop_invoke(impl, do_add_shared_timer, 0, NULL, 0, true, impl);
+	if (res < 0) {
+		free(source);
+		goto error_exit;
+	}
+
+	source->source.loop = &impl->loop;
+	source->source.func = source_shared_timer_func;
+	source->source.data = data;
+	source->source.fd = -1;
+	source->impl = impl;
+	source->func.timer = func;
+	source->heap_idx = SPA_ID_INVALID;
+
+	spa_list_insert(&impl->source_list, &source->link);
+
+	return &source->source;
+
+error_exit:
+	errno = -res;
+	return NULL;
+}
+
+struct shared_timer_update {
+	uint64_t expire;
+	uint64_t interval;
+	bool absolute;
+};
+
+static int do_update_shared_timer(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data)
+{
+	struct source_impl *s = user_data;
+	struct impl *impl = s->impl;
+	const struct shared_timer_update *u = data;
+	uint64_t expire = u->expire;
+
+	if (s->heap_idx != SPA_ID_INVALID)
+		heap_remove(impl, s);
+
+	s->interval = u->interval;
+
+	/* like timerfd, a zero value disarms the timer */
+	if (expire != 0) {
+		if (!u->absolute)
+			expire += get_time_ns(impl->system);
+		s->expire = expire;
+		heap_insert(impl, s);
+	}
+	return shared_timer_arm(impl);
+}
+
+/* The heap is only used from the thread of the loop, updates from other
+ * threads are done with an invoke, like a timerfd_settime() on the loop
+ * would be. */
+static int update_shared_timer(struct impl *impl, struct source_impl *s,
+		struct timespec *value, struct timespec *interval, bool absolute)
+{
+	struct shared_timer_update u;
+
+	spa_zero(u);
+	if (SPA_LIKELY(value)) {
+		u.expire = SPA_TIMESPEC_TO_NSEC(value);
+	} else if (interval) {
+		// timer initially fires after one interval
+		u.expire = SPA_TIMESPEC_TO_NSEC(interval);
+		absolute = false;
+	}
+	u.interval = interval ? SPA_TIMESPEC_TO_NSEC(interval) : 0;
+	u.absolute = absolute;
+
+	if (loop_check(impl))
+		return do_update_shared_timer(&impl->loop, false, 0, &u, sizeof(u), s);
+
+	return loop_invoke(impl, do_update_shared_timer, 0, &u, sizeof(u), true, s);
+}
+
+static int do_remove_shared_timer(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data)
+{
+	struct source_impl *s = user_data;
+	struct impl *impl = s->impl;
+
+	if (s->heap_idx != SPA_ID_INVALID)
+		heap_remove(impl, s);
+	impl->timer_count--;
+	return 0;
+}
+
+static void remove_shared_timer(struct impl *impl, struct source_impl *s)
+{
+	if (loop_check(impl))
+		do_remove_shared_timer(&impl->loop, false, 0, NULL, 0, s);
+	else
+		loop_invoke(impl, do_remove_shared_timer, 0, NULL, 0, true, s);
+}
+
 static void source_timer_func(struct spa_source *source)
 {
 	struct source_impl *s = SPA_CONTAINER_OF(source, struct source_impl, source);
@@ -968,6 +1233,9 @@ static struct spa_source *loop_add_timer(void *object,
 	struct source_impl *source;
 	int res;
 
+	if (impl->shared_timers)
+		return loop_add_shared_timer(impl, func, data);
+
 	source = calloc(1, sizeof(struct source_impl));
 	if (source == NULL)
 		goto error_exit;
@@ -1009,6 +1277,10 @@ loop_update_timer(void *object, struct spa_source *source,
 	int flags = 0, res;
 
 	spa_assert(s->impl == object);
+
+	if (source->func == source_shared_timer_func)
+		return update_shared_timer(s->impl, s, value, interval, absolute);
+
 	spa_assert(source->func == source_timer_func);
 
 	spa_zero(its);
@@ -1096,6 +1368,8 @@ static void loop_destroy_source(void *object, struct spa_source *source)
 
 	if (s->fallback)
 		loop_destroy_source(s->impl, s->fallback);
+	else if (source->func == source_shared_timer_func)
+		remove_shared_timer(s->impl, s);
 	else
 		remove_from_poll(s->impl, source);
 
@@ -1193,6 +1467,7 @@ static int impl_clear(struct spa_handle *handle)
 		loop_destroy_source(impl, &source->source);
 	for (i = 0; i < impl->n_queues; i++)
 		loop_queue_destroy(impl->queues[i]);
+	free(impl->timers);
 
 	spa_system_close(impl->system, impl->poll_fd);
 
@@ -1253,6 +1528,8 @@ impl_init(const struct spa_handle_factory *factory,
 	impl->rate_limit.burst = 1;
 	impl->retry_timeout = DEFAULT_RETRY;
 	if (info) {
+		if ((str = spa_dict_lookup(info, "loop.shared-timers")) != NULL)
+			impl->shared_timers = spa_atob(str);
 		if ((str = spa_dict_lookup(info, "loop.cancel")) != NULL &&
 		    spa_atob(str))
 			impl->control.iface.cb.funcs = &impl_loop_control_cancel;
@@ -1290,6 +1567,18 @@ impl_init(const struct spa_handle_factory *factory,
 		spa_log_error(impl->log, "%p: can't create wakeup event: %m", impl);
 		goto error_exit_free_poll;
 	}
+	if (impl->shared_timers) {
+		/* make the timerfd for the shared timers first, all other timers
+		 * will then use it */
+		impl->shared_timers = false;
+		impl->timer = loop_add_timer(impl, shared_timer_func, impl);
+		if (impl->timer == NULL) {
+			res = -errno;
+			spa_log_error(impl->log, "%p: can't create timer: %m", impl);
+			goto error_exit_free_wakeup;
+		}
+		impl->shared_timers = true;
+	}
 
 	impl->head.t.idx = IDX_INVALID;
 
@@ -1297,6 +1586,8 @@ impl_init(const struct spa_handle_factory *factory,
 
 	return 0;
 
+error_exit_free_wakeup:
+	loop_destroy_source(impl, impl->wakeup);
 error_exit_free_poll:
 	spa_system_close(impl->system, impl->poll_fd);
 error_exit_free_mutex:
@@ -0,0 +1,1088 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+
+#include <linux/io_uring.h>
+
+#include <spa/support/log.h>
+#include <spa/support/system.h>
+#include <spa/support/plugin.h>
+#include <spa/utils/list.h>
+#include <spa/utils/names.h>
+#include <spa/utils/type.h>
+#include <spa/utils/result.h>
+#include <spa/utils/string.h>
+
+#undef SPA_LOG_TOPIC_DEFAULT
+#define SPA_LOG_TOPIC_DEFAULT &log_topic
+SPA_LOG_TOPIC_DEFINE_STATIC(log_topic, "spa.uring-system");
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#  define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+#define RING_ENTRIES	1024
+
+/* the low bits of the user_data of a submission hold the kind of operation,
+ * the other bits are the pointer to the entry */
+#define OP_NONE		0
+#define OP_POLL		1
+#define OP_POLL_LINK	2
+#define OP_READ		3
+#define OP_MASK		7
+
+/* fds created by us that can be read by the ring */
+#define FD_TYPE_NONE	0
+#define FD_TYPE_EVENT	1
+#define FD_TYPE_TIMER	2
+
+/* the fd info is kept in chunks that are never freed so that it can be
+ * looked up without the lock */
+#define FD_CHUNK_BITS	10
+#define FD_CHUNK_SIZE	(1u << FD_CHUNK_BITS)
+#define MAX_FD_CHUNKS	1024u
+
+struct ring;
+
+struct entry {
+	struct ring *ring;
+	struct spa_list link;		/**< in ready or rearm list */
+	int fd;
+	uint32_t events;
+	void *data;
+	uint64_t value;			/**< value read by the ring */
+	uint32_t has_value;		/**< value is valid, atomic */
+	uint32_t revents;
+	uint32_t inflight;
+	unsigned int read_mode:1;	/**< the ring reads the fd */
+	unsigned int armed:1;
+	unsigned int removed:1;
+	unsigned int listed:1;
+};
+
+struct ring {
+	struct spa_list link;
+	int fd;
+
+	void *sq_ptr;
+	size_t sq_size;
+	uint32_t *sq_head;
+	uint32_t *sq_tail;
+	uint32_t sq_mask;
+	uint32_t *sq_array;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	uint32_t sq_entries;
+	uint32_t n_pending;
+
+	void *cq_ptr;
+	size_t cq_size;
+	uint32_t *cq_head;
+	uint32_t *cq_tail;
+	uint32_t cq_mask;
+	struct io_uring_cqe *cqes;
+
+	struct entry **fds;
+	uint32_t n_fds;
+
+	struct spa_list ready;
+	struct spa_list rearm;
+	struct spa_list removed;
+};
+
+struct fd_info {
+	uint32_t type;			/**< FD_TYPE_ of the fd, with the lock */
+	struct entry *reader;		/**< entry that reads the fd, atomic */
+};
+
+struct impl {
+	struct spa_handle handle;
+	struct spa_system system;
+
+        struct spa_log *log;
+
+	pthread_mutex_t lock;
+	struct spa_list rings;
+
+	struct fd_info *fd_info[MAX_FD_CHUNKS];
+};
+
+static int sys_io_uring_setup(uint32_t entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete,
+		uint32_t flags, void *arg, size_t argsz)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+/* can be called without the lock when create is false */
+static struct fd_info *get_fd_info(struct impl *impl, int fd, bool create)
+{
+	struct fd_info *chunk;
+	uint32_t idx;
+
+	if (fd < 0 || (uint32_t)fd >= MAX_FD_CHUNKS * FD_CHUNK_SIZE)
+		return NULL;
+
+	idx = (uint32_t)fd >> FD_CHUNK_BITS;
+	chunk = __atomic_load_n(&impl->fd_info[idx], __ATOMIC_ACQUIRE);
+	if (chunk == NULL && create) {
+		if ((chunk = calloc(FD_CHUNK_SIZE, sizeof(struct fd_info))) == NULL)
+			return NULL;
+		__atomic_store_n(&impl->fd_info[idx], chunk, __ATOMIC_RELEASE);
+	}
+	return chunk ? &chunk[fd & (FD_CHUNK_SIZE - 1)] : NULL;
+}
+
+/* must be called with the lock */
+static void set_fd_type(struct impl *impl, int fd, uint32_t type)
+{
+	struct fd_info *info;
+
+	if ((info = get_fd_info(impl, fd, type != FD_TYPE_NONE)) == NULL)
+		return;
+	info->type = type;
+	__atomic_store_n(&info->reader, NULL, __ATOMIC_RELEASE);
+}
+
+static uint32_t get_fd_type(struct impl *impl, int fd)
+{
+	struct fd_info *info = get_fd_info(impl, fd, false);
+	return info ? info->type : FD_TYPE_NONE;
+}
+
+static struct entry *get_fd_reader(struct impl *impl, int fd)
+{
+	struct fd_info *info = get_fd_info(impl, fd, false);
+	return info ? __atomic_load_n(&info->reader, __ATOMIC_ACQUIRE) : NULL;
+}
+
+static struct ring *find_ring(struct impl *impl, int pfd)
+{
+	struct ring *r;
+	spa_list_for_each(r, &impl->rings, link)
+		if (r->fd == pfd)
+			return r;
+	return NULL;
+}
+
+static struct entry *find_entry(struct ring *r, int fd)
+{
+	if (fd < 0 || (uint32_t)fd >= r->n_fds)
+		return NULL;
+	return r->fds[fd];
+}
+
+static int ring_enter(struct ring *r, uint32_t n, uint32_t min_complete, uint32_t flags,
+		struct io_uring_getevents_arg *arg, uint32_t *submitted)
+{
+	int res;
+
+	res = sys_io_uring_enter(r->fd, n, min_complete, flags,
+			arg, arg ? sizeof(*arg) : 0);
+	if (res < 0) {
+		res = -errno;
+		/* with a timeout, the submissions are done before waiting */
+		*submitted = (res == -ETIME || res == -EINTR) && (flags & IORING_ENTER_GETEVENTS) ? n : 0;
+	} else {
+		*submitted = SPA_MIN((uint32_t)res, n);
+	}
+	return res;
+}
+
+/* must be called with the lock */
+static int ring_submit(struct ring *r)
+{
+	uint32_t n = r->n_pending, submitted;
+	int res;
+
+	if (n == 0)
+		return 0;
+	res = ring_enter(r, n, 0, 0, NULL, &submitted);
+	r->n_pending -= submitted;
+	return res;
+}
+
+static int ring_reserve(struct ring *r, uint32_t n)
+{
+	uint32_t tail = *r->sq_tail;
+
+	if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) + n <= r->sq_entries)
+		return 0;
+	/* full, flush what we have and try again */
+	ring_submit(r);
+	if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) + n <= r->sq_entries)
+		return 0;
+	return -EBUSY;
+}
+
+static struct io_uring_sqe *ring_get_sqe(struct ring *r)
+{
+	uint32_t tail;
+	struct io_uring_sqe *sqe;
+
+	if (ring_reserve(r, 1) < 0)
+		return NULL;
+
+	tail = *r->sq_tail;
+	sqe = &r->sqes[tail & r->sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	r->sq_array[tail & r->sq_mask] = tail & r->sq_mask;
+	__atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	r->n_pending++;
+	return sqe;
+}
+
+static int entry_arm(struct ring *r, struct entry *e)
+{
+	struct io_uring_sqe *sqe;
+
+	if (e->armed)
+		return 0;
+
+	if (e->read_mode) {
+		/* poll and read in one go, the read is only started when the
+		 * poll completes so that a nonblocking fd does not fail */
+		if (ring_reserve(r, 2) < 0 || (sqe = ring_get_sqe(r)) == NULL)
+			return -EBUSY;
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->fd = e->fd;
+		sqe->poll_events = POLLIN;
+		sqe->flags = IOSQE_IO_LINK;
+		sqe->user_data = (uint64_t)(uintptr_t)e | OP_POLL_LINK;
+
+		if ((sqe = ring_get_sqe(r)) == NULL)
+			return -EBUSY;
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = e->fd;
+		sqe->addr = (uint64_t)(uintptr_t)&e->value;
+		sqe->len = sizeof(e->value);
+		sqe->off = (uint64_t)-1;
+		sqe->user_data = (uint64_t)(uintptr_t)e | OP_READ;
+		e->inflight += 2;
+	} else {
+		if ((sqe = ring_get_sqe(r)) == NULL)
+			return -EBUSY;
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->fd = e->fd;
+		sqe->poll_events = e->events & 0xffff;
+		sqe->user_data = (uint64_t)(uintptr_t)e | OP_POLL;
+		e->inflight++;
+	}
+	e->armed = true;
+	return 0;
+}
+
+static void entry_unlist(struct entry *e)
+{
+	if (e->listed) {
+		spa_list_remove(&e->link);
+		e->listed = false;
+	}
+}
+
+static void entry_list(struct entry *e, struct spa_list *list)
+{
+	entry_unlist(e);
+	spa_list_append(list, &e->link);
+	e->listed = true;
+}
+
+static void entry_cancel(struct ring *r, struct entry *e)
+{
+	struct io_uring_sqe *sqe;
+
+	if (e->armed && (sqe = ring_get_sqe(r)) != NULL) {
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = (uint64_t)(uintptr_t)e |
+			(e->read_mode ? OP_POLL_LINK : OP_POLL);
+		sqe->user_data = OP_NONE;
+	}
+}
+
+static void entry_remove(struct impl *impl, struct ring *r, struct entry *e)
+{
+	struct fd_info *info;
+
+	entry_cancel(r, e);
+
+	if ((info = get_fd_info(impl, e->fd, false)) != NULL &&
+	    __atomic_load_n(&info->reader, __ATOMIC_RELAXED) == e)
+		__atomic_store_n(&info->reader, NULL, __ATOMIC_RELEASE);
+
+	r->fds[e->fd] = NULL;
+	e->removed = true;
+	/* the entry can still be used by a reader in the thread of the loop,
+	 * it is freed from the wait after the last completion arrived */
+	entry_list(e, &r->removed);
+}
+
+static void ring_free_removed(struct ring *r)
+{
+	struct entry *e, *t;
+
+	spa_list_for_each_safe(e, t, &r->removed, link) {
+		if (e->inflight > 0)
+			continue;
+		entry_unlist(e);
+		free(e);
+	}
+}
+
+static void ring_free(struct ring *r)
+{
+	struct entry *e;
+	uint32_t i;
+
+	for (i = 0; i < r->n_fds; i++) {
+		if ((e = r->fds[i]) != NULL)
+			free(e);
+	}
+	spa_list_consume(e, &r->removed, link) {
+		spa_list_remove(&e->link);
+		free(e);
+	}
+	free(r->fds);
+	if (r->sqes != NULL && r->sqes != MAP_FAILED)
+		munmap(r->sqes, r->sqes_size);
+	if (r->cq_ptr != NULL && r->cq_ptr != MAP_FAILED && r->cq_ptr != r->sq_ptr)
+		munmap(r->cq_ptr, r->cq_size);
+	if (r->sq_ptr != NULL && r->sq_ptr != MAP_FAILED)
+		munmap(r->sq_ptr, r->sq_size);
+	if (r->fd >= 0)
+		close(r->fd);
+	free(r);
+}
+
+static int ring_new(struct impl *impl, struct ring **ring)
+{
+	struct io_uring_params p;
+	struct ring *r;
+	int res;
+
+	if ((r = calloc(1, sizeof(*r))) == NULL)
+		return -errno;
+
+	spa_list_init(&r->ready);
+	spa_list_init(&r->rearm);
+	spa_list_init(&r->removed);
+
+	spa_zero(p);
+	p.flags = IORING_SETUP_CLAMP;
+	if ((r->fd = sys_io_uring_setup(RING_ENTRIES, &p)) < 0) {
+		res = -errno;
+		goto error;
+	}
+	if (!(p.features & IORING_FEAT_EXT_ARG) ||
+	    !(p.features & IORING_FEAT_NODROP)) {
+		spa_log_error(impl->log, "%p: io_uring is missing required features 0x%08x",
+				impl, p.features);
+		res = -ENOTSUP;
+		goto error;
+	}
+
+	r->sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+	r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_size = r->cq_size = SPA_MAX(r->sq_size, r->cq_size);
+
+	r->sq_ptr = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ptr == MAP_FAILED) {
+		res = -errno;
+		goto error;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		r->cq_ptr = r->sq_ptr;
+	} else {
+		r->cq_ptr = mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (r->cq_ptr == MAP_FAILED) {
+			res = -errno;
+			goto error;
+		}
+	}
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		res = -errno;
+		goto error;
+	}
+
+	r->sq_head = SPA_PTROFF(r->sq_ptr, p.sq_off.head, uint32_t);
+	r->sq_tail = SPA_PTROFF(r->sq_ptr, p.sq_off.tail, uint32_t);
+	r->sq_mask = *SPA_PTROFF(r->sq_ptr, p.sq_off.ring_mask, uint32_t);
+	r->sq_array = SPA_PTROFF(r->sq_ptr, p.sq_off.array, uint32_t);
+	r->sq_entries = p.sq_entries;
+
+	r->cq_head = SPA_PTROFF(r->cq_ptr, p.cq_off.head, uint32_t);
+	r->cq_tail = SPA_PTROFF(r->cq_ptr, p.cq_off.tail, uint32_t);
+	r->cq_mask = *SPA_PTROFF(r->cq_ptr, p.cq_off.ring_mask, uint32_t);
+	r->cqes = SPA_PTROFF(r->cq_ptr, p.cq_off.cqes, struct io_uring_cqe);
+
+	*ring = r;
+	return 0;
+error:
+	ring_free(r);
+	return res;
+}
+
+static ssize_t impl_read(void *object, int fd, void *buf, size_t count)
+{
+	ssize_t res = read(fd, buf, count);
+	return res < 0 ? -errno : res;
+}
+
+static ssize_t impl_write(void *object, int fd, const void *buf, size_t count)
+{
+	ssize_t res = write(fd, buf, count);
+	return res < 0 ? -errno : res;
+}
+
+static int impl_ioctl(void *object, int fd, unsigned long request, ...)
+{
+	int res;
+	va_list ap;
+	long arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, long);
+	res = ioctl(fd, request, arg);
+	va_end(ap);
+
+	return res < 0 ? -errno : res;
+}
+
+static int impl_close(void *object, int fd)
+{
+	struct impl *impl = object;
+	struct ring *r;
+	int res;
+
+	pthread_mutex_lock(&impl->lock);
+	/* the fd number can be reused for anything after this */
+	set_fd_type(impl, fd, FD_TYPE_NONE);
+	if ((r = find_ring(impl, fd)) != NULL) {
+		spa_list_remove(&r->link);
+		ring_free(r);
+		res = 0;
+	} else {
+		res = close(fd);
+	}
+	pthread_mutex_unlock(&impl->lock);
+
+	spa_log_debug(impl->log, "%p: close fd:%d", impl, fd);
+	return res < 0 ? -errno : res;
+}
+
+/* clock */
+static int impl_clock_gettime(void *object,
+			int clockid, struct timespec *value)
+{
+	int res = clock_gettime(clockid, value);
+	return res < 0 ? -errno : res;
+}
+
+static int impl_clock_getres(void *object,
+			int clockid, struct timespec *res)
+{
+	int r = clock_getres(clockid, res);
+	return r < 0 ? -errno : r;
+}
+
+/* poll */
+static int impl_pollfd_create(void *object, int flags)
+{
+	struct impl *impl = object;
+	struct ring *r;
+	int res;
+
+	if ((res = ring_new(impl, &r)) < 0) {
+		spa_log_error(impl->log, "%p: can't create ring: %s",
+				impl, spa_strerror(res));
+		return res;
+	}
+	pthread_mutex_lock(&impl->lock);
+	spa_list_append(&impl->rings, &r->link);
+	pthread_mutex_unlock(&impl->lock);
+
+	spa_log_debug(impl->log, "%p: new fd:%d", impl, r->fd);
+	return r->fd;
+}
+
+/* eventfd and timerfd that only want to be woken up for reading are
+ * read by the ring, the value is then returned from eventfd_read or
+ * timerfd_read without another system call */
+static bool entry_read_mode(struct impl *impl, int fd, uint32_t events)
+{
+	return get_fd_type(impl, fd) != FD_TYPE_NONE &&
+		(events & ~(SPA_IO_ERR | SPA_IO_HUP)) == SPA_IO_IN;
+}
+
+static int do_pollfd_add(struct impl *impl, struct ring *r, int fd, uint32_t events, void *data)
+{
+	struct fd_info *info;
+	struct entry *e;
+	int res;
+
+	if (fd < 0)
+		return -EBADF;
+	if (find_entry(r, fd) != NULL)
+		return -EEXIST;
+
+	if ((uint32_t)fd >= r->n_fds) {
+		uint32_t n = SPA_ROUND_UP_N((uint32_t)fd + 1, 64u);
+		struct entry **fds;
+		if ((fds = realloc(r->fds, n * sizeof(struct entry*))) == NULL)
+			return -errno;
+		memset(&fds[r->n_fds], 0, (n - r->n_fds) * sizeof(struct entry*));
+		r->fds = fds;
+		r->n_fds = n;
+	}
+	if ((e = calloc(1, sizeof(*e))) == NULL)
+		return -errno;
+
+	e->ring = r;
+	e->fd = fd;
+	e->events = events;
+	e->data = data;
+	e->read_mode = entry_read_mode(impl, fd, events);
+
+	r->fds[fd] = e;
+	if ((res = entry_arm(r, e)) < 0) {
+		r->fds[fd] = NULL;
+		free(e);
+		return res;
+	}
+	if (get_fd_type(impl, fd) != FD_TYPE_NONE &&
+	    (info = get_fd_info(impl, fd, false)) != NULL)
+		__atomic_store_n(&info->reader, e, __ATOMIC_RELEASE);
+	return 0;
+}
+
+static int impl_pollfd_add(void *object, int pfd, int fd, uint32_t events, void *data)
+{
+	struct impl *impl = object;
+	struct ring *r;
+	int res;
+
+	pthread_mutex_lock(&impl->lock);
+	if ((r = find_ring(impl, pfd)) == NULL)
+		res = -EBADF;
+	else if ((res = do_pollfd_add(impl, r, fd, events, data)) >= 0)
+		res = ring_submit(r);
+	pthread_mutex_unlock(&impl->lock);
+
+	return res < 0 ? res : 0;
+}
+
+static int impl_pollfd_mod(void *object, int pfd, int fd, uint32_t events, void *data)
+{
+	struct impl *impl = object;
+	struct ring *r;
+	struct entry *e;
+	int res;
+
+	pthread_mutex_lock(&impl->lock);
+	if ((r = find_ring(impl, pfd)) == NULL) {
+		res = -EBADF;
+	} else if ((e = find_entry(r, fd)) == NULL) {
+		res = -ENOENT;
+	} else {
+		bool read_mode = entry_read_mode(impl, fd, events);
+
+		/* modify in place so that a value that was read by the ring is
+		 * kept, the poll is canceled and rearmed with the new events */
+		e->data = data;
+		if (events != e->events || read_mode != e->read_mode) {
+			entry_cancel(r, e);
+			e->events = events;
+			e->read_mode = read_mode;
+		}
+		res = ring_submit(r);
+	}
+	pthread_mutex_unlock(&impl->lock);
+
+	return res < 0 ? res : 0;
+}
+
+static int impl_pollfd_del(void *object, int pfd, int fd)
+{
+	struct impl *impl = object;
+	struct ring *r;
+	struct entry *e;
+	int res;
+
+	pthread_mutex_lock(&impl->lock);
+	if ((r = find_ring(impl, pfd)) == NULL) {
+		res = -EBADF;
+	} else if ((e = find_entry(r, fd)) == NULL) {
+		res = -ENOENT;
+	} else {
+		entry_remove(impl, r, e);
+		res = ring_submit(r);
+	}
+	pthread_mutex_unlock(&impl->lock);
+
+	return res < 0 ? res : 0;
+}
+
+static void entry_ready(struct ring *r, struct entry *e, uint32_t revents)
+{
+	e->revents |= revents;
+	entry_list(e, &r->ready);
+}
+
+static void ring_complete(struct ring *r, struct io_uring_cqe *cqe)
+{
+	struct entry *e = (struct entry*)(uintptr_t)(cqe->user_data & ~(uint64_t)OP_MASK);
+	uint32_t op = cqe->user_data & OP_MASK;
+
+	if (op == OP_NONE || e == NULL)
+		return;
+
+	e->inflight--;
+	if (e->removed)
+		return;
+
+	switch (op) {
+	case OP_POLL:
+		e->armed = false;
+		if (cqe->res > 0)
+			entry_ready(r, e, cqe->res &
+					(e->events | SPA_IO_ERR | SPA_IO_HUP));
+		else if (cqe->res < 0 && cqe->res != -ECANCELED)
+			entry_ready(r, e, SPA_IO_ERR);
+		else
+			entry_list(e, &r->rearm);
+		break;
+	case OP_POLL_LINK:
+		/* the read completion follows */
+		if (cqe->res < 0 && cqe->res != -ECANCELED)
+			e->revents |= SPA_IO_ERR;
+		break;
+	case OP_READ:
+		e->armed = false;
+		if (cqe->res == sizeof(e->value)) {
+			__atomic_store_n(&e->has_value, 1, __ATOMIC_RELEASE);
+			entry_ready(r, e, SPA_IO_IN);
+		} else if (e->revents & SPA_IO_ERR) {
+			entry_ready(r, e, 0);
+		} else {
+			entry_list(e, &r->rearm);
+		}
+		break;
+	}
+}
+
+/* must be called with the lock */
+static void ring_reap(struct ring *r)
+{
+	uint32_t head, tail;
+
+	head = *r->cq_head;
+	tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		ring_complete(r, &r->cqes[head & r->cq_mask]);
+		head++;
+	}
+	__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static int impl_pollfd_wait(void *object, int pfd,
+		struct spa_poll_event *ev, int n_ev, int timeout)
+{
+	struct impl *impl = object;
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	struct ring *r;
+	struct entry *e, *t;
+	uint32_t n_submit, submitted = 0;
+	int res = 0, n = 0;
+
+	pthread_mutex_lock(&impl->lock);
+	if ((r = find_ring(impl, pfd)) == NULL) {
+		pthread_mutex_unlock(&impl->lock);
+		return -EBADF;
+	}
+	/* rearm the entries that were reported in the previous round, they are
+	 * submitted together with the wait. Values that were not read yet are
+	 * reported again, like a level triggered epoll would. */
+	spa_list_for_each_safe(e, t, &r->rearm, link) {
+		if (__atomic_load_n(&e->has_value, __ATOMIC_ACQUIRE))
+			entry_ready(r, e, SPA_IO_IN);
+		else if (entry_arm(r, e) >= 0)
+			entry_unlist(e);
+	}
+	if (!spa_list_is_empty(&r->ready))
+		timeout = 0;
+	n_submit = r->n_pending;
+	pthread_mutex_unlock(&impl->lock);
+
+	/* submissions and completions are only handled with the lock, the
+	 * kernel does not need it so we can wait without it */
+	if (n_submit > 0 || timeout != 0) {
+		spa_zero(arg);
+		if (timeout >= 0) {
+			ts.tv_sec = timeout / 1000;
+			ts.tv_nsec = (timeout % 1000) * 1000000LL;
+			arg.ts = (uint64_t)(uintptr_t)&ts;
+		}
+		res = ring_enter(r, n_submit, timeout == 0 ? 0 : 1,
+				IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+				&submitted);
+	}
+
+	pthread_mutex_lock(&impl->lock);
+	r->n_pending -= submitted;
+	if (res < 0 && res != -ETIME) {
+		pthread_mutex_unlock(&impl->lock);
+		return res;
+	}
+	ring_reap(r);
+	ring_free_removed(r);
+
+	spa_list_for_each_safe(e, t, &r->ready, link) {
+		if (n >= n_ev)
+			break;
+		ev[n].events = e->revents;
+		ev[n].data = e->data;
+		n++;
+		e->revents = 0;
+		entry_list(e, &r->rearm);
+	}
+	pthread_mutex_unlock(&impl->lock);
+
+	return n;
+}
+
+/* timers */
+static int impl_timerfd_create(void *object, int clockid, int flags)
+{
+	struct impl *impl = object;
+	int fl = 0, res;
+	if (flags & SPA_FD_CLOEXEC)
+		fl |= TFD_CLOEXEC;
+	if (flags & SPA_FD_NONBLOCK)
+		fl |= TFD_NONBLOCK;
+	res = timerfd_create(clockid, fl);
+	spa_log_debug(impl->log, "%p: new fd:%d", impl, res);
+	if (res < 0)
+		return -errno;
+	if (flags & SPA_FD_NONBLOCK) {
+		pthread_mutex_lock(&impl->lock);
+		set_fd_type(impl, res, FD_TYPE_TIMER);
+		pthread_mutex_unlock(&impl->lock);
+	}
+	return res;
+}
+
+static int impl_timerfd_settime(void *object,
+			int fd, int flags,
+			const struct itimerspec *new_value,
+			struct itimerspec *old_value)
+{
+	struct impl *impl = object;
+	struct entry *e;
+	int fl = 0, res;
+	if (flags & SPA_FD_TIMER_ABSTIME)
+		fl |= TFD_TIMER_ABSTIME;
+	if (flags & SPA_FD_TIMER_CANCEL_ON_SET)
+		fl |= TFD_TIMER_CANCEL_ON_SET;
+	res = timerfd_settime(fd, fl, new_value, old_value);
+	if (res < 0)
+		return -errno;
+
+	/* setting the timer clears the expirations, drop what we already read */
+	if ((e = get_fd_reader(impl, fd)) != NULL)
+		__atomic_store_n(&e->has_value, 0, __ATOMIC_RELEASE);
+	return res;
+}
+
+static int impl_timerfd_gettime(void *object,
+			int fd, struct itimerspec *curr_value)
+{
+	int res = timerfd_gettime(fd, curr_value);
+	return res < 0 ? -errno : res;
+
+}
+
+static inline bool take_value(struct entry *e, uint64_t *value)
+{
+	uint64_t v;
+
+	/* the ring only reads into the value again after it was taken */
+	if (!__atomic_load_n(&e->has_value, __ATOMIC_ACQUIRE))
+		return false;
+	v = e->value;
+	if (!__atomic_exchange_n(&e->has_value, 0, __ATOMIC_ACQ_REL))
+		return false;
+	*value = v;
+	return true;
+}
+
+static int read_value(struct impl *impl, int fd, uint64_t *value)
+{
+	struct entry *e;
+	int res = 0;
+
+	/* a value that the ring already read is taken without the lock */
+	e = get_fd_reader(impl, fd);
+	if (e != NULL && take_value(e, value))
+		return 0;
+
+	/* nothing was read yet, read the fd ourselves. When the poll of the
+	 * ring already completed, its linked read fails with EAGAIN now and the
+	 * entry is rearmed, otherwise the poll stays pending */
+	if (read(fd, value, sizeof(uint64_t)) == sizeof(uint64_t))
+		return 0;
+	res = -errno;
+
+	if (res == -EAGAIN && e != NULL && e->read_mode) {
+		/* the read of the ring might have taken the value and its
+		 * completion is still in the queue, reap it with the lock */
+		pthread_mutex_lock(&impl->lock);
+		ring_reap(e->ring);
+		if (take_value(e, value))
+			res = 0;
+		pthread_mutex_unlock(&impl->lock);
+	}
+	return res;
+}
+
+static int impl_timerfd_read(void *object, int fd, uint64_t *expirations)
+{
+	return read_value(object, fd, expirations);
+}
+
+/* events */
+static int impl_eventfd_create(void *object, int flags)
+{
+	struct impl *impl = object;
+	int fl = 0, res, err;
+	if (flags & SPA_FD_CLOEXEC)
+		fl |= EFD_CLOEXEC;
+	if (flags & SPA_FD_NONBLOCK)
+		fl |= EFD_NONBLOCK;
+	if (flags & SPA_FD_EVENT_SEMAPHORE)
+		fl |= EFD_SEMAPHORE;
+	res = eventfd(0, fl);
+	err = -errno; /* save errno in case it is overwritten before return */
+	spa_log_debug(impl->log, "%p: new fd:%d", impl, res);
+	if (res < 0)
+		return err;
+	if (flags & SPA_FD_NONBLOCK) {
+		pthread_mutex_lock(&impl->lock);
+		set_fd_type(impl, res, FD_TYPE_EVENT);
+		pthread_mutex_unlock(&impl->lock);
+	}
+	return res;
+}
+
+static int impl_eventfd_write(void *object, int fd, uint64_t count)
+{
+	if (write(fd, &count, sizeof(uint64_t)) != sizeof(uint64_t))
+		return -errno;
+	return 0;
+}
+
+static int impl_eventfd_read(void *object, int fd, uint64_t *count)
+{
+	return read_value(object, fd, count);
+}
+
+/* signals */
+static int impl_signalfd_create(void *object, int signal, int flags)
+{
+	struct impl *impl = object;
+	sigset_t mask;
+	int res, fl = 0;
+
+	if (flags & SPA_FD_CLOEXEC)
+		fl |= SFD_CLOEXEC;
+	if (flags & SPA_FD_NONBLOCK)
+		fl |= SFD_NONBLOCK;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, signal);
+	res = signalfd(-1, &mask, fl);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	spa_log_debug(impl->log, "%p: new fd:%d", impl, res);
+
+	return res < 0 ? -errno : res;
+}
+
+static int impl_signalfd_read(void *object, int fd, int *signal)
+{
+	struct signalfd_siginfo signal_info;
+	int len;
+
+	len = read(fd, &signal_info, sizeof signal_info);
+	if (!(len == -1 && errno == EAGAIN) && len != sizeof signal_info)
+		return -errno;
+
+	*signal = signal_info.ssi_signo;
+
+	return 0;
+}
+
+static const struct spa_system_methods impl_system = {
+	SPA_VERSION_SYSTEM_METHODS,
+	.read = impl_read,
+	.write = impl_write,
+	.ioctl = impl_ioctl,
+	.close = impl_close,
+	.clock_gettime = impl_clock_gettime,
+	.clock_getres = impl_clock_getres,
+	.pollfd_create = impl_pollfd_create,
+	.pollfd_add = impl_pollfd_add,
+	.pollfd_mod = impl_pollfd_mod,
+	.pollfd_del = impl_pollfd_del,
+	.pollfd_wait = impl_pollfd_wait,
+	.timerfd_create = impl_timerfd_create,
+	.timerfd_settime = impl_timerfd_settime,
+	.timerfd_gettime = impl_timerfd_gettime,
+	.timerfd_read = impl_timerfd_read,
+	.eventfd_create = impl_eventfd_create,
+	.eventfd_write = impl_eventfd_write,
+	.eventfd_read = impl_eventfd_read,
+	.signalfd_create = impl_signalfd_create,
+	.signalfd_read = impl_signalfd_read,
+};
+
+static int impl_get_interface(struct spa_handle *handle, const char *type, void **interface)
+{
+	struct impl *impl;
+
+	spa_return_val_if_fail(handle != NULL, -EINVAL);
+	spa_return_val_if_fail(interface != NULL, -EINVAL);
+
+	impl = (struct impl *) handle;
+
+	if (spa_streq(type, SPA_TYPE_INTERFACE_System))
+		*interface = &impl->system;
+	else
+		return -ENOENT;
+
+	return 0;
+}
+
+static int impl_clear(struct spa_handle *handle)
+{
+	struct impl *impl;
+	struct ring *r;
+	uint32_t i;
+
+	spa_return_val_if_fail(handle != NULL, -EINVAL);
+
+	impl = (struct impl *) handle;
+
+	spa_list_consume(r, &impl->rings, link) {
+		spa_list_remove(&r->link);
+		ring_free(r);
+	}
+	for (i = 0; i < MAX_FD_CHUNKS; i++)
+		free(impl->fd_info[i]);
+	pthread_mutex_destroy(&impl->lock);
+	return 0;
+}
+
+static size_t
+impl_get_size(const struct spa_handle_factory *factory,
+	      const struct spa_dict *params)
+{
+	return sizeof(struct impl);
+}
+
+static int
+impl_init(const struct spa_handle_factory *factory,
+	  struct spa_handle *handle,
+	  const struct spa_dict *info,
+	  const struct spa_support *support,
+	  uint32_t n_support)
+{
+	struct impl *impl;
+	struct ring *r;
+	int res;
+
+	spa_return_val_if_fail(factory != NULL, -EINVAL);
+	spa_return_val_if_fail(handle != NULL, -EINVAL);
+
+	handle->get_interface = impl_get_interface;
+	handle->clear = impl_clear;
+
+	impl = (struct impl *) handle;
+	impl->system.iface = SPA_INTERFACE_INIT(
+			SPA_TYPE_INTERFACE_System,
+			SPA_VERSION_SYSTEM,
+			&impl_system, impl);
+
+	impl->log = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_Log);
+	spa_log_topic_init(impl->log, &log_topic);
+
+	spa_list_init(&impl->rings);
+
+	/* check if we can make a ring with the features we need */
+	if ((res = ring_new(impl, &r)) < 0) {
+		spa_log_error(impl->log, "%p: io_uring not available: %s",
+				impl, spa_strerror(res));
+		return res;
+	}
+	ring_free(r);
+
+	pthread_mutex_init(&impl->lock, NULL);
+
+	spa_log_info(impl->log, "%p: initialized", impl);
+
+	return 0;
+}
+
+static const struct spa_interface_info impl_interfaces[] = {
+	{SPA_TYPE_INTERFACE_System,},
+};
+
+static int
+impl_enum_interface_info(const struct spa_handle_factory *factory,
+			 const struct spa_interface_info **info,
+			 uint32_t *index)
+{
+	spa_return_val_if_fail(factory != NULL, -EINVAL);
+	spa_return_val_if_fail(info != NULL, -EINVAL);
+	spa_return_val_if_fail(index != NULL, -EINVAL);
+
+	if (*index >= SPA_N_ELEMENTS(impl_interfaces))
+		return 0;
+
+	*info = &impl_interfaces[(*index)++];
+	return 1;
+}
+
+const struct spa_handle_factory spa_support_uring_system_factory = {
+	SPA_VERSION_HANDLE_FACTORY,
+	SPA_NAME_SUPPORT_SYSTEM,
+	NULL,
+	impl_get_size,
+	impl_init,
+	impl_enum_interface_info
+};
@@ -130,7 +130,8 @@ int avb_server_make_socket(struct server *server, uint16_t type, const uint8_t m
 	struct packet_mreq mreq;
 	struct sockaddr_ll sll;
 
-	fd = socket(AF_PACKET, SOCK_RAW|SOCK_NONBLOCK, htons(ETH_P_ALL));
+	/* don't receive anything until we are bound to our protocol */
+	fd = socket(AF_PACKET, SOCK_RAW|SOCK_NONBLOCK, 0);
 	if (fd < 0) {
 		pw_log_error("socket() failed: %m");
 		return -errno;
@@ -154,6 +155,9 @@ int avb_server_make_socket(struct server *server, uint16_t type, const uint8_t m
 	}
 	memcpy(server->mac_addr, req.ifr_hwaddr.sa_data, sizeof(server->mac_addr));
 
+	if ((res = load_filter(fd, type, mac, server->mac_addr)) < 0)
+		goto error_close;
+
 	server->entity_id = (uint64_t)server->mac_addr[0] << 56 |
 			(uint64_t)server->mac_addr[1] << 48 |
 			(uint64_t)server->mac_addr[2] << 40 |
@@ -165,7 +169,7 @@ int avb_server_make_socket(struct server *server, uint16_t type, const uint8_t m
 
 	spa_zero(sll);
 	sll.sll_family = AF_PACKET;
-	sll.sll_protocol = htons(ETH_P_ALL);
+	sll.sll_protocol = htons(type);
 	sll.sll_ifindex = server->ifindex;
 	if (bind(fd, (struct sockaddr *) &sll, sizeof(sll)) < 0) {
 		res = -errno;
@@ -185,10 +189,6 @@ int avb_server_make_socket(struct server *server, uint16_t type, const uint8_t m
 		pw_log_error("setsockopt(ADD_MEMBERSHIP) failed: %m");
 		goto error_close;
 	}
-
-	if ((res = load_filter(fd, type, mac, server->mac_addr)) < 0)
-		goto error_close;
-
 	return fd;
 
 error_close:
@@ -5,10 +5,13 @@
 #include <unistd.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
+#include <linux/filter.h>
 #include <linux/net_tstamp.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 
+#include <spa/utils/result.h>
 #include <spa/debug/mem.h>
 #include <spa/pod/builder.h>
 #include <spa/param/audio/format-utils.h>
@@ -18,6 +21,12 @@
 #include "utils.h"
 #include "aecp-aem-descriptors.h"
 
+/* the receive ring, frames are large enough for a complete pdu */
+#define RX_FRAME_SIZE	2048
+#define RX_BLOCK_SIZE	(16 * RX_FRAME_SIZE)
+#define RX_BLOCKS	8
+#define RX_FRAMES	(RX_BLOCKS * RX_BLOCK_SIZE / RX_FRAME_SIZE)
+
 static void on_stream_destroy(void *d)
 {
 	struct stream *stream = d;
@@ -365,6 +374,73 @@ void stream_destroy(struct stream *stream)
 	free(stream);
 }
 
+/* only accept the frames for the stream address */
+static int load_filter(int fd, const uint8_t dest[6])
+{
+	struct sock_fprog filter;
+	struct sock_filter bpf_code[] = {
+		BPF_STMT(BPF_LD|BPF_W|BPF_ABS,  2),
+		BPF_JUMP(BPF_JMP|BPF_JEQ,       (dest[2] << 24) |
+						(dest[3] << 16) |
+						(dest[4] <<  8) |
+						(dest[5]),  0, 3),
+		BPF_STMT(BPF_LD|BPF_H|BPF_ABS,  0),
+		BPF_JUMP(BPF_JMP|BPF_JEQ,       (dest[0] << 8) |
+						(dest[1]),  0, 1),
+		BPF_STMT(BPF_RET,               0x00040000),
+		BPF_STMT(BPF_RET,               0x00000000),
+	};
+	filter.len = SPA_N_ELEMENTS(bpf_code);
+	filter.filter = bpf_code;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER,
+				&filter, sizeof(filter)) < 0) {
+		pw_log_error("setsockopt(ATTACH_FILTER) failed: %m");
+		return -errno;
+	}
+	return 0;
+}
+
+static int setup_rx_ring(struct stream *stream, int fd)
+{
+	struct tpacket_req req;
+	int val = TPACKET_V2;
+	void *ring;
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &val, sizeof(val)) < 0)
+		return -errno;
+
+	spa_zero(req);
+	req.tp_block_size = RX_BLOCK_SIZE;
+	req.tp_block_nr = RX_BLOCKS;
+	req.tp_frame_size = RX_FRAME_SIZE;
+	req.tp_frame_nr = RX_FRAMES;
+	if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+		return -errno;
+
+	ring = mmap(NULL, RX_BLOCKS * RX_BLOCK_SIZE, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	if (ring == MAP_FAILED) {
+		int res = -errno;
+		/* release the ring again, the socket is still usable without it */
+		spa_zero(req);
+		setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+		return res;
+	}
+
+	stream->rx_ring = ring;
+	stream->rx_ring_size = RX_BLOCKS * RX_BLOCK_SIZE;
+	stream->rx_frame = 0;
+	return 0;
+}
+
+static void clear_rx_ring(struct stream *stream)
+{
+	if (stream->rx_ring != NULL)
+		munmap(stream->rx_ring, stream->rx_ring_size);
+	stream->rx_ring = NULL;
+}
+
 static int setup_socket(struct stream *stream)
 {
 	struct server *server = stream->server;
@@ -372,7 +448,8 @@ static int setup_socket(struct stream *stream)
 	char buf[128];
 	struct ifreq req;
 
-	fd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, htons(ETH_P_ALL));
+	/* a talker only sends, a listener receives after the bind */
+	fd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, 0);
 	if (fd < 0) {
 		pw_log_error("socket() failed: %m");
 		return -errno;
@@ -415,6 +492,13 @@ static int setup_socket(struct stream *stream)
 	} else {
 		struct packet_mreq mreq;
 
+		if ((res = load_filter(fd, stream->addr)) < 0)
+			goto error_close;
+
+		if ((res = setup_rx_ring(stream, fd)) < 0)
+			pw_log_warn("can't map receive ring, using recv(): %s",
+					spa_strerror(res));
+
 		res = bind(fd, (struct sockaddr *) &stream->sock_addr, sizeof(stream->sock_addr));
 		if (res < 0) {
 			pw_log_error("bind() failed: %m");
@@ -441,6 +525,7 @@ static int setup_socket(struct stream *stream)
 	return fd;
 
 error_close:
+	clear_rx_ring(stream);
 	close(fd);
 	return res;
 }
@@ -467,6 +552,39 @@ static void handle_iec61883_packet(struct stream *stream,
 	}
 }
 
+static void handle_packet(struct stream *stream, uint8_t *buffer, int len)
+{
+	struct avb_frame_header *h = (void*)buffer;
+	struct avb_packet_iec61883 *p = SPA_PTROFF(h, sizeof(*h), void);
+
+	if (len < (int)sizeof(struct avb_packet_header)) {
+		pw_log_warn("short packet received (%d < %d)", len,
+				(int)sizeof(struct avb_packet_header));
+		return;
+	}
+	if (memcmp(h->dest, stream->addr, 6) != 0 ||
+	    p->subtype != AVB_SUBTYPE_61883_IIDC)
+		return;
+
+	handle_iec61883_packet(stream, p, len - sizeof(*h));
+}
+
+static void process_rx_ring(struct stream *stream)
+{
+	while (true) {
+		struct tpacket2_hdr *hdr = SPA_PTROFF(stream->rx_ring,
+				stream->rx_frame * RX_FRAME_SIZE, struct tpacket2_hdr);
+
+		if (!(__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+			break;
+
+		handle_packet(stream, SPA_PTROFF(hdr, hdr->tp_mac, uint8_t), hdr->tp_snaplen);
+
+		__atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+		stream->rx_frame = (stream->rx_frame + 1) % RX_FRAMES;
+	}
+}
+
 static void on_socket_data(void *data, int fd, uint32_t mask)
 {
 	struct stream *stream = data;
@@ -475,24 +593,17 @@ static void on_socket_data(void *data, int fd, uint32_t mask)
 		int len;
 		uint8_t buffer[2048];
 
+		if (stream->rx_ring != NULL) {
+			process_rx_ring(stream);
+			return;
+		}
+
 		len = recv(fd, buffer, sizeof(buffer), 0);
 
-		if (len < 0) {
+		if (len < 0)
 			pw_log_warn("got recv error: %m");
-		}
-		else if (len < (int)sizeof(struct avb_packet_header)) {
-			pw_log_warn("short packet received (%d < %d)", len,
-					(int)sizeof(struct avb_packet_header));
-		} else {
-			struct avb_frame_header *h = (void*)buffer;
-			struct avb_packet_iec61883 *p = SPA_PTROFF(h, sizeof(*h), void);
-
-			if (memcmp(h->dest, stream->addr, 6) != 0 ||
-			    p->subtype != AVB_SUBTYPE_61883_IIDC)
-				return;
-
-			handle_iec61883_packet(stream, p, len - sizeof(*h));
-		}
+		else
+			handle_packet(stream, buffer, len);
 	}
 }
 
@@ -511,6 +622,7 @@ int stream_activate(struct stream *stream, uint64_t now)
 		if (stream->source == NULL) {
 			res = -errno;
 			pw_log_error("stream %p: can't create source: %m", stream);
+			clear_rx_ring(stream);
 			close(fd);
 			return res;
 		}
@@ -557,6 +669,7 @@ int stream_deactivate(struct stream *stream, uint64_t now)
 		pw_loop_destroy_source(stream->server->impl->loop, stream->source);
 		stream->source = NULL;
 	}
+	clear_rx_ring(stream);
 
 	avb_mrp_attribute_leave(stream->vlan_attr->mrp, now);
 
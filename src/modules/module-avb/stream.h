@@ -56,6 +56,10 @@ struct stream {
 	char control[CMSG_SPACE(sizeof(uint64_t))];
 	struct cmsghdr *cmsg;
 
+	void *rx_ring;
+	size_t rx_ring_size;
+	uint32_t rx_frame;
+
 	struct spa_ringbuffer ring;
 	void *buffer_data;
 	size_t buffer_size;
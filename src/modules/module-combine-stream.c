@@ -28,6 +28,10 @@
 #include <spa/param/audio/raw-json.h>
 #include <spa/param/latency-utils.h>
 #include <spa/param/tag-utils.h>
+#include <spa/support/cpu.h>
+#ifdef HAVE_AUDIOMIXER
+#include <spa/plugins/audiomixer/mix-ops.h>
+#endif
 
 #include <pipewire/impl.h>
 #include <pipewire/i18n.h>
@@ -233,6 +237,7 @@ PW_LOG_TOPIC_STATIC(mod_topic, "mod." NAME);
 
 #define DELAYBUF_MAX_SIZE	(20 * sizeof(float) * 96000)
 
+#define MAX_MIX		64
 
 static const struct spa_dict_item module_props[] = {
 	{ PW_KEY_MODULE_AUTHOR, "Wim Taymans <wim.taymans@gmail.com>" },
@@ -241,6 +246,23 @@ static const struct spa_dict_item module_props[] = {
 	{ PW_KEY_MODULE_VERSION, PACKAGE_VERSION },
 };
 
+struct ringbuffer {
+	void *buf;
+	uint32_t idx;
+	uint32_t size;
+};
+
+/* an input of the mixer, made of up to 3 consecutive pieces of memory:
+ * the delayed data that wraps around in the delay line and then the start
+ * of the stream data */
+struct mix_input {
+	const void *data[3];
+	uint32_t end[3];
+	struct ringbuffer *delay;
+	const void *src;
+	uint32_t size;
+};
+
 struct impl {
 	struct pw_context *context;
 	struct pw_loop *main_loop;
@@ -284,6 +306,11 @@ struct impl {
 
 	struct spa_audio_info_raw info;
 
+#ifdef HAVE_AUDIOMIXER
+	struct mix_ops mix;
+#endif
+	struct mix_input mix_inputs[MAX_MIX];
+
 	unsigned int do_disconnect:1;
 	unsigned int latency_compensate:1;
 	unsigned int on_demand_streams:1;
@@ -292,12 +319,6 @@ struct impl {
 	uint32_t n_streams;
 };
 
-struct ringbuffer {
-	void *buf;
-	uint32_t idx;
-	uint32_t size;
-};
-
 struct stream {
 	uint32_t id;
 	char *on_demand_id;
@@ -320,6 +341,8 @@ struct stream {
 	int64_t delay_samples;		/* for main loop */
 	int64_t data_delay_samples;	/* for data loop */
 
+	struct pw_buffer *buffer;	/* for data loop */
+
 	unsigned int ready:1;
 	unsigned int added:1;
 	unsigned int have_latency:1;
@@ -343,7 +366,7 @@ static void ringbuffer_init(struct ringbuffer *r, void *buf, uint32_t size)
 	r->size = size;
 }
 
-static void ringbuffer_memcpy(struct ringbuffer *r, void *dst, void *src, uint32_t size)
+static void ringbuffer_memcpy(struct ringbuffer *r, void *dst, const void *src, uint32_t size)
 {
 	uint32_t avail;
 
@@ -369,38 +392,89 @@ static void ringbuffer_memcpy(struct ringbuffer *r, void *dst, void *src, uint32
 	}
 }
 
-static void mix_f32(float *dst, float *src, uint32_t size)
+/* sum n_src sources of size bytes into dst, dst can't be one of the sources */
+static void mix_f32(struct impl *impl, void * SPA_RESTRICT dst,
+		const void * SPA_RESTRICT src[], uint32_t n_src, uint32_t size)
 {
-	uint32_t i, s = size / sizeof(float);
-	for (i = 0; i < s; i++)
-		dst[i] += src[i];
+#ifdef HAVE_AUDIOMIXER
+	mix_ops_process(&impl->mix, dst, src, n_src, size / sizeof(float));
+#else
+	float *d = dst;
+	uint32_t i, n, n_samples = size / sizeof(float);
+
+	if (n_src == 0) {
+		memset(dst, 0, size);
+		return;
+	}
+	memcpy(dst, src[0], size);
+	for (i = 1; i < n_src; i++) {
+		const float *s = src[i];
+		for (n = 0; n < n_samples; n++)
+			d[n] += s[n];
+	}
+#endif
 }
 
-static void ringbuffer_mix(struct ringbuffer *r, void *dst, void *src, uint32_t size)
+static void mix_input_init(struct mix_input *m, struct ringbuffer *r,
+		const void *src, uint32_t size)
 {
-	uint32_t avail;
+	uint32_t n = 0, avail, l0;
 
 	avail = SPA_MIN(size, r->size);
+	l0 = SPA_MIN(avail, r->size - r->idx);
 
-	/* buf to dst */
-	if (dst && avail > 0) {
-		uint32_t l0 = SPA_MIN(avail, r->size - r->idx), l1 = avail - l0;
-		mix_f32(dst, SPA_PTROFF(r->buf, r->idx, void), l0);
-		if (SPA_UNLIKELY(l1 > 0))
-			mix_f32(SPA_PTROFF(dst, l0, void), r->buf, l1);
-		dst = SPA_PTROFF(dst, avail, void);
+	/* buf, then the wrapped part of buf, then src */
+	if (l0 > 0) {
+		m->data[n] = SPA_PTROFF(r->buf, r->idx, void);
+		m->end[n++] = l0;
+	}
+	if (avail > l0) {
+		m->data[n] = r->buf;
+		m->end[n++] = avail;
 	}
-	/* src to dst */
 	if (size > avail) {
-		if (dst)
-			mix_f32(dst, src, size - avail);
-		src = SPA_PTROFF(src, size - avail, void);
+		m->data[n] = src;
+		m->end[n++] = size;
 	}
-	/* src to buf */
-	if (avail > 0) {
-		spa_ringbuffer_write_data(NULL, r->buf, r->size, r->idx, src, avail);
-		r->idx = (r->idx + avail) % r->size;
+	m->delay = r->size > 0 ? r : NULL;
+	m->src = src;
+	m->size = size;
+}
+
+/* sum the inputs into dst, the inputs are split into blocks where each
+ * input has one piece so that all of them are mixed from their own memory
+ * in one go. Returns the number of bytes in dst. */
+static uint32_t mix_inputs(struct impl *impl, void *dst,
+		struct mix_input *in, uint32_t n_in)
+{
+	const void *src[MAX_MIX];
+	uint32_t i, k, offs, end, n_src, outsize = 0;
+
+	for (i = 0; i < n_in; i++)
+		outsize = SPA_MAX(outsize, in[i].size);
+
+	for (offs = 0; offs < outsize; offs = end) {
+		end = outsize;
+		n_src = 0;
+		for (i = 0; i < n_in; i++) {
+			struct mix_input *m = &in[i];
+
+			if (offs >= m->size)
+				continue;
+			for (k = 0; offs >= m->end[k]; k++);
+
+			src[n_src++] = SPA_PTROFF(m->data[k],
+					offs - (k > 0 ? m->end[k - 1] : 0), const void);
+			end = SPA_MIN(end, m->end[k]);
+		}
+		mix_f32(impl, SPA_PTROFF(dst, offs, void), src, n_src, end - offs);
 	}
+	/* the delay lines are read now, store the new data in them */
+	for (i = 0; i < n_in; i++) {
+		if (in[i].delay != NULL)
+			ringbuffer_memcpy(in[i].delay, NULL, in[i].src, in[i].size);
+	}
+	return outsize;
 }
 
 static void ringbuffer_copy(struct ringbuffer *dst, struct ringbuffer *src)
@@ -1178,23 +1252,33 @@ do_trigger:
 		pw_loop_signal_event(impl->main_loop, impl->update_delay_event);
 }
 
+static inline void get_chunk(struct spa_data *ds, struct spa_data *dd,
+		void **data, uint32_t *size)
+{
+	uint32_t offs, sz;
+
+	offs = SPA_MIN(ds->chunk->offset, ds->maxsize);
+	sz = SPA_MIN(ds->chunk->size, ds->maxsize - offs);
+
+	*data = SPA_PTROFF(ds->data, offs, void);
+	*size = SPA_MIN(sz, dd->maxsize);
+}
+
 static void combine_output_process(void *d)
 {
 	struct impl *impl = d;
 	struct pw_buffer *in, *out;
 	struct stream *s;
 	bool delay_changed = false;
-	bool mix[SPA_AUDIO_MAX_CHANNELS];
+	uint32_t i, j;
 
 	if ((out = pw_stream_dequeue_buffer(impl->combine)) == NULL) {
 		pw_log_debug("%p: out of output buffers: %m", impl);
 		return;
 	}
-	for (uint32_t i = 0; i < out->buffer->n_datas; i++)
-		mix[i] = false;
 
 	spa_list_for_each(s, &impl->streams, link) {
-		uint32_t j;
+		s->buffer = NULL;
 
 		if (s->stream == NULL)
 			continue;
@@ -1216,42 +1300,56 @@ static void combine_output_process(void *d)
 			continue;
 		}
 		s->ready = false;
+		s->buffer = in;
+	}
 
-		for (j = 0; j < in->buffer->n_datas; j++) {
-			struct spa_data *ds, *dd;
-			uint32_t outsize = 0, remap;
-			int32_t stride = 0;
+	/* Mix all streams into each output channel. The data of each stream
+	 * and its delay line are mixed straight from their memory. */
+	for (i = 0; i < out->buffer->n_datas; i++) {
+		struct spa_data *dd = &out->buffer->datas[i];
+		uint32_t n_in = 0, outsize;
+		int32_t stride = 0;
 
-			ds = &in->buffer->datas[j];
+		spa_list_for_each(s, &impl->streams, link) {
+			if (s->buffer == NULL)
+				continue;
 
-			remap = s->remap[j];
-			if (remap < out->buffer->n_datas) {
-				uint32_t offs, size;
+			for (j = 0; j < s->buffer->buffer->n_datas; j++) {
+				struct spa_data *ds = &s->buffer->buffer->datas[j];
+				void *data;
+				uint32_t size;
 
-				dd = &out->buffer->datas[remap];
+				if (s->remap[j] != i)
+					continue;
 
-				offs = SPA_MIN(ds->chunk->offset, ds->maxsize);
-				size = SPA_MIN(ds->chunk->size, ds->maxsize - offs);
-				size = SPA_MIN(size, dd->maxsize);
-
-				if (mix[remap]) {
-					ringbuffer_mix(&s->delay[j],
-						dd->data, SPA_PTROFF(ds->data, offs, void), size);
-				} else {
-					ringbuffer_memcpy(&s->delay[j],
-						dd->data, SPA_PTROFF(ds->data, offs, void), size);
-					mix[remap] = true;
+				get_chunk(ds, dd, &data, &size);
+
+				if (n_in == MAX_MIX) {
+					pw_log_warn("%p: too many inputs for channel %u",
+							impl, i);
+					ringbuffer_memcpy(&s->delay[j], NULL, data, size);
+					continue;
 				}
+				mix_input_init(&impl->mix_inputs[n_in++],
+						&s->delay[j], data, size);
 
-				outsize = SPA_MAX(outsize, size);
 				stride = SPA_MAX(stride, ds->chunk->stride);
-
-				dd->chunk->offset = 0;
-				dd->chunk->size = outsize;
-				dd->chunk->stride = stride;
 			}
 		}
-		pw_stream_queue_buffer(s->stream, in);
+		if (n_in > 0) {
+			outsize = mix_inputs(impl, dd->data, impl->mix_inputs, n_in);
+
+			dd->chunk->offset = 0;
+			dd->chunk->size = outsize;
+			dd->chunk->stride = stride;
+		}
+	}
+
+	spa_list_for_each(s, &impl->streams, link) {
+		if (s->buffer == NULL)
+			continue;
+		pw_stream_queue_buffer(s->stream, s->buffer);
+		s->buffer = NULL;
 	}
 	pw_stream_queue_buffer(impl->combine, out);
 
@@ -1435,6 +1533,11 @@ static void impl_destroy(struct impl *impl)
 	if (impl->data_loop)
 		pw_context_release_loop(impl->context, impl->data_loop);
 
+#ifdef HAVE_AUDIOMIXER
+	if (impl->mix.free)
+		mix_ops_free(&impl->mix);
+#endif
+
 	pw_properties_free(impl->stream_props);
 	pw_properties_free(impl->combine_props);
 	pw_properties_free(impl->props);
@@ -1473,6 +1576,11 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 	uint32_t pid = getpid();
 	struct impl *impl;
 	const char *str, *prefix;
+#ifdef HAVE_AUDIOMIXER
+	const struct spa_support *support;
+	uint32_t n_support;
+	struct spa_cpu *cpu;
+#endif
 	int res;
 	struct spa_error_location loc = {};
 
@@ -1506,6 +1614,19 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 	impl->main_loop = pw_context_get_main_loop(context);
 	impl->data_loop = pw_context_acquire_loop(context, &props->dict);
 
+#ifdef HAVE_AUDIOMIXER
+	support = pw_context_get_support(context, &n_support);
+	cpu = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_CPU);
+
+	impl->mix.fmt = SPA_AUDIO_FORMAT_F32P;
+	impl->mix.n_channels = 1;
+	impl->mix.cpu_flags = cpu ? spa_cpu_get_flags(cpu) : 0;
+	if ((res = mix_ops_init(&impl->mix)) < 0) {
+		pw_log_error("can't initialize mixer: %s", spa_strerror(res));
+		goto error;
+	}
+#endif
+
 	if ((str = pw_properties_get(props, "combine.mode")) == NULL)
 		str = "sink";
 
@@ -51,6 +51,11 @@ extern struct spa_handle_factory spa_filter_graph_factory;
  *
  * - `node.description`: a human readable name for the filter chain
  * - `filter.graph = []`: a description of the filter graph to run, see below
+ * - `filter-graph.threads`: the number of extra threads to use for processing
+ *   the graph, default 0. Parts of the graph that are not linked to each other,
+ *   like the graphs of each channel, are then processed at the same time
+ *   on multiple CPUs. This is only useful for graphs with heavy filters, like long
+ *   convolvers. The threads use realtime priority when available.
  * - `capture.props = {}`: properties to be passed to the input stream
  * - `playback.props = {}`: properties to be passed to the output stream
  *
@@ -177,6 +182,9 @@ extern struct spa_handle_factory spa_filter_graph_factory;
  *
  * It has one input port "In" and one output port "Out".
  *
+ * A copy between two filters is not run, the filters after the copy read the
+ * output of the filter before the copy directly.
+ *
  * ### Biquads
  *
  * Biquads can be used to do all kinds of filtering. They are also used when creating
@@ -323,6 +331,7 @@ extern struct spa_handle_factory spa_filter_graph_factory;
  *             config = {
  *                 blocksize = ...
  *                 tailsize = ...
+ *                 background = ...
  *                 gain = ...
  *                 delay = ...
  *                 filename = ...
@@ -342,6 +351,13 @@ extern struct spa_handle_factory spa_filter_graph_factory;
  *               between 64 and 256. When not specified, this value is
  *               computed automatically from the number of samples in the file.
  * - `tailsize` specifies the size of the tail blocks to use in the FFT.
+ * - `background` when true, the part of the IR after 2 tail blocks is processed in a
+ *              separate thread. The processing thread then only does a small amount
+ *              of work every cycle instead of the whole tail every tail block.
+ *              This is useful for long IRs. No latency is added, the thread has
+ *              one tail block of time to complete. When it is late, the processing
+ *              thread waits for it at the next tail block boundary so that the
+ *              output stays the same as without the thread. Default false.
  * - `gain`     the overall gain to apply to the IR file.
  * - `delay`    The extra delay to add to the IR. A float number will be interpreted as seconds,
  *              and integer as samples. Using the delay in seconds is independent of the graph
@@ -3,8 +3,21 @@
 #include <spa/control/ump-utils.h>
 
 #ifdef HAVE_OPUS_CUSTOM
+#include <semaphore.h>
 #include <opus/opus.h>
 #include <opus/opus_custom.h>
+
+#include <pipewire/thread.h>
+
+/* use an extra codec thread for every this many channels */
+#define OPUS_WORKER_CHANNELS	8u
+#define OPUS_MAX_WORKERS	8u
+
+struct opus_worker {
+	struct netjack2_peer *peer;
+	struct spa_thread *thread;
+	sem_t start;
+};
 #endif
 
 struct volume {
@@ -125,11 +138,137 @@ struct netjack2_peer {
 	OpusCustomMode *opus_config;
 	OpusCustomEncoder **opus_enc;
 	OpusCustomDecoder **opus_dec;
+
+	/* the channels of a cycle are coded in parallel by the
+	 * process thread and the workers */
+	struct opus_worker *opus_workers;
+	uint32_t n_opus_workers;
+	sem_t opus_done;
+	bool opus_running;
+
+	void (*opus_job) (struct netjack2_peer *peer, uint32_t channel);
+	uint32_t opus_job_channels;
+	uint32_t opus_job_next;
+	uint32_t opus_nframes;
+	struct data_info *opus_info;
+	uint32_t opus_n_info;
 #endif
 
 	unsigned fix_midi:1;
 };
 
+#ifdef HAVE_OPUS_CUSTOM
+static void opus_run_jobs(struct netjack2_peer *peer)
+{
+	uint32_t i;
+	while ((i = __atomic_fetch_add(&peer->opus_job_next, 1, __ATOMIC_SEQ_CST)) <
+			peer->opus_job_channels)
+		peer->opus_job(peer, i);
+}
+
+static void *opus_worker_thread(void *data)
+{
+	struct opus_worker *w = data;
+	struct netjack2_peer *peer = w->peer;
+
+	while (true) {
+		while (sem_wait(&w->start) < 0 && errno == EINTR);
+		if (!peer->opus_running)
+			break;
+		opus_run_jobs(peer);
+		sem_post(&peer->opus_done);
+	}
+	return NULL;
+}
+
+static void opus_run(struct netjack2_peer *peer,
+		void (*job) (struct netjack2_peer *peer, uint32_t channel),
+		uint32_t channels)
+{
+	uint32_t i, n_workers;
+
+	if (channels == 0)
+		return;
+
+	peer->opus_job = job;
+	peer->opus_job_channels = channels;
+	peer->opus_job_next = 0;
+
+	n_workers = SPA_MIN(peer->n_opus_workers,
+			SPA_ROUND_UP(channels, OPUS_WORKER_CHANNELS) / OPUS_WORKER_CHANNELS - 1);
+	for (i = 0; i < n_workers; i++)
+		sem_post(&peer->opus_workers[i].start);
+
+	opus_run_jobs(peer);
+
+	for (i = 0; i < n_workers; i++)
+		while (sem_wait(&peer->opus_done) < 0 && errno == EINTR);
+}
+
+static void opus_start_workers(struct netjack2_peer *peer)
+{
+	uint32_t i, n_workers, channels;
+	long n_cpus;
+
+	channels = SPA_MAX(peer->params.send_audio_channels, peer->params.recv_audio_channels);
+	if (channels <= OPUS_WORKER_CHANNELS)
+		return;
+
+	n_workers = SPA_MIN(SPA_ROUND_UP(channels, OPUS_WORKER_CHANNELS) /
+			OPUS_WORKER_CHANNELS - 1, OPUS_MAX_WORKERS);
+	if ((n_cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0)
+		n_workers = SPA_MIN(n_workers, (uint32_t)n_cpus - 1);
+	if (n_workers == 0)
+		return;
+
+	if ((peer->opus_workers = calloc(n_workers, sizeof(struct opus_worker))) == NULL)
+		return;
+
+	sem_init(&peer->opus_done, 0, 0);
+	peer->opus_running = true;
+
+	for (i = 0; i < n_workers; i++) {
+		struct opus_worker *w = &peer->opus_workers[i];
+		struct spa_dict_item items[] = {
+			SPA_DICT_ITEM_INIT(SPA_KEY_THREAD_NAME, "netjack2-opus"),
+		};
+
+		w->peer = peer;
+		sem_init(&w->start, 0, 0);
+		w->thread = pw_thread_utils_create(&SPA_DICT_INIT_ARRAY(items),
+				opus_worker_thread, w);
+		if (w->thread == NULL) {
+			pw_log_warn("can't create opus worker: %m");
+			sem_destroy(&w->start);
+			break;
+		}
+		pw_thread_utils_acquire_rt(w->thread, -1);
+	}
+	peer->n_opus_workers = i;
+	pw_log_info("using %u opus workers for %u channels", i, channels);
+}
+
+static void opus_stop_workers(struct netjack2_peer *peer)
+{
+	uint32_t i;
+
+	if (peer->opus_workers == NULL)
+		return;
+
+	peer->opus_running = false;
+	for (i = 0; i < peer->n_opus_workers; i++)
+		sem_post(&peer->opus_workers[i].start);
+	for (i = 0; i < peer->n_opus_workers; i++) {
+		pw_thread_utils_join(peer->opus_workers[i].thread, NULL);
+		sem_destroy(&peer->opus_workers[i].start);
+	}
+	sem_destroy(&peer->opus_done);
+	free(peer->opus_workers);
+	peer->opus_workers = NULL;
+	peer->n_opus_workers = 0;
+}
+#endif
+
 static int netjack2_init(struct netjack2_peer *peer)
 {
 	int res = 0;
@@ -183,6 +322,7 @@ static int netjack2_init(struct netjack2_peer *peer)
 					1, &res)) == NULL)
 				goto error_opus;
 		}
+		opus_start_workers(peer);
 #else
 		return -ENOTSUP;
 #endif
@@ -206,6 +346,7 @@ static void netjack2_cleanup(struct netjack2_peer *peer)
 	free(peer->midi_data);
 #ifdef HAVE_OPUS_CUSTOM
 	int32_t i;
+	opus_stop_workers(peer);
 	if (peer->opus_enc != NULL) {
 		for (i = 0; i < peer->params.send_audio_channels; i++) {
 			if (peer->opus_enc[i])
@@ -501,6 +642,48 @@ static int netjack2_send_float(struct netjack2_peer *peer, uint32_t nframes,
 	return 0;
 }
 
+#ifdef HAVE_OPUS_CUSTOM
+static void opus_encode_channel(struct netjack2_peer *peer, uint32_t i)
+{
+	uint32_t max_encoded = peer->max_encoded_size;
+	uint16_t *ap = SPA_PTROFF(peer->encoded_data, i * max_encoded, uint16_t);
+	void *pcm;
+	int res;
+
+	if (i >= peer->opus_n_info || (pcm = peer->opus_info[i].data) == NULL)
+		pcm = peer->empty;
+
+	res = opus_custom_encode_float(peer->opus_enc[i],
+			pcm, peer->opus_nframes, (unsigned char*)&ap[1], max_encoded - 2);
+
+	if (res < 0 || res > 0xffff) {
+		pw_log_warn("encoding error %d", res);
+		ap[0] = 0;
+	} else {
+		ap[0] = htons(res);
+	}
+}
+
+static void opus_decode_channel(struct netjack2_peer *peer, uint32_t i)
+{
+	uint16_t *ap = SPA_PTROFF(peer->encoded_data, i * peer->max_encoded_size, uint16_t);
+	void *pcm;
+	int res;
+
+	if (i >= peer->opus_n_info || (pcm = peer->opus_info[i].data) == NULL)
+		return;
+
+	res = opus_custom_decode_float(peer->opus_dec[i],
+			(unsigned char*)&ap[1], ntohs(ap[0]),
+			pcm, peer->sync.frames);
+
+	if (res < 0 || res > 0xffff || res != peer->sync.frames)
+		pw_log_warn("decoding error %d", res);
+	else
+		peer->opus_info[i].filled = true;
+}
+#endif
+
 static int netjack2_send_opus(struct netjack2_peer *peer, uint32_t nframes,
 		struct data_info *info, uint32_t n_info)
 {
@@ -524,24 +707,10 @@ static int netjack2_send_opus(struct netjack2_peer *peer, uint32_t nframes,
 
 	encoded_data = peer->encoded_data;
 
-	for (i = 0; i < active_ports; i++) {
-		uint16_t *ap = SPA_PTROFF(encoded_data, i * max_encoded, uint16_t);
-		void *pcm;
-		int res;
-
-		if (i >= n_info || (pcm = info[i].data) == NULL)
-			pcm = peer->empty;
-
-		res = opus_custom_encode_float(peer->opus_enc[i],
-				pcm, nframes, (unsigned char*)&ap[1], max_encoded - 2);
-
-		if (res < 0 || res > 0xffff) {
-			pw_log_warn("encoding error %d", res);
-			ap[0] = 0;
-		} else {
-			ap[0] = htons(res);
-		}
-	}
+	peer->opus_nframes = nframes;
+	peer->opus_info = info;
+	peer->opus_n_info = n_info;
+	opus_run(peer, opus_encode_channel, active_ports);
 
 	strcpy(header.type, "header");
 	header.data_type = htonl('a');
@@ -891,23 +1060,9 @@ static int netjack2_recv_opus(struct netjack2_peer *peer, struct nj2_packet_head
 	if (++(*count) < peer->sync.num_packets)
 		return 0;
 
-	for (i = 0; i < active_ports; i++) {
-		uint16_t *ap = SPA_PTROFF(encoded_data, i * max_encoded, uint16_t);
-		void *pcm;
-		int res;
-
-		if (i >= n_info || (pcm = info[i].data) == NULL)
-			continue;
-
-		res = opus_custom_decode_float(peer->opus_dec[i],
-				(unsigned char*)&ap[1], ntohs(ap[0]),
-				pcm, peer->sync.frames);
-
-		if (res < 0 || res > 0xffff || res != peer->sync.frames)
-			pw_log_warn("decoding error %d", res);
-		else
-			info[i].filled = true;
-	}
+	peer->opus_info = info;
+	peer->opus_n_info = n_info;
+	opus_run(peer, opus_decode_channel, active_ports);
 	return 0;
 #else
 	return -ENOTSUP;
@@ -82,6 +82,7 @@ PW_LOG_TOPIC(mod_topic, "mod." NAME);
 #define TMP_BUFFER		(16 * 1024)
 #define DATA_BUFFER		(32 * 1024)
 #define FLUSH_BUFFER		(8 * 1024)
+#define MAX_CRITICAL		64
 
 int pw_protocol_native_ext_profiler_init(struct pw_context *context);
 
@@ -203,6 +204,59 @@ static void update_denom(struct spa_fraction *frac, uint32_t denom)
 	frac->denom = denom;
 }
 
+/* Walk back from the follower that finished last to the driver. A node is
+ * signaled with the finish time of the node that triggered it so we can find
+ * the previous node on the path by matching the times. */
+static void add_critical_path(struct spa_pod_builder *b, struct pw_impl_node *node)
+{
+	struct pw_node_activation *a = node->rt.target.activation;
+	struct pw_node_target *t, *cur = NULL;
+	struct spa_pod_frame f[2];
+	uint64_t start = a->signal_time, end = 0, busy = 0;
+	uint32_t ids[MAX_CRITICAL], n_ids = 0;
+
+	spa_list_for_each(t, &node->rt.target_list, link) {
+		struct pw_node_activation *ta = t->activation;
+		if (t->id == node->info.id || (t->node && t->node->async))
+			continue;
+		if (ta->signal_time < start || ta->finish_time < ta->awake_time)
+			continue;
+		if (ta->finish_time > end) {
+			end = ta->finish_time;
+			cur = t;
+		}
+	}
+	while (cur != NULL && n_ids < MAX_CRITICAL) {
+		struct pw_node_activation *ca = cur->activation;
+		uint64_t signal = ca->signal_time;
+
+		ids[n_ids++] = cur->id;
+		busy += ca->finish_time - ca->awake_time;
+
+		cur = NULL;
+		if (signal <= start)
+			break;
+		spa_list_for_each(t, &node->rt.target_list, link) {
+			if (t->id != node->info.id &&
+			    t->activation->finish_time == signal) {
+				cur = t;
+				break;
+			}
+		}
+	}
+
+	spa_pod_builder_prop(b, SPA_PROFILER_criticalPath, 0);
+	spa_pod_builder_push_struct(b, &f[0]);
+	spa_pod_builder_long(b, start);
+	spa_pod_builder_long(b, end);
+	spa_pod_builder_long(b, busy);
+	spa_pod_builder_push_struct(b, &f[1]);
+	while (n_ids > 0)
+		spa_pod_builder_int(b, ids[--n_ids]);
+	spa_pod_builder_pop(b, &f[1]);
+	spa_pod_builder_pop(b, &f[0]);
+}
+
 static void context_do_profile(void *data)
 {
 	struct node *n = data;
@@ -265,6 +319,8 @@ static void context_do_profile(void *data)
 			SPA_POD_Fraction(&node->latency),
 			SPA_POD_Int(a->xrun_count));
 
+	add_critical_path(&b, node);
+
 	spa_list_for_each(t, &node->rt.target_list, link) {
 		struct pw_impl_node *n = t->node;
 		struct pw_node_activation *na;
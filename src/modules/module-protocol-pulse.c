@@ -76,6 +76,8 @@
  *     #pulse.default.format   = F32
  *     #pulse.default.position = [ FL FR ]
  *     #pulse.idle.timeout     = 0
+ *     #pulse.enable-shm       = true
+ *     #pulse.share-manager    = false
  * }
  *
  * pulse.properties.rules = [
@@ -247,6 +249,26 @@
  * save battery power. When the client resumes, it will unpause again.
  * A value of 0 disables this feature.
  *
+ *\code{.unparsed}
+ *     pulse.enable-shm = true
+ *\endcode
+ *
+ * Local clients of the same user can pass their playback data in shared
+ * memory instead of copying it through the socket. This saves copies and
+ * system calls. Only sealed memfd pools are accepted and sandboxed or
+ * restricted clients always use the socket. Set to false to always use
+ * the socket.
+ *
+ *\code{.unparsed}
+ *     pulse.share-manager = false
+ *\endcode
+ *
+ * Clients without access restrictions (not flatpak, snap or restricted) that
+ * got full permissions on all objects share one view of the PipeWire objects
+ * instead of each mirroring the complete registry over their own connection.
+ * This makes connecting many clients a lot cheaper. The default is false,
+ * each client has its own view.
+ *
  * ## Command execution
  *
  * As part of the server startup sequence, a set of commands can be executed.
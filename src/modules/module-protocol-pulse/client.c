@@ -2,11 +2,19 @@
 /* SPDX-FileCopyrightText: Copyright © 2020 Wim Taymans */
 /* SPDX-License-Identifier: MIT */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <arpa/inet.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 #include <spa/utils/defs.h>
 #include <spa/utils/hook.h>
@@ -34,6 +42,8 @@ PW_LOG_TOPIC_EXTERN(pulse_conn);
 #define client_emit_disconnect(c) spa_hook_list_call(&(c)->listener_list, struct client_events, disconnect, 0)
 #define client_emit_routes_changed(c) spa_hook_list_call(&(c)->listener_list, struct client_events, routes_changed, 0)
 
+#define MAX_IOV	64
+
 struct client *client_new(struct server *server)
 {
 	struct client *client = calloc(1, sizeof(*client));
@@ -116,7 +126,16 @@ void client_disconnect(struct client *client)
 		client->source = NULL;
 	}
 
-	if (client->manager) {
+	spa_hook_remove(&client->client_listener);
+	spa_zero(client->client_listener);
+
+	if (client->shared) {
+		spa_hook_remove(&client->core_listener);
+		spa_hook_remove(&client->manager_listener);
+		shared_manager_unref(client->shared);
+		client->shared = NULL;
+		client->manager = NULL;
+	} else if (client->manager) {
 		pw_manager_destroy(client->manager);
 		client->manager = NULL;
 	}
@@ -128,6 +147,7 @@ void client_free(struct client *client)
 	struct pending_sample *p;
 	struct message *msg;
 	struct operation *o;
+	uint32_t i;
 
 	pw_log_debug("client %p: free", client);
 
@@ -154,6 +174,10 @@ void client_free(struct client *client)
 
 	pw_map_clear(&client->streams);
 
+	client_close_fds(client);
+	for (i = 0; i < client->n_shm; i++)
+		munmap(client->shm[i].data, client->shm[i].size);
+
 	pw_work_queue_cancel(impl->work_queue, client, SPA_ID_INVALID);
 
 	free(client->default_sink);
@@ -193,10 +217,10 @@ int client_queue_message(struct client *client, struct message *msg)
 		goto error;
 	}
 
-	if (msg->length == 0) {
+	if (msg->length == 0 && msg->type != MESSAGE_TYPE_SHM_RELEASE) {
 		res = 0;
 		goto error;
-	} else if (msg->length > msg->allocated) {
+	} else if (msg->length > msg->allocated && msg->type != MESSAGE_TYPE_RECORD) {
 		res = -ENOMEM;
 		goto error;
 	}
@@ -219,51 +243,114 @@ error:
 	return res;
 }
 
+static void fill_descriptor(struct descriptor *desc, const struct message *m)
+{
+	desc->length = htonl(m->length);
+	desc->channel = htonl(m->channel);
+	desc->offset_hi = 0;
+	desc->offset_lo = 0;
+	desc->flags = 0;
+
+	if (m->type == MESSAGE_TYPE_SHM_RELEASE) {
+		desc->offset_hi = htonl(m->u.shm_release.block_id);
+		desc->flags = htonl(FLAG_SHMRELEASE);
+	}
+}
+
+/* the data of the message from idx, record data can wrap around in the ringbuffer */
+static uint32_t fill_data(struct iovec *iov, const struct message *m, uint32_t idx)
+{
+	const struct stream *s;
+	uint32_t offs, len, l0;
+
+	if (m->type != MESSAGE_TYPE_RECORD) {
+		iov[0].iov_base = m->data + idx;
+		iov[0].iov_len = m->length - idx;
+		return 1;
+	}
+	s = m->u.record.stream;
+	offs = (m->u.record.index + idx) % MAXLENGTH;
+	len = m->length - idx;
+	l0 = SPA_MIN(len, MAXLENGTH - offs);
+
+	iov[0].iov_base = SPA_PTROFF(s->buffer, offs, void);
+	iov[0].iov_len = l0;
+	if (l0 == len)
+		return 1;
+	iov[1].iov_base = s->buffer;
+	iov[1].iov_len = len - l0;
+	return 2;
+}
+
 static int client_try_flush_messages(struct client *client)
 {
+	struct descriptor desc[MAX_IOV];
+	struct iovec iov[MAX_IOV];
+
 	pw_log_trace("client %p: flushing", client);
 
 	spa_assert(!client->disconnect);
 
 	while (!spa_list_is_empty(&client->out_messages)) {
-		struct message *m = spa_list_first(&client->out_messages, struct message, link);
-		struct descriptor desc;
-		const void *data;
-		size_t size;
-
-		if (client->out_index < sizeof(desc)) {
-			desc.length = htonl(m->length);
-			desc.channel = htonl(m->channel);
-			desc.offset_hi = 0;
-			desc.offset_lo = 0;
-			desc.flags = 0;
-
-			data = SPA_PTROFF(&desc, client->out_index, void);
-			size = sizeof(desc) - client->out_index;
-		} else if (client->out_index < m->length + sizeof(desc)) {
-			uint32_t idx = client->out_index - sizeof(desc);
-			data = m->data + idx;
-			size = m->length - idx;
-		} else {
-			if (m->channel == SPA_ID_INVALID &&
-			    pw_log_topic_custom_enabled(SPA_LOG_LEVEL_INFO, pulse_conn))
-				message_dump(SPA_LOG_LEVEL_INFO, ">>", m);
-			message_free(m, true, false);
-			client->out_index = 0;
-			continue;
+		struct message *m, *t;
+		uint32_t n_iov = 0, n_desc = 0, idx = client->out_index;
+		ssize_t sent;
+
+		/* send as many queued messages as possible with one system call */
+		spa_list_for_each(m, &client->out_messages, link) {
+			if (n_iov + 3 > MAX_IOV)
+				break;
+
+			if (idx < sizeof(struct descriptor)) {
+				fill_descriptor(&desc[n_desc], m);
+				iov[n_iov].iov_base = SPA_PTROFF(&desc[n_desc], idx, void);
+				iov[n_iov].iov_len = sizeof(struct descriptor) - idx;
+				n_iov++;
+				n_desc++;
+				idx = 0;
+			} else {
+				idx -= sizeof(struct descriptor);
+			}
+			if (idx < m->length)
+				n_iov += fill_data(&iov[n_iov], m, idx);
+			idx = 0;
 		}
 
 		while (true) {
-			ssize_t sent = send(client->source->fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+			struct msghdr msg = {
+				.msg_iov = iov,
+				.msg_iovlen = n_iov,
+			};
+			sent = sendmsg(client->source->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
 			if (sent < 0) {
 				int res = -errno;
 				if (res == -EINTR)
 					continue;
 				return res;
 			}
-			client->out_index += sent;
 			break;
 		}
+
+		/* free the messages that were sent completely */
+		spa_list_for_each_safe(m, t, &client->out_messages, link) {
+			size_t size = sizeof(struct descriptor) + m->length - client->out_index;
+
+			if ((size_t)sent < size) {
+				client->out_index += sent;
+				break;
+			}
+			sent -= size;
+
+			if (m->type == MESSAGE_TYPE_RECORD)
+				stream_record_sent(m->u.record.stream,
+						m->u.record.index, m->length);
+			else if (m->channel == SPA_ID_INVALID &&
+			    m->type != MESSAGE_TYPE_SHM_RELEASE &&
+			    pw_log_topic_custom_enabled(SPA_LOG_LEVEL_INFO, pulse_conn))
+				message_dump(SPA_LOG_LEVEL_INFO, ">>", m);
+			message_free(m, true, false);
+			client->out_index = 0;
+		}
 	}
 	return 0;
 }
@@ -401,3 +488,85 @@ int client_queue_subscribe_event(struct client *client, uint32_t facility, uint3
 
 	return client_queue_message(client, reply);
 }
+
+int client_attach_shm(struct client *client, uint32_t id, int fd)
+{
+	struct client_shm *shm;
+	struct stat st;
+	void *data;
+	uint32_t i;
+	int seals;
+
+	for (i = 0; i < client->n_shm; i++) {
+		if (client->shm[i].id == id)
+			return -EEXIST;
+	}
+	if (client->n_shm >= CLIENT_MAX_SHM)
+		return -ENOSPC;
+
+	/* the client keeps write access to the pool, it must not be able to
+	 * shrink it under our mapping or we would get SIGBUS when reading */
+	if ((seals = fcntl(fd, F_GET_SEALS)) < 0)
+		return -errno;
+	if (!SPA_FLAG_IS_SET(seals, F_SEAL_SHRINK))
+		return -EPERM;
+
+	if (fstat(fd, &st) < 0)
+		return -errno;
+	if (st.st_size <= 0)
+		return -EINVAL;
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+		return -errno;
+
+	shm = &client->shm[client->n_shm++];
+	shm->id = id;
+	shm->data = data;
+	shm->size = st.st_size;
+
+	pw_log_debug("client %p: attached memfd shm id:%u size:%zu", client,
+			id, shm->size);
+	return 0;
+}
+
+const void *client_get_shm(struct client *client, const struct shm_info *info)
+{
+	struct client_shm *shm = NULL;
+	uint32_t i;
+
+	for (i = 0; i < client->n_shm; i++) {
+		if (client->shm[i].id == info->shm_id) {
+			shm = &client->shm[i];
+			break;
+		}
+	}
+	if (shm == NULL) {
+		errno = ENOENT;
+		return NULL;
+	}
+	if (info->offset > shm->size || info->length > shm->size - info->offset) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return SPA_PTROFF(shm->data, info->offset, void);
+}
+
+int client_queue_shm_release(struct client *client, uint32_t block_id)
+{
+	struct message *msg;
+
+	if ((msg = message_alloc(client->impl, -1, 0)) == NULL)
+		return -errno;
+
+	msg->type = MESSAGE_TYPE_SHM_RELEASE;
+	msg->u.shm_release.block_id = block_id;
+
+	return client_queue_message(client, msg);
+}
+
+void client_close_fds(struct client *client)
+{
+	while (client->n_fds > 0)
+		close(client->fds[--client->n_fds]);
+}
@@ -30,6 +30,24 @@ struct descriptor {
 	uint32_t flags;
 };
 
+/* the payload of a memblock frame that references shared memory */
+struct shm_info {
+	uint32_t block_id;
+	uint32_t shm_id;
+	uint32_t offset;
+	uint32_t length;
+};
+
+#define CLIENT_MAX_FDS	4
+#define CLIENT_MAX_SHM	16
+
+/* a sealed memfd pool of the client, mapped read-only */
+struct client_shm {
+	uint32_t id;
+	void *data;
+	size_t size;
+};
+
 struct client {
 	struct spa_list link;
 	struct impl *impl;
@@ -47,6 +65,10 @@ struct client {
 	uint64_t quirks;
 
 	struct pw_core *core;
+	struct spa_hook core_listener;
+	struct spa_hook client_listener;	/**< while checking the permissions */
+	int core_sync_seq;
+	struct shared_manager *shared;	/**< when `manager` is shared with other clients */
 	struct pw_manager *manager;
 	struct spa_hook manager_listener;
 
@@ -67,6 +89,12 @@ struct client {
 	struct descriptor desc;
 	struct message *message;
 
+	int fds[CLIENT_MAX_FDS];		/**< fds received with the current frame */
+	uint32_t n_fds;
+
+	struct client_shm shm[CLIENT_MAX_SHM];
+	uint32_t n_shm;
+
 	struct pw_map streams;
 	struct spa_list out_messages;
 
@@ -77,6 +105,9 @@ struct client {
 	unsigned int disconnect:1;
 	unsigned int new_msg_since_last_flush:1;
 	unsigned int authenticated:1;
+	unsigned int shm_allowed:1;		/**< unsandboxed local client of the same user */
+	unsigned int use_shm:1;
+	unsigned int use_memfd:1;
 
 	struct pw_manager_object *prev_default_sink;
 	struct pw_manager_object *prev_default_source;
@@ -101,6 +132,11 @@ int client_queue_message(struct client *client, struct message *msg);
 int client_flush_messages(struct client *client);
 int client_queue_subscribe_event(struct client *client, uint32_t facility, uint32_t type, uint32_t index);
 
+int client_attach_shm(struct client *client, uint32_t id, int fd);
+const void *client_get_shm(struct client *client, const struct shm_info *info);
+int client_queue_shm_release(struct client *client, uint32_t block_id);
+void client_close_fds(struct client *client);
+
 void client_update_routes(struct client *client, const char *key, const char *value);
 
 static inline void client_unref(struct client *client)
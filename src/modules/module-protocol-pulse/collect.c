@@ -32,57 +32,60 @@ void select_best(struct selector *s, struct pw_manager_object *o)
 struct pw_manager_object *select_object(struct pw_manager *m, struct selector *s)
 {
 	struct pw_manager_object *o;
-	const char *str;
 
-	spa_list_for_each(o, &m->object_list, link) {
-		if (o->creating || o->removing)
-			continue;
-		if (s->type != NULL && !s->type(o))
-			continue;
-		if (o->id == s->id)
+	if ((o = pw_manager_find_id(m, s->id)) != NULL &&
+	    !o->creating && !o->removing &&
+	    (s->type == NULL || s->type(o)))
+		return o;
+	if ((o = pw_manager_find_index(m, s->index, s->type)) != NULL)
+		return o;
+	if (s->value != NULL) {
+		if (s->key != NULL &&
+		    (o = pw_manager_find_name(m, s->key, s->value, s->type)) != NULL)
 			return o;
-		if (o->index == s->index)
+		if ((o = pw_manager_find_index(m, (uint32_t)atoi(s->value), s->type)) != NULL)
 			return o;
-		if (s->accumulate)
+	}
+	if (s->accumulate != NULL) {
+		/* nothing matched, select from all objects of the type */
+		spa_list_for_each(o, &m->object_list, link) {
+			if (o->creating || o->removing)
+				continue;
+			if (s->type != NULL && !s->type(o))
+				continue;
 			s->accumulate(s, o);
-		if (o->props && s->key != NULL && s->value != NULL &&
-		    (str = pw_properties_get(o->props, s->key)) != NULL &&
-		    spa_streq(str, s->value))
-			return o;
-		if (s->value != NULL && (uint32_t)atoi(s->value) == o->index)
-			return o;
+		}
 	}
 	return s->best;
 }
 
 uint32_t id_to_index(struct pw_manager *m, uint32_t id)
 {
-	struct pw_manager_object *o;
-	spa_list_for_each(o, &m->object_list, link) {
-		if (o->id == id)
-			return o->index;
-	}
-	return SPA_ID_INVALID;
+	struct pw_manager_object *o = pw_manager_find_id(m, id);
+	return o ? o->index : SPA_ID_INVALID;
 }
 
-static bool collect_is_linked(struct pw_manager *m, uint32_t id, enum pw_direction direction)
+/* the links of a node are found with the node id in their properties */
+static int for_each_link(struct pw_manager *m, uint32_t id, enum pw_direction direction,
+		int (*callback) (void *data, struct pw_manager_object *object), void *data)
 {
-	struct pw_manager_object *o;
-	uint32_t in_node, out_node;
+	char str[16];
 
-	spa_list_for_each(o, &m->object_list, link) {
-		if (o->props == NULL || !pw_manager_object_is_link(o))
-			continue;
+	spa_scnprintf(str, sizeof(str), "%u", id);
+	return pw_manager_for_each_name(m,
+			direction == PW_DIRECTION_OUTPUT ?
+				PW_KEY_LINK_OUTPUT_NODE : PW_KEY_LINK_INPUT_NODE,
+			str, callback, data);
+}
 
-		if (pw_properties_fetch_uint32(o->props, PW_KEY_LINK_OUTPUT_NODE, &out_node) != 0 ||
-                    pw_properties_fetch_uint32(o->props, PW_KEY_LINK_INPUT_NODE, &in_node) != 0)
-                        continue;
+static int link_exists(void *data, struct pw_manager_object *o)
+{
+	return pw_manager_object_is_link(o) ? 1 : 0;
+}
 
-		if ((direction == PW_DIRECTION_OUTPUT && id == out_node) ||
-		    (direction == PW_DIRECTION_INPUT && id == in_node))
-			return true;
-	}
-	return false;
+static bool collect_is_linked(struct pw_manager *m, uint32_t id, enum pw_direction direction)
+{
+	return for_each_link(m, id, direction, link_exists, NULL) > 0;
 }
 
 struct pw_manager_object *find_peer_for_link(struct pw_manager *m,
@@ -111,17 +114,29 @@ struct pw_manager_object *find_peer_for_link(struct pw_manager *m,
 	return NULL;
 }
 
+struct link_peer {
+	struct pw_manager *manager;
+	uint32_t id;
+	enum pw_direction direction;
+	struct pw_manager_object *peer;
+};
+
+static int link_peer(void *data, struct pw_manager_object *o)
+{
+	struct link_peer *d = data;
+
+	if (!pw_manager_object_is_link(o))
+		return 0;
+	d->peer = find_peer_for_link(d->manager, o, d->id, d->direction);
+	return d->peer != NULL ? 1 : 0;
+}
+
 struct pw_manager_object *find_linked(struct pw_manager *m, uint32_t id, enum pw_direction direction)
 {
-	struct pw_manager_object *o, *p;
+	struct link_peer d = { .manager = m, .id = id, .direction = direction };
 
-	spa_list_for_each(o, &m->object_list, link) {
-		if (!pw_manager_object_is_link(o))
-			continue;
-		if ((p = find_peer_for_link(m, o, id, direction)) != NULL)
-			return p;
-	}
-	return NULL;
+	for_each_link(m, id, direction, link_peer, &d);
+	return d.peer;
 }
 
 void collect_card_info(struct pw_manager_object *card, struct card_info *info)
@@ -23,6 +23,7 @@ struct pw_loop;
 struct pw_context;
 struct pw_work_queue;
 struct pw_properties;
+struct shared_manager;
 
 struct defs {
 	bool allow_module_loading;
@@ -36,6 +37,8 @@ struct defs {
 	struct channel_map channel_map;
 	uint32_t quantum_limit;
 	uint32_t idle_timeout;
+	bool enable_shm;
+	bool share_manager;
 };
 
 struct stats {
@@ -66,6 +69,7 @@ struct impl {
 	struct pw_map modules;
 
 	struct spa_list free_messages;
+	struct shared_manager *manager;	/**< used by clients without access restrictions */
 	struct defs defs;
 	struct stats stat;
 };
@@ -83,6 +87,8 @@ void impl_add_listener(struct impl *impl,
 		struct spa_hook *listener,
 		const struct impl_events *events, void *data);
 
+void shared_manager_unref(struct shared_manager *sm);
+
 void broadcast_subscribe_event(struct impl *impl, uint32_t facility, uint32_t type, uint32_t id);
 
 #endif
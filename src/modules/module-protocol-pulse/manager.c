@@ -13,7 +13,7 @@
 #include "log.h"
 #include "module-protocol-pulse/server.h"
 
-#define manager_emit_sync(m) spa_hook_list_call(&(m)->hooks, struct pw_manager_events, sync, 0)
+#define manager_emit_sync(l) spa_callbacks_call(&(l)->cb, struct pw_manager_events, sync, 0)
 #define manager_emit_added(m,o) spa_hook_list_call(&(m)->hooks, struct pw_manager_events, added, 0, o)
 #define manager_emit_updated(m,o) spa_hook_list_call(&(m)->hooks, struct pw_manager_events, updated, 0, o)
 #define manager_emit_removed(m,o) spa_hook_list_call(&(m)->hooks, struct pw_manager_events, removed, 0, o)
@@ -23,6 +23,33 @@
 
 struct object;
 
+/* the objects are indexed on these fields, objects with the same value are
+ * kept in list order in the buckets */
+#define INDEX_ID		0
+#define INDEX_INDEX		1
+#define INDEX_NODE_NAME		2
+#define INDEX_DEVICE_NAME	3
+#define INDEX_LINK_OUTPUT_NODE	4
+#define INDEX_LINK_INPUT_NODE	5
+#define N_INDEX			6
+
+#define INDEX_MIN_SIZE		64
+
+static const char * const index_keys[N_INDEX] = {
+	[INDEX_NODE_NAME] = PW_KEY_NODE_NAME,
+	[INDEX_DEVICE_NAME] = PW_KEY_DEVICE_NAME,
+	[INDEX_LINK_OUTPUT_NODE] = PW_KEY_LINK_OUTPUT_NODE,
+	[INDEX_LINK_INPUT_NODE] = PW_KEY_LINK_INPUT_NODE,
+};
+
+struct manager_sync {
+	struct spa_list link;
+	struct spa_hook *listener;	/**< listener to notify, NULL when it is
+					  *  only for the objects */
+	uint64_t id;
+	int seq;
+};
+
 struct manager {
 	struct pw_manager this;
 
@@ -30,9 +57,18 @@ struct manager {
 
 	struct spa_hook core_listener;
 	struct spa_hook registry_listener;
-	int sync_seq;
+	struct spa_list sync_list;	/**< pending syncs, completed in order */
+	struct spa_list wait_list;	/**< completed syncs waiting for new objects */
+	uint64_t sync_id;
+
+	struct spa_list sync_objects;	/**< objects with pending changes, in sync order */
+	struct spa_source *sync_event;	/**< sends one sync for the changed objects */
+	unsigned int sync_scheduled:1;
 
 	struct spa_hook_list hooks;
+
+	uint32_t index_size;		/**< number of buckets, a power of 2 */
+	struct spa_list *index[N_INDEX];
 };
 
 struct object_info {
@@ -51,6 +87,14 @@ struct object_data {
 	struct spa_source *timer;
 };
 
+struct metadata_item {
+	struct spa_list link;
+	uint32_t subject;
+	char *key;
+	char *type;
+	char *value;
+};
+
 struct object {
 	struct pw_manager_object this;
 
@@ -59,19 +103,78 @@ struct object {
 	const struct object_info *info;
 
 	int changed;
+	uint64_t sync_id;		/**< the sync that completes the changes, 0 when
+					  *  there are no pending changes */
+	struct spa_list sync_link;	/**< link in manager sync_objects */
 	struct spa_list pending_list;
 
 	struct spa_hook proxy_listener;
 	struct spa_hook object_listener;
 
 	struct spa_list data_list;
+	struct spa_list metadata_list;	/**< current properties of a metadata object */
+
+	struct spa_list index_link[N_INDEX];
 };
 
-static int core_sync(struct manager *m)
+static int core_sync(struct manager *m, struct spa_hook *listener)
 {
-	m->sync_seq = pw_core_sync(m->this.core, PW_ID_CORE, m->sync_seq);
-	pw_log_debug("sync start %u", m->sync_seq);
-	return m->sync_seq;
+	struct manager_sync *s;
+	int res;
+
+	if ((s = calloc(1, sizeof(*s))) == NULL)
+		return -errno;
+
+	res = pw_core_sync(m->this.core, PW_ID_CORE, 0);
+	if (res < 0) {
+		free(s);
+		return res;
+	}
+	s->listener = listener;
+	s->id = ++m->sync_id;
+	s->seq = res;
+	spa_list_append(&m->sync_list, &s->link);
+
+	pw_log_debug("sync start %u", s->seq);
+	return s->seq;
+}
+
+/* the object has pending changes, they are complete when the server
+ * answered the next sync. The sync is sent from the loop so that the
+ * objects that changed in one iteration are completed together. */
+static void object_sync(struct object *o)
+{
+	struct manager *m = o->manager;
+
+	if (o->sync_id != 0)
+		spa_list_remove(&o->sync_link);
+	o->sync_id = m->sync_id + 1;
+	spa_list_append(&m->sync_objects, &o->sync_link);
+
+	if (!m->sync_scheduled) {
+		m->sync_scheduled = true;
+		pw_loop_signal_event(m->loop, m->sync_event);
+	}
+}
+
+static void on_sync_event(void *data, uint64_t count)
+{
+	struct manager *m = data;
+	struct object *o;
+
+	m->sync_scheduled = false;
+
+	if (!spa_list_is_empty(&m->sync_objects)) {
+		/* a sync for a listener might have been sent after the changes */
+		o = spa_list_last(&m->sync_objects, struct object, sync_link);
+		if (o->sync_id <= m->sync_id)
+			return;
+	} else if (spa_list_is_empty(&m->wait_list)) {
+		return;
+	}
+	/* without objects, this completes the listeners that waited for
+	 * objects that were removed again */
+	core_sync(m, NULL);
 }
 
 static uint32_t clear_params(struct spa_list *param_list, uint32_t id)
@@ -132,10 +235,86 @@ static bool has_param(struct spa_list *param_list, struct pw_manager_param *p)
 	return false;
 }
 
+static inline uint32_t hash_uint32(uint32_t val)
+{
+	return val * 2654435761u;
+}
+
+static inline uint32_t hash_string(const char *str)
+{
+	uint32_t hash = 2166136261u;
+	while (*str != '\0') {
+		hash ^= (uint8_t)*str++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static inline struct spa_list *index_bucket(struct manager *m, uint32_t i, uint32_t hash)
+{
+	return &m->index[i][hash & (m->index_size - 1)];
+}
+
+static const char *object_index_name(struct object *o, uint32_t i)
+{
+	return o->this.props ? pw_properties_get(o->this.props, index_keys[i]) : NULL;
+}
+
+static void object_index_add(struct manager *m, struct object *o)
+{
+	const char *str;
+	uint32_t i;
+
+	spa_list_append(index_bucket(m, INDEX_ID, hash_uint32(o->this.id)),
+			&o->index_link[INDEX_ID]);
+	spa_list_append(index_bucket(m, INDEX_INDEX, hash_uint32(o->this.index)),
+			&o->index_link[INDEX_INDEX]);
+
+	for (i = INDEX_NODE_NAME; i < N_INDEX; i++) {
+		if ((str = object_index_name(o, i)) != NULL)
+			spa_list_append(index_bucket(m, i, hash_string(str)),
+					&o->index_link[i]);
+		else
+			spa_list_init(&o->index_link[i]);
+	}
+}
+
+static void object_index_remove(struct object *o)
+{
+	uint32_t i;
+	for (i = 0; i < N_INDEX; i++)
+		spa_list_remove(&o->index_link[i]);
+}
+
+static int manager_index_resize(struct manager *m, uint32_t size)
+{
+	struct spa_list *buckets;
+	struct object *o;
+	uint32_t i, j;
+
+	buckets = calloc(N_INDEX * size, sizeof(struct spa_list));
+	if (buckets == NULL)
+		return -errno;
+
+	free(m->index[0]);
+	for (i = 0; i < N_INDEX; i++) {
+		m->index[i] = &buckets[i * size];
+		for (j = 0; j < size; j++)
+			spa_list_init(&m->index[i][j]);
+	}
+	m->index_size = size;
+
+	spa_list_for_each(o, &m->this.object_list, this.link)
+		object_index_add(m, o);
+
+	pw_log_debug("manager %p: index resized to %u", m, size);
+	return 0;
+}
+
 static struct object *find_object_by_id(struct manager *m, uint32_t id)
 {
 	struct object *o;
-	spa_list_for_each(o, &m->this.object_list, this.link) {
+	spa_list_for_each(o, index_bucket(m, INDEX_ID, hash_uint32(id)), index_link[INDEX_ID]) {
 		if (o->this.id == id)
 			return o;
 	}
@@ -185,11 +364,24 @@ static void object_data_free(struct object_data *d)
 	free(d);
 }
 
+static void metadata_item_free(struct metadata_item *item)
+{
+	spa_list_remove(&item->link);
+	free(item->key);
+	free(item->type);
+	free(item->value);
+	free(item);
+}
+
 static void object_destroy(struct object *o)
 {
 	struct manager *m = o->manager;
 	struct object_data *d;
+	struct metadata_item *item;
 	spa_list_remove(&o->this.link);
+	if (o->sync_id != 0)
+		spa_list_remove(&o->sync_link);
+	object_index_remove(o);
 	m->this.n_objects--;
 	if (o->this.proxy)
 		pw_proxy_destroy(o->this.proxy);
@@ -200,6 +392,8 @@ static void object_destroy(struct object *o)
 	clear_params(&o->pending_list, SPA_ID_INVALID);
 	spa_list_consume(d, &o->data_list, link)
 		object_data_free(d);
+	spa_list_consume(item, &o->metadata_list, link)
+		metadata_item_free(item);
 	free(o);
 }
 
@@ -226,7 +420,7 @@ static void client_event_info(void *data, const struct pw_client_info *info)
 
 	if (changed) {
 		o->changed += changed;
-		core_sync(o->manager);
+		object_sync(o);
 	}
 }
 
@@ -267,7 +461,7 @@ static void module_event_info(void *data, const struct pw_module_info *info)
 
 	if (changed) {
 		o->changed += changed;
-		core_sync(o->manager);
+		object_sync(o);
 	}
 }
 
@@ -342,7 +536,7 @@ static void device_event_info(void *data, const struct pw_device_info *info)
 	}
 	if (changed || enumerate) {
 		o->changed += changed;
-		core_sync(o->manager);
+		object_sync(o);
 	}
 }
 static struct object *find_device(struct manager *m, uint32_t card_id, uint32_t device)
@@ -389,7 +583,7 @@ static void device_event_param(void *data, int seq,
 
 		if ((dev = find_device(m, o->this.id, device)) != NULL) {
 			dev->changed++;
-			core_sync(o->manager);
+			object_sync(dev);
 		}
 	}
 }
@@ -474,7 +668,7 @@ static void node_event_info(void *data, const struct pw_node_info *info)
 	}
 	if (changed || enumerate) {
 		o->changed += changed;
-		core_sync(o->manager);
+		object_sync(o);
 	}
 }
 
@@ -514,6 +708,40 @@ static const struct object_info link_info = {
 };
 
 /* metadata */
+static void metadata_update_item(struct object *o, uint32_t subject,
+		const char *key, const char *type, const char *value)
+{
+	struct metadata_item *item, *t;
+
+	spa_list_for_each_safe(item, t, &o->metadata_list, link) {
+		if (item->subject != subject ||
+		    (key != NULL && !spa_streq(item->key, key)))
+			continue;
+		metadata_item_free(item);
+	}
+	if (key == NULL || value == NULL)
+		return;
+
+	item = calloc(1, sizeof(*item));
+	if (item == NULL)
+		goto error;
+
+	item->subject = subject;
+	item->key = strdup(key);
+	item->type = type ? strdup(type) : NULL;
+	item->value = strdup(value);
+	spa_list_append(&o->metadata_list, &item->link);
+
+	if (item->key == NULL || item->value == NULL ||
+	    (type != NULL && item->type == NULL)) {
+		metadata_item_free(item);
+		goto error;
+	}
+	return;
+error:
+	pw_log_warn("object %p: can't store metadata %s: %m", o, key);
+}
+
 static int metadata_property(void *data,
 			uint32_t subject,
 			const char *key,
@@ -522,6 +750,7 @@ static int metadata_property(void *data,
 {
 	struct object *o = data;
 	struct manager *m = o->manager;
+	metadata_update_item(o, subject, key, type, value);
 	manager_emit_metadata(m, &o->this, subject, key, type, value);
 	return 0;
 }
@@ -537,6 +766,7 @@ static void metadata_init(struct object *object)
 	struct manager *m = o->manager;
 	o->this.creating = false;
 	manager_emit_added(m, &o->this);
+	o->this.change_mask = 0;
 }
 
 static const struct object_info metadata_info = {
@@ -637,12 +867,18 @@ static void registry_event_global(void *data, uint32_t id,
 	spa_list_init(&o->this.param_list);
 	spa_list_init(&o->pending_list);
 	spa_list_init(&o->data_list);
+	spa_list_init(&o->metadata_list);
 
 	o->manager = m;
 	o->info = info;
 	spa_list_append(&m->this.object_list, &o->this.link);
 	m->this.n_objects++;
 
+	/* a resize indexes all objects, including this one */
+	if (m->this.n_objects <= m->index_size ||
+	    manager_index_resize(m, m->index_size * 2) < 0)
+		object_index_add(m, o);
+
 	if (info->events)
 		pw_proxy_add_object_listener(proxy,
 				&o->object_listener,
@@ -654,7 +890,7 @@ static void registry_event_global(void *data, uint32_t id,
 	if (info->init)
 		info->init(o);
 
-	core_sync(m);
+	object_sync(o);
 }
 
 static void registry_event_global_remove(void *data, uint32_t id)
@@ -686,33 +922,92 @@ static void on_core_info(void *data, const struct pw_core_info *info)
 	m->this.info = pw_core_info_merge(m->this.info, info, true);
 }
 
+static struct manager_sync *find_sync(struct manager *m, int seq)
+{
+	struct manager_sync *s;
+
+	spa_list_for_each(s, &m->sync_list, link) {
+		if (s->seq == seq)
+			return s;
+	}
+	return NULL;
+}
+
+static bool objects_creating(struct manager *m)
+{
+	struct object *o;
+
+	spa_list_for_each(o, &m->sync_objects, sync_link) {
+		if (o->this.creating)
+			return true;
+	}
+	return false;
+}
+
 static void on_core_done(void *data, uint32_t id, int seq)
 {
 	struct manager *m = data;
+	struct manager_sync *s;
 	struct object *o;
+	uint64_t sync_id;
+	bool last;
 
-	if (id == PW_ID_CORE) {
-		if (m->sync_seq != seq)
-			return;
-
-		pw_log_debug("sync end %u/%u", m->sync_seq, seq);
+	if (id != PW_ID_CORE || (s = find_sync(m, seq)) == NULL)
+		return;
 
-		manager_emit_sync(m);
+	pw_log_debug("sync end %u", seq);
+
+	sync_id = s->id;
+	/* the server answers the syncs in order, this completes the earlier
+	 * ones as well */
+	spa_list_consume(s, &m->sync_list, link) {
+		last = s->seq == seq;
+		spa_list_remove(&s->link);
+		if (s->listener != NULL)
+			spa_list_append(&m->wait_list, &s->link);
+		else
+			free(s);
+		if (last)
+			break;
+	}
 
-		spa_list_for_each(o, &m->this.object_list, this.link)
-			object_update_params(o);
+	/* the objects that changed after this sync was started are not
+	 * complete yet, they come after the complete ones */
+	spa_list_for_each(o, &m->sync_objects, sync_link) {
+		if (o->sync_id > sync_id)
+			break;
+		object_update_params(o);
+	}
 
-		spa_list_for_each(o, &m->this.object_list, this.link) {
-			if (o->this.creating) {
-				o->this.creating = false;
-				manager_emit_added(m, &o->this);
-				o->changed = 0;
-			} else if (o->changed > 0) {
-				manager_emit_updated(m, &o->this);
-				o->changed = 0;
-			}
-			object_reset_params(o);
+	spa_list_consume(o, &m->sync_objects, sync_link) {
+		if (o->sync_id > sync_id)
+			break;
+		spa_list_remove(&o->sync_link);
+		o->sync_id = 0;
+
+		if (o->this.creating) {
+			o->this.creating = false;
+			manager_emit_added(m, &o->this);
+			o->changed = 0;
+		} else if (o->changed > 0) {
+			manager_emit_updated(m, &o->this);
+			o->changed = 0;
 		}
+		/* all listeners have seen the changes now */
+		o->this.change_mask = 0;
+		object_reset_params(o);
+	}
+
+	/* the listeners see the objects that were announced before their
+	 * sync completed as added */
+	if (objects_creating(m))
+		return;
+
+	spa_list_consume(s, &m->wait_list, link) {
+		spa_list_remove(&s->link);
+		if (s->listener != NULL)
+			manager_emit_sync(s->listener);
+		free(s);
 	}
 }
 
@@ -756,6 +1051,19 @@ struct pw_manager *pw_manager_new(struct pw_core *core)
 	spa_hook_list_init(&m->hooks);
 
 	spa_list_init(&m->this.object_list);
+	spa_list_init(&m->sync_list);
+	spa_list_init(&m->wait_list);
+	spa_list_init(&m->sync_objects);
+
+	m->sync_event = pw_loop_add_event(m->loop, on_sync_event, m);
+	if (m->sync_event == NULL ||
+	    manager_index_resize(m, INDEX_MIN_SIZE) < 0) {
+		if (m->sync_event)
+			pw_loop_destroy_source(m->loop, m->sync_event);
+		pw_proxy_destroy((struct pw_proxy*)m->this.registry);
+		free(m);
+		return NULL;
+	}
 
 	pw_core_add_listener(m->this.core,
 			&m->core_listener,
@@ -767,13 +1075,58 @@ struct pw_manager *pw_manager_new(struct pw_core *core)
 	return &m->this;
 }
 
+/* a removed listener can't be notified of its pending syncs anymore */
+static void on_listener_removed(struct spa_hook *listener)
+{
+	struct manager *m = listener->priv;
+	struct manager_sync *s;
+
+	spa_list_for_each(s, &m->sync_list, link) {
+		if (s->listener == listener)
+			s->listener = NULL;
+	}
+	spa_list_for_each(s, &m->wait_list, link) {
+		if (s->listener == listener)
+			s->listener = NULL;
+	}
+	listener->removed = NULL;
+	listener->priv = NULL;
+}
+
 void pw_manager_add_listener(struct pw_manager *manager,
 		struct spa_hook *listener,
 		const struct pw_manager_events *events, void *data)
 {
 	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
 	spa_hook_list_append(&m->hooks, listener, events, data);
-	core_sync(m);
+	listener->removed = on_listener_removed;
+	listener->priv = m;
+	core_sync(m, listener);
+}
+
+void pw_manager_replay(struct pw_manager *manager,
+		const struct pw_manager_events *events, void *data)
+{
+	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	struct object *o;
+	struct metadata_item *item;
+
+	if (events->added) {
+		spa_list_for_each(o, &m->this.object_list, this.link) {
+			if (o->this.creating || o->this.removing)
+				continue;
+			events->added(data, &o->this);
+		}
+	}
+	if (events->metadata) {
+		spa_list_for_each(o, &m->this.object_list, this.link) {
+			if (o->this.creating || o->this.removing)
+				continue;
+			spa_list_for_each(item, &o->metadata_list, link)
+				events->metadata(data, &o->this, item->subject,
+						item->key, item->type, item->value);
+		}
+	}
 }
 
 int pw_manager_set_metadata(struct pw_manager *manager,
@@ -834,21 +1187,34 @@ int pw_manager_for_each_object(struct pw_manager *manager,
 void pw_manager_destroy(struct pw_manager *manager)
 {
 	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	struct manager_sync *s;
 	struct object *o;
 
 	spa_hook_list_clean(&m->hooks);
 
 	spa_hook_remove(&m->core_listener);
 
+	spa_list_consume(s, &m->sync_list, link) {
+		spa_list_remove(&s->link);
+		free(s);
+	}
+	spa_list_consume(s, &m->wait_list, link) {
+		spa_list_remove(&s->link);
+		free(s);
+	}
+
 	spa_list_consume(o, &m->this.object_list, this.link)
 		object_destroy(o);
 
+	pw_loop_destroy_source(m->loop, m->sync_event);
+
 	spa_hook_remove(&m->registry_listener);
 	pw_proxy_destroy((struct pw_proxy*)m->this.registry);
 
 	if (m->this.info)
 		pw_core_info_free(m->this.info);
 
+	free(m->index[0]);
 	free(m);
 }
 
@@ -939,10 +1305,98 @@ void *pw_manager_object_get_data(struct pw_manager_object *obj, const char *id)
 	return d ? SPA_PTROFF(d, sizeof(*d), void) : NULL;
 }
 
-int pw_manager_sync(struct pw_manager *manager)
+int pw_manager_sync(struct pw_manager *manager, struct spa_hook *listener)
+{
+	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	return core_sync(m, listener);
+}
+
+struct pw_manager_object *pw_manager_find_id(struct pw_manager *manager, uint32_t id)
 {
 	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
-	return core_sync(m);
+	struct object *o = find_object_by_id(m, id);
+	return o ? &o->this : NULL;
+}
+
+static inline bool object_matches(struct object *o,
+		bool (*type) (struct pw_manager_object *o))
+{
+	return !o->this.creating && !o->this.removing &&
+		(type == NULL || type(&o->this));
+}
+
+struct pw_manager_object *pw_manager_find_index(struct pw_manager *manager, uint32_t index,
+		bool (*type) (struct pw_manager_object *o))
+{
+	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	struct object *o;
+
+	spa_list_for_each(o, index_bucket(m, INDEX_INDEX, hash_uint32(index)), index_link[INDEX_INDEX]) {
+		if (o->this.index == index && object_matches(o, type))
+			return &o->this;
+	}
+	return NULL;
+}
+
+struct pw_manager_object *pw_manager_find_name(struct pw_manager *manager,
+		const char *key, const char *value,
+		bool (*type) (struct pw_manager_object *o))
+{
+	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	struct object *o;
+	const char *str;
+	uint32_t i;
+
+	for (i = INDEX_NODE_NAME; i < N_INDEX; i++) {
+		if (!spa_streq(index_keys[i], key))
+			continue;
+		spa_list_for_each(o, index_bucket(m, i, hash_string(value)), index_link[i]) {
+			if (spa_streq(object_index_name(o, i), value) &&
+			    object_matches(o, type))
+				return &o->this;
+		}
+		return NULL;
+	}
+
+	spa_list_for_each(o, &m->this.object_list, this.link) {
+		if (o->this.props != NULL &&
+		    (str = pw_properties_get(o->this.props, key)) != NULL &&
+		    spa_streq(str, value) && object_matches(o, type))
+			return &o->this;
+	}
+	return NULL;
+}
+
+int pw_manager_for_each_name(struct pw_manager *manager,
+		const char *key, const char *value,
+		int (*callback) (void *data, struct pw_manager_object *object),
+		void *data)
+{
+	struct manager *m = SPA_CONTAINER_OF(manager, struct manager, this);
+	struct object *o;
+	const char *str;
+	uint32_t i;
+	int res;
+
+	for (i = INDEX_NODE_NAME; i < N_INDEX; i++) {
+		if (!spa_streq(index_keys[i], key))
+			continue;
+		spa_list_for_each(o, index_bucket(m, i, hash_string(value)), index_link[i]) {
+			if (spa_streq(object_index_name(o, i), value) &&
+			    (res = callback(data, &o->this)) != 0)
+				return res;
+		}
+		return 0;
+	}
+
+	spa_list_for_each(o, &m->this.object_list, this.link) {
+		if (o->this.props != NULL &&
+		    (str = pw_properties_get(o->this.props, key)) != NULL &&
+		    spa_streq(str, value) &&
+		    (res = callback(data, &o->this)) != 0)
+			return res;
+	}
+	return 0;
 }
 
 bool pw_manager_object_is_client(struct pw_manager_object *o)
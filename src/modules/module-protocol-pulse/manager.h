@@ -80,7 +80,9 @@ struct pw_manager_object {
 
 #define PW_MANAGER_OBJECT_FLAG_SOURCE	(1<<0)
 #define PW_MANAGER_OBJECT_FLAG_SINK	(1<<1)
-	uint64_t change_mask;	/* object specific params change mask */
+#define PW_MANAGER_OBJECT_FLAG_LATENCY_OFFSET	(1<<2)
+	uint64_t change_mask;	/* object specific params change mask, cleared after
+				 * all listeners saw the added/updated event */
 	struct spa_list param_list;
 	unsigned int creating:1;
 	unsigned int removing:1;
@@ -92,7 +94,14 @@ void pw_manager_add_listener(struct pw_manager *manager,
 		struct spa_hook *listener,
 		const struct pw_manager_events *events, void *data);
 
-int pw_manager_sync(struct pw_manager *manager);
+/* emit the sync event on listener when the manager has seen everything the
+ * server did before this call. Adding a listener also does this. */
+int pw_manager_sync(struct pw_manager *manager, struct spa_hook *listener);
+
+/* emit the added event for all current objects and the metadata event for all
+ * current metadata properties, for a listener added to a populated manager */
+void pw_manager_replay(struct pw_manager *manager,
+		const struct pw_manager_events *events, void *data);
 
 void pw_manager_destroy(struct pw_manager *manager);
 
@@ -101,6 +110,26 @@ int pw_manager_set_metadata(struct pw_manager *manager,
 		uint32_t subject, const char *key, const char *type,
 		const char *format, ...) SPA_PRINTF_FUNC(6,7);
 
+/* lookup an object by global id, also when it is being created or removed */
+struct pw_manager_object *pw_manager_find_id(struct pw_manager *manager, uint32_t id);
+
+/* lookup the first object with the given index or property value that is not
+ * being created or removed and where type, when given, returns true. Lookups
+ * on node.name, device.name, link.output.node and link.input.node use an
+ * index, other keys scan all objects. */
+struct pw_manager_object *pw_manager_find_index(struct pw_manager *manager, uint32_t index,
+		bool (*type) (struct pw_manager_object *o));
+struct pw_manager_object *pw_manager_find_name(struct pw_manager *manager,
+		const char *key, const char *value,
+		bool (*type) (struct pw_manager_object *o));
+
+/* call callback for all objects with the given property value, also when they
+ * are being created or removed, until it returns non-zero */
+int pw_manager_for_each_name(struct pw_manager *manager,
+		const char *key, const char *value,
+		int (*callback) (void *data, struct pw_manager_object *object),
+		void *data);
+
 int pw_manager_for_each_object(struct pw_manager *manager,
 		int (*callback) (void *data, struct pw_manager_object *object),
 		void *data);
@@ -12,10 +12,13 @@
 #include <spa/support/log.h>
 
 struct impl;
+struct stream;
 
 enum message_type {
 	MESSAGE_TYPE_UNSPECIFIED,
 	MESSAGE_TYPE_SUBSCRIPTION_EVENT,
+	MESSAGE_TYPE_SHM_RELEASE,
+	MESSAGE_TYPE_RECORD,		/**< data is in the ringbuffer of the stream */
 };
 
 struct message {
@@ -33,6 +36,13 @@ struct message {
 			uint32_t event;
 			uint32_t index;
 		} subscription_event;
+		struct {
+			uint32_t block_id;
+		} shm_release;
+		struct {
+			struct stream *stream;
+			uint32_t index;
+		} record;
 	} u;
 };
 
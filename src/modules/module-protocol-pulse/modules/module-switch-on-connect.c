@@ -195,7 +195,7 @@ static int module_switch_on_connect_load(struct module *module)
 	pw_core_add_listener(d->core, &d->core_listener, &core_events, d);
 
 	/* Postpone setting started flag after initial nodes emitted */
-	pw_manager_sync(d->manager);
+	pw_manager_sync(d->manager, &d->manager_listener);
 
 	return 0;
 
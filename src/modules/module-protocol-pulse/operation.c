@@ -28,7 +28,7 @@ int operation_new_cb(struct client *client, uint32_t tag,
 	o->data = data;
 
 	spa_list_append(&client->operations, &o->link);
-	pw_manager_sync(client->manager);
+	pw_manager_sync(client->manager, &client->manager_listener);
 
 	pw_log_debug("client %p [%s]: new operation tag:%u", client, client->name, tag);
 
@@ -55,6 +55,9 @@
 #include "stream.h"
 #include "utils.h"
 #include "volume.h"
+#ifdef HAVE_SNAP
+#include "snap-policy.h"
+#endif
 
 #define DEFAULT_ALLOW_MODULE_LOADING 	"true"
 #define DEFAULT_MIN_REQ		"128/48000"
@@ -66,6 +69,8 @@
 #define DEFAULT_FORMAT		"F32"
 #define DEFAULT_POSITION	"[ FL FR ]"
 #define DEFAULT_IDLE_TIMEOUT	"0"
+#define DEFAULT_ENABLE_SHM	"true"
+#define DEFAULT_SHARE_MANAGER	"false"
 
 #define MAX_FORMATS	32
 /* The max amount of data we send in one block when capturing. In PulseAudio this
@@ -128,22 +133,64 @@ static int do_command_auth(struct client *client, uint32_t command, uint32_t tag
 	if (len != NATIVE_COOKIE_LENGTH)
 		return -EINVAL;
 
-	if ((version & PROTOCOL_VERSION_MASK) >= 13)
+	if ((version & PROTOCOL_VERSION_MASK) >= 13) {
+		/* the client sets the high bits when it can send its data in
+		 * shared memory. Only memfd pools are accepted, they are
+		 * passed over the socket and sealed. memfd is used from
+		 * version 32 on because version 31 clients have broken
+		 * memfd support. */
+		client->use_memfd = client->shm_allowed &&
+			(version & PROTOCOL_VERSION_MASK) >= 32 &&
+			SPA_FLAG_IS_SET(version, PROTOCOL_FLAG_SHM) &&
+			SPA_FLAG_IS_SET(version, PROTOCOL_FLAG_MEMFD);
+		client->use_shm = client->use_memfd;
 		version &= PROTOCOL_VERSION_MASK;
+	}
 
 	client->version = version;
 	client->authenticated = true;
 
-	pw_log_info("client:%p AUTH tag:%u version:%d", client, tag, version);
+	pw_log_info("client:%p AUTH tag:%u version:%d shm:%d memfd:%d", client, tag,
+			version, client->use_shm, client->use_memfd);
 
+	/* The client only uses shared memory when the reply comes with
+	 * credentials of the same user. They are added by the kernel because
+	 * libpulse enables SO_PASSCRED on its socket. */
 	reply = reply_new(client, tag);
 	message_put(reply,
-			TAG_U32, PROTOCOL_VERSION,
+			TAG_U32, PROTOCOL_VERSION |
+				(client->use_shm ? PROTOCOL_FLAG_SHM : 0) |
+				(client->use_memfd ? PROTOCOL_FLAG_MEMFD : 0),
 			TAG_INVALID);
 
 	return client_queue_message(client, reply);
 }
 
+static int do_register_memfd_shmid(struct client *client, uint32_t command, uint32_t tag, struct message *m)
+{
+	uint32_t shm_id;
+	int res;
+
+	if (message_get(m,
+			TAG_U32, &shm_id,
+			TAG_INVALID) < 0)
+		return -EPROTO;
+
+	pw_log_info("[%s] REGISTER_MEMFD_SHMID tag:%u shm_id:%u fds:%u", client->name,
+			tag, shm_id, client->n_fds);
+
+	if (!client->use_memfd || client->n_fds != 1)
+		return -EPROTO;
+
+	/* the memfd is mapped, the fd is closed when the packet is done */
+	if ((res = client_attach_shm(client, shm_id, client->fds[0])) < 0) {
+		pw_log_warn("[%s] can't attach memfd shm_id:%u: %s", client->name,
+				shm_id, spa_strerror(res));
+		return res;
+	}
+	return 0;
+}
+
 static int reply_set_client_name(struct client *client, uint32_t tag)
 {
 	struct pw_manager *manager = client->manager;
@@ -177,7 +224,8 @@ static void manager_sync(void *data)
 
 	pw_log_debug("%p: manager sync", client);
 
-	if (client->connect_tag != SPA_ID_INVALID) {
+	/* with a shared manager, wait until our own client is known */
+	if (client->connect_tag != SPA_ID_INVALID && client->core_sync_seq == 0) {
 		reply_set_client_name(client, client->connect_tag);
 		client->connect_tag = SPA_ID_INVALID;
 	}
@@ -333,7 +381,6 @@ static void send_latency_offset_subscribe_event(struct client *client, struct pw
 	const char *str;
 	uint32_t card_id = SPA_ID_INVALID;
 	int64_t latency_offset = 0LL;
-	bool changed = false;
 
 	if (!pw_manager_object_is_sink(o) && !pw_manager_object_is_source_or_monitor(o))
 		return;
@@ -353,12 +400,14 @@ static void send_latency_offset_subscribe_event(struct client *client, struct pw
 		return;
 
 	latency_offset = get_node_latency_offset(o);
-	changed = (!d->initialized || latency_offset != d->prev_latency_offset);
-
-	d->prev_latency_offset = latency_offset;
-	d->initialized = true;
+	if (!d->initialized || latency_offset != d->prev_latency_offset) {
+		d->prev_latency_offset = latency_offset;
+		d->initialized = true;
+		/* the other clients of a shared manager see the change in the mask */
+		o->change_mask |= PW_MANAGER_OBJECT_FLAG_LATENCY_OFFSET;
+	}
 
-	if (changed)
+	if (o->change_mask & PW_MANAGER_OBJECT_FLAG_LATENCY_OFFSET)
 		client_queue_subscribe_event(client,
 				SUBSCRIPTION_EVENT_CARD,
 				SUBSCRIPTION_EVENT_CHANGE,
@@ -869,8 +918,6 @@ static void manager_added(void *data, struct pw_manager_object *o)
 
 	send_object_event(client, o, SUBSCRIPTION_EVENT_NEW);
 
-	o->change_mask = 0;
-
 	/* Adding sinks etc. may also change defaults */
 	send_default_change_subscribe_event(client, pw_manager_object_is_sink(o), pw_manager_object_is_source_or_monitor(o));
 }
@@ -885,8 +932,6 @@ static void manager_updated(void *data, struct pw_manager_object *o)
 
 	send_object_event(client, o, SUBSCRIPTION_EVENT_CHANGE);
 
-	o->change_mask = 0;
-
 	set_temporary_move_target(client, o, SPA_ID_INVALID);
 
 	send_latency_offset_subscribe_event(client, o);
@@ -992,6 +1037,239 @@ static const struct pw_manager_events manager_events = {
 	.object_data_timeout = manager_object_data_timeout,
 };
 
+static void client_core_done(void *data, uint32_t id, int seq)
+{
+	struct client *client = data;
+
+	if (id != PW_ID_CORE || seq != client->core_sync_seq)
+		return;
+
+	/* the server knows our client now, wait for the shared manager to see it */
+	client->core_sync_seq = 0;
+	pw_manager_sync(client->manager, &client->manager_listener);
+}
+
+static void client_core_error(void *data, uint32_t id, int seq, int res, const char *message)
+{
+	struct client *client = data;
+
+	if (id == PW_ID_CORE && res == -EPIPE) {
+		pw_log_debug("[%s] connection error: %d, %s", client->name, res, message);
+		pw_work_queue_add(client->impl->work_queue, client, 0,
+				do_free_client, NULL);
+	}
+}
+
+static const struct pw_core_events client_core_events = {
+	PW_VERSION_CORE_EVENTS,
+	.done = client_core_done,
+	.error = client_core_error,
+};
+
+struct shared_manager {
+	struct impl *impl;
+	int ref;
+
+	struct pw_core *core;
+	struct pw_manager *manager;
+	struct spa_hook manager_listener;
+};
+
+void shared_manager_unref(struct shared_manager *sm)
+{
+	if (--sm->ref > 0)
+		return;
+
+	pw_log_debug("shared manager %p: free", sm);
+
+	pw_manager_destroy(sm->manager);
+	pw_core_disconnect(sm->core);
+	free(sm);
+}
+
+static void do_unref_shared_manager(void *obj, void *data, int res, uint32_t id)
+{
+	shared_manager_unref(obj);
+}
+
+static void shared_manager_disconnect(void *data)
+{
+	struct shared_manager *sm = data;
+	struct impl *impl = sm->impl;
+
+	pw_log_debug("shared manager %p: disconnect", sm);
+
+	/* the clients are freed from their own disconnect event, new
+	 * clients will make a new manager */
+	if (impl->manager == sm) {
+		impl->manager = NULL;
+		pw_work_queue_add(impl->work_queue, sm, 0,
+				do_unref_shared_manager, NULL);
+	}
+}
+
+static const struct pw_manager_events shared_manager_events = {
+	PW_VERSION_MANAGER_EVENTS,
+	.disconnect = shared_manager_disconnect,
+};
+
+static struct shared_manager *shared_manager_get(struct impl *impl)
+{
+	struct shared_manager *sm = impl->manager;
+
+	if (sm == NULL) {
+		sm = calloc(1, sizeof(*sm));
+		if (sm == NULL)
+			return NULL;
+
+		sm->impl = impl;
+		sm->ref = 1;
+		sm->core = pw_context_connect(impl->context,
+				pw_properties_new(
+					PW_KEY_APP_NAME, "pipewire-pulse",
+					NULL),
+				0);
+		if (sm->core == NULL)
+			goto error;
+		sm->manager = pw_manager_new(sm->core);
+		if (sm->manager == NULL)
+			goto error;
+
+		pw_manager_add_listener(sm->manager, &sm->manager_listener,
+				&shared_manager_events, sm);
+
+		pw_log_info("shared manager %p: new", sm);
+		/* keep the manager around, clients often come in bursts */
+		impl->manager = sm;
+	}
+	sm->ref++;
+	return sm;
+
+error:
+	if (sm->core)
+		pw_core_disconnect(sm->core);
+	free(sm);
+	return NULL;
+}
+
+/* only clients that get the same permissions as our own connection
+ * can share its view of the objects. This is a first check on the access
+ * of the client, the permissions it got are checked when connected. */
+static bool client_can_share_manager(struct client *client)
+{
+	const char *str;
+
+	if (!client->impl->defs.share_manager)
+		return false;
+	if ((str = pw_properties_get(client->props, PW_KEY_CLIENT_ACCESS)) != NULL &&
+	    !spa_streq(str, "unrestricted"))
+		return false;
+#ifdef HAVE_SNAP
+	if (pw_properties_get(client->props, PW_KEY_SNAP_ID) != NULL)
+		return false;
+#endif
+	return true;
+}
+
+static int client_connect_shared(struct client *client, uint32_t tag)
+{
+	struct impl *impl = client->impl;
+	int res;
+
+	if ((client->shared = shared_manager_get(impl)) == NULL)
+		return -errno;
+
+	client->manager = client->shared->manager;
+	client->connect_tag = tag;
+
+	pw_core_add_listener(client->core, &client->core_listener,
+			&client_core_events, client);
+	pw_manager_add_listener(client->manager, &client->manager_listener,
+			&manager_events, client);
+	/* catch up with the objects and defaults the manager already has */
+	pw_manager_replay(client->manager, &manager_events, client);
+
+	res = pw_core_sync(client->core, PW_ID_CORE, 0);
+	if (res < 0)
+		return res;
+	client->core_sync_seq = res;
+	return 0;
+}
+
+static int client_connect_private(struct client *client, uint32_t tag)
+{
+	client->manager = pw_manager_new(client->core);
+	if (client->manager == NULL)
+		return -errno;
+
+	client->connect_tag = tag;
+	pw_manager_add_listener(client->manager, &client->manager_listener,
+			&manager_events, client);
+	return 0;
+}
+
+static bool permissions_are_full(const struct pw_permission *permissions, uint32_t n_permissions)
+{
+	uint32_t i;
+
+	/* the first one is the default for all objects, the others are
+	 * exceptions or unset */
+	for (i = 0; i < n_permissions; i++) {
+		if (permissions[i].permissions == PW_PERM_INVALID)
+			continue;
+		if ((permissions[i].permissions & PW_PERM_ALL) != PW_PERM_ALL)
+			return false;
+	}
+	return n_permissions > 0 && permissions[0].id == PW_ID_ANY;
+}
+
+static void client_permissions(void *data, uint32_t index,
+		uint32_t n_permissions, const struct pw_permission *permissions)
+{
+	struct client *client = data;
+	uint32_t tag = client->connect_tag;
+	int res;
+
+	spa_hook_remove(&client->client_listener);
+	spa_zero(client->client_listener);
+
+	if (index == 0 && permissions_are_full(permissions, n_permissions)) {
+		pw_log_info("[%s] using shared manager", client->name);
+		res = client_connect_shared(client, tag);
+	} else {
+		pw_log_info("[%s] restricted permissions, using own manager", client->name);
+		res = client_connect_private(client, tag);
+	}
+	if (res < 0) {
+		pw_log_error("%p: failed to connect client: %s", client->impl, spa_strerror(res));
+		client->connect_tag = SPA_ID_INVALID;
+		reply_error(client, COMMAND_SET_CLIENT_NAME, tag, res);
+	}
+}
+
+static const struct pw_client_events client_permission_events = {
+	PW_VERSION_CLIENT_EVENTS,
+	.permissions = client_permissions,
+};
+
+/* ask for the permissions our client got, the manager is made when they
+ * arrive */
+static int client_check_permissions(struct client *client, uint32_t tag)
+{
+	struct pw_client *c;
+	int res;
+
+	if ((c = pw_core_get_client(client->core)) == NULL)
+		return -ENOENT;
+
+	client->connect_tag = tag;
+	pw_client_add_listener(c, &client->client_listener,
+			&client_permission_events, client);
+
+	res = pw_client_get_permissions(c, 0, UINT32_MAX);
+	return res < 0 ? res : 0;
+}
+
 static int do_set_client_name(struct client *client, uint32_t command, uint32_t tag, struct message *m)
 {
 	struct impl *impl = client->impl;
@@ -1027,14 +1305,12 @@ static int do_set_client_name(struct client *client, uint32_t command, uint32_t
 			res = -errno;
 			goto error;
 		}
-		client->manager = pw_manager_new(client->core);
-		if (client->manager == NULL) {
-			res = -errno;
+		if (client_can_share_manager(client))
+			res = client_check_permissions(client, tag);
+		else
+			res = client_connect_private(client, tag);
+		if (res < 0)
 			goto error;
-		}
-		client->connect_tag = tag;
-		pw_manager_add_listener(client->manager, &client->manager_listener,
-				&manager_events, client);
 	} else {
 		if (changed)
 			pw_core_update_properties(client->core, &client->props->dict);
@@ -1246,7 +1522,6 @@ do_process_done(struct spa_loop *loop,
 {
 	struct stream *stream = user_data;
 	struct client *client = stream->client;
-	struct impl *impl = client->impl;
 	const struct process_data *pd = data;
 	uint32_t index, towrite;
 	int32_t avail;
@@ -1294,14 +1569,18 @@ do_process_done(struct spa_loop *loop,
 
 		stream_send_request(stream);
 	} else {
-		struct message *msg;
+		int res;
+
 		stream->write_index += pd->write_inc;
 
 		avail = spa_ringbuffer_get_read_index(&stream->ring, &index);
 
-		if (!spa_list_is_empty(&client->out_messages)) {
-			pw_log_debug("%p: [%s] pending read:%u avail:%d",
-					stream, client->name, index, avail);
+		/* wait until the client got the data we queued before, the
+		 * other streams of the client can still queue theirs */
+		if (stream->record_pending > 0) {
+			pw_log_debug("%p: [%s] pending read:%u avail:%d pending:%u",
+					stream, client->name, index, avail,
+					stream->record_pending);
 			return 0;
 		}
 
@@ -1319,6 +1598,7 @@ do_process_done(struct spa_loop *loop,
 				index += skip;
 				stream->read_index += skip;
 				avail = stream->attr.fragsize;
+				spa_ringbuffer_read_update(&stream->ring, index);
 			}
 			pw_log_trace("avail:%d index:%u", avail, index);
 
@@ -1327,22 +1607,14 @@ do_process_done(struct spa_loop *loop,
 				towrite = SPA_MIN(towrite, stream->attr.fragsize);
 				towrite = SPA_ROUND_DOWN(towrite, stream->frame_size);
 
-				msg = message_alloc(impl, stream->channel, towrite);
-				if (msg == NULL)
-					return -errno;
-
-				spa_ringbuffer_read_data(&stream->ring,
-						stream->buffer, MAXLENGTH,
-						index % MAXLENGTH,
-						msg->data, towrite);
-
-				client_queue_message(client, msg);
+				/* sent from the ringbuffer, without copy */
+				if ((res = stream_send_record(stream, index, towrite)) < 0)
+					return res;
 
 				index += towrite;
 				avail -= towrite;
 				stream->read_index += towrite;
 			}
-			spa_ringbuffer_read_update(&stream->ring, index);
 		}
 	}
 	return 0;
@@ -1461,10 +1733,16 @@ static void stream_process(void *data)
 		} else if ((uint32_t)filled + size > stream->attr.maxlength) {
 			/* overrun, can happen when the other side is not
 			 * reading fast enough. We still write our data into the
-			 * ringbuffer and expect the other side to warn and catch up. */
+			 * ringbuffer and expect the other side to warn and catch up.
+			 * The data that was not read yet can be queued for the
+			 * client, we drop what does not fit instead of
+			 * overwriting it. */
 			pw_log_debug("%p: [%s] overrun write:%u filled:%d size:%u max:%u",
 					stream, client->name, index, filled,
 					size, stream->attr.maxlength);
+			if ((uint32_t)filled + size > MAXLENGTH)
+				size = SPA_ROUND_DOWN(MAXLENGTH - SPA_MIN((uint32_t)filled, MAXLENGTH),
+						stream->frame_size);
 		}
 
 		spa_ringbuffer_write_data(&stream->ring,
@@ -4942,7 +5220,7 @@ static void on_module_loaded(void *data, int result)
 	} else {
 		pw_log_debug("pending module %p: wait manager sync tag:%d", pm, pm->tag);
 		pm->wait_sync = true;
-		pw_manager_sync(pm->client->manager);
+		pw_manager_sync(pm->client->manager, &pm->manager_listener);
 	}
 }
 
@@ -5303,7 +5581,7 @@ const struct command commands[COMMAND_MAX] =
 
 	/* Supported since protocol v31 (9.0)
 	 * BOTH DIRECTIONS */
-	COMMAND(REGISTER_MEMFD_SHMID, do_error_access),
+	COMMAND(REGISTER_MEMFD_SHMID, do_register_memfd_shmid, COMMAND_ACCESS_WITHOUT_MANAGER),
 
 	/* Supported since protocol v35 (15.0) */
 	COMMAND(SEND_OBJECT_MESSAGE, do_send_object_message),
@@ -5342,6 +5620,11 @@ static void impl_clear(struct impl *impl)
 	spa_list_consume(c, &impl->cleanup_clients, link)
 		client_free(c);
 
+	if (impl->manager) {
+		shared_manager_unref(impl->manager);
+		impl->manager = NULL;
+	}
+
 	spa_list_consume(msg, &impl->free_messages, link)
 		message_free(msg, true, true);
 
@@ -5465,6 +5748,8 @@ static void load_defaults(struct defs *def, struct pw_properties *props)
 	parse_format(props, "pulse.default.format", DEFAULT_FORMAT, &def->sample_spec);
 	parse_position(props, "pulse.default.position", DEFAULT_POSITION, &def->channel_map);
 	parse_uint32(props, "pulse.idle.timeout", DEFAULT_IDLE_TIMEOUT, &def->idle_timeout);
+	parse_bool(props, "pulse.enable-shm", DEFAULT_ENABLE_SHM, &def->enable_shm);
+	parse_bool(props, "pulse.share-manager", DEFAULT_SHARE_MANAGER, &def->share_manager);
 	def->sample_spec.channels = def->channel_map.channels;
 	def->quantum_limit = 8192;
 }
@@ -115,9 +115,12 @@ static void stream_clear_data(struct stream *stream,
 static int handle_memblock(struct client *client, struct message *msg)
 {
 	struct stream *stream;
-	uint32_t channel, flags, index;
+	struct shm_info info;
+	uint32_t channel, flags, index, length;
 	int64_t offset, diff;
 	int32_t filled;
+	const void *data;
+	bool shm;
 	int res = 0;
 
 	channel = ntohl(client->desc.channel);
@@ -125,9 +128,40 @@ static int handle_memblock(struct client *client, struct message *msg)
 		(((uint64_t) ntohl(client->desc.offset_hi)) << 32) |
 		(((uint64_t) ntohl(client->desc.offset_lo))));
 	flags = ntohl(client->desc.flags);
+	shm = SPA_FLAG_IS_SET(flags, FLAG_SHMDATA);
+
+	if (shm) {
+		/* the data is in a shared memory block of the client, it is
+		 * copied into the stream and released right away */
+		memcpy(&info, msg->data, sizeof(info));
+		info.block_id = ntohl(info.block_id);
+		info.shm_id = ntohl(info.shm_id);
+		info.offset = ntohl(info.offset);
+		info.length = ntohl(info.length);
+
+		/* only registered memfd pools are supported, posix shm
+		 * pools can be opened by anyone who guesses the id */
+		if (!SPA_FLAG_IS_SET(flags, FLAG_SHMDATA_MEMFD_BLOCK)) {
+			pw_log_warn("client %p [%s]: posix shm memblock shm_id:%u not supported",
+				    client, client->name, info.shm_id);
+			res = -EPROTO;
+			goto finish;
+		}
+		data = client_get_shm(client, &info);
+		if (data == NULL) {
+			pw_log_warn("client %p [%s]: can't import memblock shm_id:%u offset:%u length:%u: %m",
+				    client, client->name, info.shm_id, info.offset, info.length);
+			res = -EPROTO;
+			goto finish;
+		}
+		length = info.length;
+	} else {
+		data = msg->data;
+		length = msg->length;
+	}
 
 	pw_log_debug("client %p: received memblock channel:%d offset:%" PRIi64 " flags:%08x size:%u",
-		     client, channel, offset, flags, msg->length);
+		     client, channel, offset, flags, length);
 
 	stream = pw_map_lookup(&client->streams, channel);
 	if (stream == NULL || stream->type == STREAM_TYPE_RECORD) {
@@ -138,7 +172,7 @@ static int handle_memblock(struct client *client, struct message *msg)
 
 	filled = spa_ringbuffer_get_write_index(&stream->ring, &index);
 	pw_log_debug("new block %p %p/%u filled:%d index:%d flags:%02x offset:%" PRIu64,
-		     msg, msg->data, msg->length, filled, index, flags, offset);
+		     msg, data, length, filled, index, flags, offset);
 
 	switch (flags & FLAG_SEEKMASK) {
 	case SEEK_RELATIVE:
@@ -175,7 +209,7 @@ static int handle_memblock(struct client *client, struct message *msg)
 
 	if (filled < 0) {
 		/* underrun, reported on reader side */
-	} else if (filled + msg->length > stream->attr.maxlength) {
+	} else if (filled + length > stream->attr.maxlength) {
 		/* overrun */
 		stream_send_overflow(stream);
 	}
@@ -185,13 +219,13 @@ static int handle_memblock(struct client *client, struct message *msg)
 	spa_ringbuffer_write_data(&stream->ring,
 			stream->buffer, MAXLENGTH,
 			index % MAXLENGTH,
-			msg->data,
-			SPA_MIN(msg->length, MAXLENGTH));
-	index += msg->length;
+			data,
+			SPA_MIN(length, MAXLENGTH));
+	index += length;
 	spa_ringbuffer_write_update(&stream->ring, index);
 
-	stream->write_index += msg->length;
-	stream->requested -= msg->length;
+	stream->write_index += length;
+	stream->requested -= length;
 
 	stream_send_request(stream);
 
@@ -199,10 +233,34 @@ static int handle_memblock(struct client *client, struct message *msg)
 		stream_set_paused(stream, false, "new data");
 
 finish:
+	if (shm && res >= 0)
+		client_queue_shm_release(client, info.block_id);
 	message_free(msg, false, false);
 	return res;
 }
 
+static void receive_fds(struct client *client, struct msghdr *msg)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		uint32_t i, n_fds;
+		int fd;
+
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+
+		n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (i = 0; i < n_fds; i++) {
+			memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+			if (client->n_fds < CLIENT_MAX_FDS)
+				client->fds[client->n_fds++] = fd;
+			else
+				close(fd);
+		}
+	}
+}
+
 static int do_read(struct client *client)
 {
 	struct impl * const impl = client->impl;
@@ -226,7 +284,18 @@ static int do_read(struct client *client)
 	}
 
 	while (true) {
-		ssize_t r = recv(client->source->fd, data, size, MSG_DONTWAIT);
+		char control[CMSG_SPACE(CLIENT_MAX_FDS * sizeof(int))];
+		struct iovec iov = {
+			.iov_base = data,
+			.iov_len = size,
+		};
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = control,
+			.msg_controllen = sizeof(control),
+		};
+		ssize_t r = recvmsg(client->source->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
 
 		if (r == 0 && size != 0) {
 			res = -EPIPE;
@@ -241,6 +310,9 @@ static int do_read(struct client *client)
 			goto exit;
 		}
 
+		if (msg.msg_controllen > 0)
+			receive_fds(client, &msg);
+
 		client->in_index += r;
 		break;
 	}
@@ -249,10 +321,17 @@ static int do_read(struct client *client)
 		uint32_t flags, length, channel;
 
 		flags = ntohl(client->desc.flags);
-		if ((flags & FLAG_SHMMASK) != 0) {
+		if ((flags & FLAG_SHMMASK) != 0 && !client->use_shm) {
 			res = -EPROTO;
 			goto exit;
 		}
+		if (flags == FLAG_SHMRELEASE || flags == FLAG_SHMREVOKE) {
+			/* we don't export memory and imported blocks are released
+			 * right after they are copied, there is nothing to do */
+			client->in_index = 0;
+			client_close_fds(client);
+			goto exit;
+		}
 
 		length = ntohl(client->desc.length);
 		if (length > FRAME_SIZE_MAX_ALLOW || length <= 0) {
@@ -270,6 +349,18 @@ static int do_read(struct client *client)
 				res = -EPROTO;
 				goto exit;
 			}
+		} else if (SPA_FLAG_IS_SET(flags, FLAG_SHMDATA)) {
+			if (length != sizeof(struct shm_info)) {
+				pw_log_warn("client %p: received invalid shm frame size: %u",
+					    client, length);
+				res = -EPROTO;
+				goto exit;
+			}
+		} else if ((flags & FLAG_SHMMASK) != 0) {
+			pw_log_warn("client %p: received memblock frame with invalid flags: %08x",
+				    client, flags);
+			res = -EPROTO;
+			goto exit;
 		}
 
 		if (client->message)
@@ -287,6 +378,8 @@ static int do_read(struct client *client)
 			res = handle_packet(client, msg);
 		else
 			res = handle_memblock(client, msg);
+
+		client_close_fds(client);
 	}
 
 exit:
@@ -431,6 +524,8 @@ on_connect(void *data, int fd, uint32_t mask)
 
 	if (server->addr.ss_family == AF_UNIX) {
 		spa_autofree char *app_id = NULL, *snap_app_id = NULL, *devices = NULL;
+		bool sandboxed = false;
+		uid_t uid;
 #ifdef HAVE_SNAP
 		pw_sandbox_access_t snap_access;
 #endif
@@ -441,6 +536,7 @@ on_connect(void *data, int fd, uint32_t mask)
 			pw_log_warn("setsockopt(SO_PRIORITY) failed: %m");
 #endif
 		pid = get_client_pid(client, client_fd);
+		uid = get_client_uid(client, client_fd);
 		if (pid != 0 && pw_check_flatpak(pid, &app_id, &devices) == 1) {
 			/*
 			 * XXX: we should really use Portal client access here
@@ -462,6 +558,7 @@ on_connect(void *data, int fd, uint32_t mask)
 			 * for it.
 			 */
 			client_access = "flatpak";
+			sandboxed = true;
 			pw_properties_set(client->props, "pipewire.access.portal.app_id",
 					app_id);
 
@@ -476,6 +573,7 @@ on_connect(void *data, int fd, uint32_t mask)
 #ifdef HAVE_SNAP
 		snap_access = pw_snap_get_audio_permissions(client, client_fd, &snap_app_id);
 		if ((snap_access & PW_SANDBOX_ACCESS_NOT_A_SANDBOX) == 0) {
+			sandboxed = true;
 			pw_properties_set(client->props, PW_KEY_SNAP_ID, snap_app_id);
 
 			pw_properties_set(client->props,
@@ -487,6 +585,11 @@ on_connect(void *data, int fd, uint32_t mask)
 					  (snap_access & PW_SANDBOX_ACCESS_RECORD) ? "true" : "false");
 		}
 #endif
+		/* only share memory with unsandboxed clients of the same user
+		 * that have full access */
+		client->shm_allowed = impl->defs.enable_shm && !sandboxed &&
+			uid == getuid() &&
+			(client_access == NULL || spa_streq(client_access, "unrestricted"));
 	}
 	else if (server->addr.ss_family == AF_INET || server->addr.ss_family == AF_INET6) {
 
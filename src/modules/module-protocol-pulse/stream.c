@@ -99,6 +99,33 @@ error_errno:
 	return NULL;
 }
 
+static void stream_drop_record(struct stream *stream)
+{
+	struct client *client = stream->client;
+	struct message *m, *t, *copy;
+
+	spa_list_for_each_safe(m, t, &client->out_messages, link) {
+		if (m->type != MESSAGE_TYPE_RECORD || m->u.record.stream != stream)
+			continue;
+
+		if (&m->link == client->out_messages.next && client->out_index > 0) {
+			/* partially sent, the client still needs the complete frame */
+			copy = message_alloc(stream->impl, m->channel, m->length);
+			if (copy != NULL) {
+				spa_ringbuffer_read_data(&stream->ring,
+						stream->buffer, MAXLENGTH,
+						m->u.record.index % MAXLENGTH,
+						copy->data, m->length);
+				spa_list_insert(&m->link, &copy->link);
+			} else {
+				pw_log_warn("client %p: can't copy record data: %m", client);
+			}
+		}
+		message_free(m, true, false);
+	}
+	stream->record_pending = 0;
+}
+
 void stream_free(struct stream *stream)
 {
 	struct client *client = stream->client;
@@ -127,6 +154,9 @@ void stream_free(struct stream *stream)
 
 	pw_work_queue_cancel(impl->work_queue, stream, SPA_ID_INVALID);
 
+	if (stream->record_pending > 0)
+		stream_drop_record(stream);
+
 	if (stream->buffer)
 		free(stream->buffer);
 
@@ -378,6 +408,41 @@ int stream_update_minreq(struct stream *stream, uint32_t minreq)
 	return 0;
 }
 
+/* queue size bytes of record data at index in the ringbuffer, the data is sent
+ * from the ringbuffer and the read pointer is updated when it was sent */
+int stream_send_record(struct stream *stream, uint32_t index, uint32_t size)
+{
+	struct message *msg;
+	int res;
+
+	msg = message_alloc(stream->impl, stream->channel, 0);
+	if (msg == NULL)
+		return -errno;
+
+	msg->type = MESSAGE_TYPE_RECORD;
+	msg->length = size;
+	msg->u.record.stream = stream;
+	msg->u.record.index = index;
+
+	if ((res = client_queue_message(stream->client, msg)) < 0)
+		return res;
+
+	stream->record_pending += size;
+	return 0;
+}
+
+void stream_record_sent(struct stream *stream, uint32_t index, uint32_t size)
+{
+	uint32_t read;
+
+	stream->record_pending -= size;
+
+	/* don't go back when the stream was flushed meanwhile */
+	spa_ringbuffer_get_read_index(&stream->ring, &read);
+	if ((int32_t)(index + size - read) > 0)
+		spa_ringbuffer_read_update(&stream->ring, index + size);
+}
+
 int stream_send_moved(struct stream *stream, uint32_t peer_index, const char *peer_name)
 {
 	struct client *client = stream->client;
@@ -57,6 +57,7 @@ struct stream {
 
 	int64_t read_index;
 	int64_t write_index;
+	uint32_t record_pending;	/* queued record data not yet sent */
 	uint64_t underrun_for;
 	uint64_t playing_for;
 	uint64_t ticks_base;
@@ -117,6 +118,8 @@ int stream_send_started(struct stream *stream);
 int stream_send_request(struct stream *stream);
 int stream_update_minreq(struct stream *stream, uint32_t minreq);
 int stream_send_moved(struct stream *stream, uint32_t peer_index, const char *peer_name);
+int stream_send_record(struct stream *stream, uint32_t index, uint32_t size);
+void stream_record_sent(struct stream *stream, uint32_t index, uint32_t size);
 int stream_update_tag_param(struct stream *stream);
 
 #endif /* PULSER_SERVER_STREAM_H */
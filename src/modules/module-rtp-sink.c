@@ -297,6 +297,16 @@ static void stream_send_packet(void *data, struct iovec *iov, size_t iovlen)
 		pw_log_warn("sendmsg() failed: %m");
 }
 
+static void stream_send_packets(void *data, struct iovec *iov, size_t iovlen, uint32_t n_packets)
+{
+	struct impl *impl = data;
+	int res;
+
+	res = pw_net_send_packets(impl->rtp_fd, iov, iovlen, n_packets, MSG_NOSIGNAL);
+	if (res < 0)
+		pw_log_warn("sending %u packets failed: %s", n_packets, spa_strerror(res));
+}
+
 static void stream_state_changed(void *data, bool started, const char *error)
 {
 	struct impl *impl = data;
@@ -407,6 +417,7 @@ static const struct rtp_stream_events stream_events = {
 	.state_changed = stream_state_changed,
 	.param_changed = stream_param_changed,
 	.send_packet = stream_send_packet,
+	.send_packets = stream_send_packets,
 };
 
 static void core_destroy(void *d)
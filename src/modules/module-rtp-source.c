@@ -116,6 +116,13 @@ PW_LOG_TOPIC(mod_topic, "mod." NAME);
 
 #define DEFAULT_TS_OFFSET		-1
 
+/* max packets read from the socket per wakeup */
+#ifdef HAVE_RECVMMSG
+#define RECV_BATCH			16
+#else
+#define RECV_BATCH			1
+#endif
+
 #define USAGE   "( local.ifname=<local interface name to use> ) "						\
 		"( source.ip=<source IP address, default:"DEFAULT_SOURCE_IP"> ) "				\
  		"source.port=<int, source port> "								\
@@ -163,7 +170,7 @@ struct impl {
 	socklen_t src_len;
 	struct spa_source *source;
 
-	uint8_t *buffer;
+	uint8_t *buffer;		/* RECV_BATCH packets of buffer_size */
 	size_t buffer_size;
 
 	bool receiving;
@@ -193,37 +200,62 @@ static int do_start(struct spa_loop *loop, bool async, uint32_t seq, const void
 	return 0;
 }
 
+static void receive_packet(struct impl *impl, uint8_t *buffer, ssize_t len)
+{
+	if (len < 12) {
+		pw_log_warn("short packet of len %zd received", len);
+		return;
+	}
+	if (SPA_LIKELY(impl->stream)) {
+		if (rtp_stream_receive_packet(impl->stream, buffer, len) < 0) {
+			pw_log_warn("recv error: %m");
+			return;
+		}
+	}
+	if (!impl->receiving) {
+		impl->receiving = true;
+		pw_loop_invoke(impl->loop, do_start, 1, NULL, 0, false, impl);
+	}
+}
+
 static void
 on_rtp_io(void *data, int fd, uint32_t mask)
 {
 	struct impl *impl = data;
-	ssize_t len;
 
 	if (mask & SPA_IO_IN) {
-		if ((len = recv(fd, impl->buffer, impl->buffer_size, 0)) < 0)
+#ifdef HAVE_RECVMMSG
+		struct mmsghdr msg[RECV_BATCH];
+		struct iovec iov[RECV_BATCH];
+		int i, n;
+
+		/* get all the packets that arrived since the last wakeup */
+		spa_zero(msg);
+		for (i = 0; i < RECV_BATCH; i++) {
+			iov[i].iov_base = impl->buffer + i * impl->buffer_size;
+			iov[i].iov_len = impl->buffer_size;
+			msg[i].msg_hdr.msg_iov = &iov[i];
+			msg[i].msg_hdr.msg_iovlen = 1;
+		}
+		if ((n = recvmmsg(fd, msg, RECV_BATCH, 0, NULL)) < 0)
 			goto receive_error;
 
-		if (len < 12)
-			goto short_packet;
+		for (i = 0; i < n; i++)
+			receive_packet(impl, iov[i].iov_base, msg[i].msg_len);
+#else
+		ssize_t len;
 
-		if (SPA_LIKELY(impl->stream)) {
-			if (rtp_stream_receive_packet(impl->stream, impl->buffer, len) < 0)
-				goto receive_error;
-		}
+		if ((len = recv(fd, impl->buffer, impl->buffer_size, 0)) < 0)
+			goto receive_error;
 
-		if (!impl->receiving) {
-			impl->receiving = true;
-			pw_loop_invoke(impl->loop, do_start, 1, NULL, 0, false, impl);
-		}
+		receive_packet(impl, impl->buffer, len);
+#endif
 	}
 	return;
 
 receive_error:
 	pw_log_warn("recv error: %m");
 	return;
-short_packet:
-	pw_log_warn("short packet of len %zd received", len);
-	return;
 }
 
 static int make_socket(const struct sockaddr* sa, socklen_t salen, char *ifname)
@@ -713,7 +745,7 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 	}
 
 	impl->buffer_size = rtp_stream_get_mtu(impl->stream);
-	impl->buffer = calloc(1, impl->buffer_size);
+	impl->buffer = calloc(RECV_BATCH, impl->buffer_size);
 	if (impl->buffer == NULL) {
 		res = -errno;
 		pw_log_error("can't create packet buffer of size %zd: %m", impl->buffer_size);
@@ -208,13 +208,12 @@ unexpected_ssrc:
 
 static void set_timer(struct impl *impl, uint64_t time, uint64_t itime)
 {
-	struct itimerspec ts;
-	ts.it_value.tv_sec = time / SPA_NSEC_PER_SEC;
-	ts.it_value.tv_nsec = time % SPA_NSEC_PER_SEC;
-	ts.it_interval.tv_sec = itime / SPA_NSEC_PER_SEC;
-	ts.it_interval.tv_nsec = itime % SPA_NSEC_PER_SEC;
-	spa_system_timerfd_settime(impl->data_loop->system,
-			impl->timer->fd, SPA_FD_TIMER_ABSTIME, &ts, NULL);
+	struct timespec value, interval;
+	value.tv_sec = time / SPA_NSEC_PER_SEC;
+	value.tv_nsec = time % SPA_NSEC_PER_SEC;
+	interval.tv_sec = itime / SPA_NSEC_PER_SEC;
+	interval.tv_nsec = itime % SPA_NSEC_PER_SEC;
+	pw_loop_update_timer(impl->data_loop, impl->timer, &value, &interval, true);
 	impl->timer_running = time != 0 && itime != 0;
 }
 
@@ -228,12 +227,15 @@ set_iovec(struct spa_ringbuffer *rbuf, void *buffer, uint32_t size,
 	iov[1].iov_base = buffer;
 }
 
+/* max number of packets handed to the sender at once */
+#define RTP_SEND_BATCH	32
+
 static void rtp_audio_flush_packets(struct impl *impl, uint32_t num_packets, uint64_t set_timestamp)
 {
 	int32_t avail, tosend;
-	uint32_t stride, timestamp;
-	struct iovec iov[3];
-	struct rtp_header header;
+	uint32_t stride, timestamp, n_batch = 0;
+	struct iovec iov[RTP_SEND_BATCH][3];
+	struct rtp_header header[RTP_SEND_BATCH];
 
 	avail = spa_ringbuffer_get_read_index(&impl->ring, &timestamp);
 	tosend = impl->psamples;
@@ -250,37 +252,38 @@ static void rtp_audio_flush_packets(struct impl *impl, uint32_t num_packets, uin
 
 	stride = impl->stride;
 
-	spa_zero(header);
-	header.v = 2;
-	header.pt = impl->payload;
-	header.ssrc = htonl(impl->ssrc);
-
-	iov[0].iov_base = &header;
-	iov[0].iov_len = sizeof(header);
-
 	while (num_packets > 0) {
+		struct rtp_header *h = &header[n_batch];
+
+		spa_zero(*h);
+		h->v = 2;
+		h->pt = impl->payload;
+		h->ssrc = htonl(impl->ssrc);
 		if (impl->marker_on_first && impl->first)
-			header.m = 1;
-		else
-			header.m = 0;
-		header.sequence_number = htons(impl->seq);
-		header.timestamp = htonl(impl->ts_offset + (set_timestamp ? set_timestamp : timestamp));
+			h->m = 1;
+		h->sequence_number = htons(impl->seq);
+		h->timestamp = htonl(impl->ts_offset + (set_timestamp ? set_timestamp : timestamp));
 
+		iov[n_batch][0].iov_base = h;
+		iov[n_batch][0].iov_len = sizeof(*h);
 		set_iovec(&impl->ring,
 			impl->buffer, BUFFER_SIZE,
 			(timestamp * stride) & BUFFER_MASK,
-			&iov[1], tosend * stride);
+			&iov[n_batch][1], tosend * stride);
 
 		pw_log_trace("sending %d packet:%d ts_offset:%d timestamp:%d",
 				tosend, num_packets, impl->ts_offset, timestamp);
 
-		rtp_stream_emit_send_packet(impl, iov, 3);
-
 		impl->seq++;
 		impl->first = false;
 		timestamp += tosend;
 		avail -= tosend;
 		num_packets--;
+
+		if (++n_batch == RTP_SEND_BATCH || num_packets == 0) {
+			rtp_stream_send_packets(impl, &iov[0][0], 3, n_batch);
+			n_batch = 0;
+		}
 	}
 	spa_ringbuffer_read_update(&impl->ring, timestamp);
 done:
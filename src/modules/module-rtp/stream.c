@@ -41,6 +41,7 @@ PW_LOG_TOPIC_EXTERN(mod_topic);
 #define rtp_stream_emit_param_changed(s,i,p)	rtp_stream_emit(s, param_changed,0,i,p)
 #define rtp_stream_emit_send_packet(s,i,l)	rtp_stream_emit(s, send_packet,0,i,l)
 #define rtp_stream_emit_send_feedback(s,seq)	rtp_stream_emit(s, send_feedback,0,seq)
+#define rtp_stream_emit_send_packets(s,i,l,n)	rtp_stream_emit(s, send_packets,1,i,l,n)
 
 struct impl {
 	struct spa_audio_info info;
@@ -135,6 +136,19 @@ static int do_emit_state_changed(struct spa_loop *loop, bool async, uint32_t seq
 	return 0;
 }
 
+static void rtp_stream_send_packets(struct impl *impl, struct iovec *iov, size_t iovlen,
+		uint32_t n_packets)
+{
+	uint32_t i;
+
+	if (n_packets == 0 ||
+	    rtp_stream_emit_send_packets(impl, iov, iovlen, n_packets) > 0)
+		return;
+
+	for (i = 0; i < n_packets; i++)
+		rtp_stream_emit_send_packet(impl, &iov[i * iovlen], iovlen);
+}
+
 #include "module-rtp/audio.c"
 #include "module-rtp/midi.c"
 #include "module-rtp/opus.c"
@@ -30,7 +30,7 @@ struct rtp_stream;
 #define DEFAULT_MAX_PTIME	20.0f
 
 struct rtp_stream_events {
-#define RTP_VERSION_STREAM_EVENTS        0
+#define RTP_VERSION_STREAM_EVENTS        1
 	uint32_t version;
 
 	void (*destroy) (void *data);
@@ -42,6 +42,10 @@ struct rtp_stream_events {
 	void (*send_packet) (void *data, struct iovec *iov, size_t iovlen);
 
 	void (*send_feedback) (void *data, uint32_t seqnum);
+
+	/* since 1, send n_packets packets of iovlen iovecs each. When not
+	 * implemented, send_packet is called for each packet. */
+	void (*send_packets) (void *data, struct iovec *iov, size_t iovlen, uint32_t n_packets);
 };
 
 struct rtp_stream *rtp_stream_new(struct pw_core *core,
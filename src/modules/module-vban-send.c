@@ -205,6 +205,16 @@ static void stream_send_packet(void *data, struct iovec *iov, size_t iovlen)
 		pw_log_debug("sendmsg() failed: %m");
 }
 
+static void stream_send_packets(void *data, struct iovec *iov, size_t iovlen, uint32_t n_packets)
+{
+	struct impl *impl = data;
+	int res;
+
+	res = pw_net_send_packets(impl->vban_fd, iov, iovlen, n_packets, MSG_NOSIGNAL);
+	if (res < 0)
+		pw_log_debug("sending %u packets failed: %s", n_packets, spa_strerror(res));
+}
+
 static void stream_state_changed(void *data, bool started, const char *error)
 {
 	struct impl *impl = data;
@@ -220,6 +230,7 @@ static const struct vban_stream_events stream_events = {
 	.destroy = stream_destroy,
 	.state_changed = stream_state_changed,
 	.send_packet = stream_send_packet,
+	.send_packets = stream_send_packets,
 };
 
 static bool is_multicast(struct sockaddr *sa, socklen_t salen)
@@ -159,12 +159,15 @@ set_iovec(struct spa_ringbuffer *rbuf, void *buffer, uint32_t size,
 	iov[1].iov_base = buffer;
 }
 
+/* max number of packets handed to the sender at once */
+#define VBAN_SEND_BATCH	32
+
 static void vban_audio_flush_packets(struct impl *impl)
 {
 	int32_t avail, tosend;
-	uint32_t stride, timestamp;
-	struct iovec iov[3];
-	struct vban_header header;
+	uint32_t stride, timestamp, n_batch = 0;
+	struct iovec iov[VBAN_SEND_BATCH][3];
+	struct vban_header header, headers[VBAN_SEND_BATCH];
 
 	avail = spa_ringbuffer_get_read_index(&impl->ring, &timestamp);
 	tosend = impl->psamples;
@@ -178,22 +181,25 @@ static void vban_audio_flush_packets(struct impl *impl)
 	header.format_nbs = tosend - 1;
 	header.format_nbc = impl->stream_info.info.raw.channels - 1;
 
-	iov[0].iov_base = &header;
-	iov[0].iov_len = sizeof(header);
-
 	while (avail >= tosend) {
+		headers[n_batch] = header;
+		iov[n_batch][0].iov_base = &headers[n_batch];
+		iov[n_batch][0].iov_len = sizeof(header);
 		set_iovec(&impl->ring,
 			impl->buffer, BUFFER_SIZE,
 			(timestamp * stride) & BUFFER_MASK,
-			&iov[1], tosend * stride);
+			&iov[n_batch][1], tosend * stride);
 
 		pw_log_trace("sending %d timestamp:%08x", tosend, timestamp);
 
-		vban_stream_emit_send_packet(impl, iov, 3);
-
 		timestamp += tosend;
 		avail -= tosend;
 		header.n_frames++;
+
+		if (++n_batch == VBAN_SEND_BATCH || avail < tosend) {
+			vban_stream_send_packets(impl, &iov[0][0], 3, n_batch);
+			n_batch = 0;
+		}
 	}
 	impl->header.n_frames = header.n_frames;
 	spa_ringbuffer_read_update(&impl->ring, timestamp);
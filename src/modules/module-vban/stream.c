@@ -37,6 +37,7 @@
 #define vban_stream_emit_state_changed(s,n,e)	vban_stream_emit(s, state_changed,0,n,e)
 #define vban_stream_emit_send_packet(s,i,l)	vban_stream_emit(s, send_packet,0,i,l)
 #define vban_stream_emit_send_feedback(s,seq)	vban_stream_emit(s, send_feedback,0,seq)
+#define vban_stream_emit_send_packets(s,i,l,n)	vban_stream_emit(s, send_packets,1,i,l,n)
 
 struct impl {
 	struct spa_audio_info info;
@@ -83,6 +84,19 @@ struct impl {
 	int (*receive_vban)(struct impl *impl, uint8_t *buffer, ssize_t len);
 };
 
+static void vban_stream_send_packets(struct impl *impl, struct iovec *iov, size_t iovlen,
+		uint32_t n_packets)
+{
+	uint32_t i;
+
+	if (n_packets == 0 ||
+	    vban_stream_emit_send_packets(impl, iov, iovlen, n_packets) > 0)
+		return;
+
+	for (i = 0; i < n_packets; i++)
+		vban_stream_emit_send_packet(impl, &iov[i * iovlen], iovlen);
+}
+
 #include "module-vban/audio.c"
 #include "module-vban/midi.c"
 
@@ -24,7 +24,7 @@ struct vban_stream;
 #define DEFAULT_MAX_PTIME	20
 
 struct vban_stream_events {
-#define VBAN_VERSION_STREAM_EVENTS        0
+#define VBAN_VERSION_STREAM_EVENTS        1
 	uint32_t version;
 
 	void (*destroy) (void *data);
@@ -34,6 +34,10 @@ struct vban_stream_events {
 	void (*send_packet) (void *data, struct iovec *iov, size_t iovlen);
 
 	void (*send_feedback) (void *data, uint32_t senum);
+
+	/* since 1, send n_packets packets of iovlen iovecs each. When not
+	 * implemented, send_packet is called for each packet. */
+	void (*send_packets) (void *data, struct iovec *iov, size_t iovlen, uint32_t n_packets);
 };
 
 struct vban_stream *vban_stream_new(struct pw_core *core,
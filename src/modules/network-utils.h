@@ -6,6 +6,7 @@
 #include <string.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <sys/socket.h>
 #include <errno.h>
 
 #ifdef __FreeBSD__
@@ -131,5 +132,43 @@ static inline bool pw_net_addr_is_any(struct sockaddr_storage *addr)
 	return false;
 }
 
+/* send n_packets datagrams of iovlen iovecs each, with one syscall when
+ * sendmmsg() is available. A packet that fails is skipped, the error of
+ * the last failed packet is returned. */
+static inline int pw_net_send_packets(int fd, struct iovec *iov, size_t iovlen,
+		uint32_t n_packets, int flags)
+{
+	uint32_t i;
+	int res = 0;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr msg[n_packets];
+
+	memset(msg, 0, sizeof(msg));
+	for (i = 0; i < n_packets; i++) {
+		msg[i].msg_hdr.msg_iov = &iov[i * iovlen];
+		msg[i].msg_hdr.msg_iovlen = iovlen;
+	}
+	for (i = 0; i < n_packets;) {
+		int n = sendmmsg(fd, &msg[i], n_packets - i, flags);
+		if (n < 0) {
+			res = -errno;
+			i++;
+		} else {
+			i += n;
+		}
+	}
+#else
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	for (i = 0; i < n_packets; i++) {
+		msg.msg_iov = &iov[i * iovlen];
+		msg.msg_iovlen = iovlen;
+		if (sendmsg(fd, &msg, flags) < 0)
+			res = -errno;
+	}
+#endif
+	return res;
+}
 
 #endif /* NETWORK_UTILS_H */
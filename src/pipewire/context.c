@@ -41,6 +41,10 @@ PW_LOG_TOPIC_EXTERN(log_context);
 
 #define DEFAULT_DATA_LOOPS	1
 
+#define ADAPTIVE_INTERVAL	(1 * SPA_NSEC_PER_SEC)	/* check graph load every second */
+#define ADAPTIVE_LOWER_COUNT	5u			/* low load checks before lowering */
+#define CRITICAL_INTERVAL	(1 * SPA_NSEC_PER_SEC)	/* update the critical paths every second */
+
 #if !defined(FNM_EXTMATCH)
 #define FNM_EXTMATCH 0
 #endif
@@ -64,6 +68,10 @@ struct impl {
 
 	uint32_t n_data_loops;
 	struct data_loop data_loops[MAX_LOOPS];
+
+	struct spa_source *adaptive_timer;
+	struct spa_source *critical_timer;
+	unsigned int critical_armed:1;
 };
 
 
@@ -174,6 +182,100 @@ static void init_plugin_loader(struct impl *impl)
 		impl);
 }
 
+static uint32_t flp2(uint32_t x);
+
+/* Check the load of the running drivers. When the medium cpu load is above
+ * max-load or there were xruns, we double the quantum of the driver. When the
+ * load stays below min-load for a while, the quantum is halved again until it
+ * reaches the quantum that the followers want. */
+static void adaptive_quantum_timeout(void *data, uint64_t expirations)
+{
+	struct impl *impl = data;
+	struct pw_context *this = &impl->this;
+	struct settings *s = &this->settings;
+	struct pw_impl_node *n;
+	bool changed = false;
+
+	spa_list_for_each(n, &this->driver_list, driver_link) {
+		struct pw_node_activation *a = n->rt.target.activation;
+		uint32_t quantum, target, xruns, load;
+
+		if (!n->driving || n->exported || n->info.state != PW_NODE_STATE_RUNNING) {
+			n->adaptive_quantum = 0;
+			n->adaptive_low = 0;
+			n->adaptive_xruns = a->xrun_count;
+			n->adaptive_checked = false;
+			continue;
+		}
+
+		xruns = a->xrun_count - n->adaptive_xruns;
+		n->adaptive_xruns = a->xrun_count;
+		/* xruns from before the driver was running don't count */
+		if (!n->adaptive_checked) {
+			n->adaptive_checked = true;
+			continue;
+		}
+
+		quantum = n->rt.position->clock.duration;
+		load = (uint32_t)(a->cpu_load[1] * 100.0f);
+
+		if (xruns > 0 || load > s->clock_adaptive_max_load) {
+			n->adaptive_low = 0;
+			/* stay within the limits that the graph recalc uses */
+			target = SPA_MIN(quantum * 2, n->adaptive_max_quantum);
+			if (s->clock_power_of_two_quantum)
+				target = flp2(target);
+			if (target <= quantum || target == n->adaptive_quantum)
+				continue;
+			n->adaptive_quantum = target;
+			pw_log_info("(%s-%u) load:%u%% xruns:%u raise quantum %u->%u",
+					n->name, n->info.id, load, xruns,
+					quantum, n->adaptive_quantum);
+			changed = true;
+		} else if (n->adaptive_quantum > 0 && load < s->clock_adaptive_min_load) {
+			if (++n->adaptive_low < ADAPTIVE_LOWER_COUNT)
+				continue;
+			n->adaptive_low = 0;
+			n->adaptive_quantum /= 2;
+			/* the quantum was limited below the new value */
+			if (SPA_MIN(n->adaptive_quantum, n->adaptive_max_quantum) >= quantum)
+				continue;
+			pw_log_info("(%s-%u) load:%u%% lower quantum %u->%u",
+					n->name, n->info.id, load,
+					quantum, n->adaptive_quantum);
+			changed = true;
+		} else {
+			n->adaptive_low = 0;
+		}
+	}
+	if (changed)
+		pw_context_recalc_graph(this, "adaptive quantum");
+}
+
+static int setup_adaptive_quantum(struct impl *impl)
+{
+	struct pw_context *this = &impl->this;
+	struct timespec value, interval;
+
+	if (!this->settings.clock_adaptive_quantum)
+		return 0;
+
+	impl->adaptive_timer = pw_loop_add_timer(this->main_loop,
+			adaptive_quantum_timeout, impl);
+	if (impl->adaptive_timer == NULL)
+		return -errno;
+
+	value.tv_sec = interval.tv_sec = ADAPTIVE_INTERVAL / SPA_NSEC_PER_SEC;
+	value.tv_nsec = interval.tv_nsec = ADAPTIVE_INTERVAL % SPA_NSEC_PER_SEC;
+	pw_loop_update_timer(this->main_loop, impl->adaptive_timer,
+			&value, &interval, false);
+
+	pw_log_info("%p: adaptive quantum max-load:%u%% min-load:%u%%", impl,
+			this->settings.clock_adaptive_max_load,
+			this->settings.clock_adaptive_min_load);
+	return 0;
+}
+
 static int do_data_loop_setup(struct spa_loop *loop, bool async, uint32_t seq,
 		const void *data, size_t size, void *user_data)
 {
@@ -377,7 +479,7 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 	if ((res = pw_conf_load_conf_for_context (properties, conf)) < 0)
 		goto error_free;
 
-	n_support = pw_get_support(this->support, SPA_N_ELEMENTS(this->support) - 6);
+	n_support = pw_get_support(this->support, SPA_N_ELEMENTS(this->support) - 8);
 	cpu = spa_support_find(this->support, n_support, SPA_TYPE_INTERFACE_CPU);
 
 	vm_type = SPA_CPU_VM_NONE;
@@ -438,6 +540,9 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 		goto error_free;
 	}
 
+	if ((res = setup_adaptive_quantum(impl)) < 0)
+		goto error_free;
+
 	init_plugin_loader(impl);
 
 	this->support[n_support++] = SPA_SUPPORT_INIT(SPA_TYPE_INTERFACE_System, this->main_loop->system);
@@ -578,6 +683,11 @@ void pw_context_destroy(struct pw_context *context)
 	if (context->pool)
 		pw_mempool_destroy(context->pool);
 
+	if (impl->adaptive_timer)
+		pw_loop_destroy_source(context->main_loop, impl->adaptive_timer);
+	if (impl->critical_timer)
+		pw_loop_destroy_source(context->main_loop, impl->critical_timer);
+
 	if (context->work_queue)
 		pw_work_queue_destroy(context->work_queue);
 
@@ -631,6 +741,9 @@ const struct spa_support *context_get_support(struct pw_context *context, uint32
 		context->support[n++] = SPA_SUPPORT_INIT(SPA_TYPE_INTERFACE_DataSystem, loop->system);
 		context->support[n++] = SPA_SUPPORT_INIT(SPA_TYPE_INTERFACE_DataLoop, loop->loop);
 	}
+	if (context->thread_utils != NULL)
+		context->support[n++] = SPA_SUPPORT_INIT(SPA_TYPE_INTERFACE_ThreadUtils,
+				context->thread_utils);
 	*n_support = n;
 	return context->support;
 }
@@ -647,16 +760,38 @@ struct pw_loop *pw_context_get_main_loop(struct pw_context *context)
 	return context->main_loop;
 }
 
+/* count the nodes that are scheduled from the given data loop. Remote nodes
+ * are processed in the client and don't add any load to the loop. */
+static uint32_t data_loop_n_nodes(struct impl *impl, struct data_loop *l)
+{
+	struct pw_impl_node *n;
+	uint32_t count = 0;
+
+	spa_list_for_each(n, &impl->this.node_list, link) {
+		if (!n->remote && n->data_loop == l->impl->loop)
+			count++;
+	}
+	return count;
+}
+
 static struct pw_data_loop *acquire_data_loop(struct impl *impl, const char *name, const char *klass)
 {
 	uint32_t i, j;
 	struct data_loop *best_loop = NULL;
 	int best_score = 0, res;
-
+	uint32_t best_nodes = 0;
+
+	/* Nodes that match equally well are spread over the data loops, preferring
+	 * the loop with the least amount of nodes and then the least recently used
+	 * one. Nodes in different loops are woken up by their own eventfd so that
+	 * independent branches of a graph run concurrently. The pending/required
+	 * counters of the activation make sure a node only runs when all of its
+	 * dependencies, possibly processed in other loops, completed. */
 	for (i = 0; i < impl->n_data_loops; i++) {
 		struct data_loop *l = &impl->data_loops[i];
 		const char *ln = l->impl->loop->name;
 		int score = 0;
+		uint32_t n_nodes;
 
 		if (klass == NULL)
 			klass = l->impl->class;
@@ -672,14 +807,19 @@ static struct pw_data_loop *acquire_data_loop(struct impl *impl, const char *nam
 			}
 		}
 
-		pw_log_debug("%d: name:'%s' class:'%s' score:%d last_used:%"PRIu64, i,
-				ln, l->impl->class, score, l->last_used);
+		n_nodes = data_loop_n_nodes(impl, l);
+
+		pw_log_debug("%d: name:'%s' class:'%s' score:%d nodes:%u last_used:%"PRIu64, i,
+				ln, l->impl->class, score, n_nodes, l->last_used);
 
 		if ((best_loop == NULL) ||
 		    (score > best_score) ||
-		    (score == best_score && l->last_used < best_loop->last_used)) {
+		    (score == best_score && n_nodes < best_nodes) ||
+		    (score == best_score && n_nodes == best_nodes &&
+		     l->last_used < best_loop->last_used)) {
 			best_loop = l;
 			best_score = score;
+			best_nodes = n_nodes;
 		}
 	}
 	if (best_loop == NULL)
@@ -691,9 +831,9 @@ static struct pw_data_loop *acquire_data_loop(struct impl *impl, const char *nam
 		return NULL;
 	}
 
-	pw_log_info("%p: using name:'%s' class:'%s' last_used:%"PRIu64, impl,
+	pw_log_info("%p: using name:'%s' class:'%s' nodes:%u last_used:%"PRIu64, impl,
 			best_loop->impl->loop->name,
-			best_loop->impl->class, best_loop->last_used);
+			best_loop->impl->class, best_nodes, best_loop->last_used);
 
 	return best_loop->impl;
 }
@@ -1494,6 +1634,142 @@ static uint32_t find_best_rate(const uint32_t *rates, uint32_t n_rates, uint32_t
 	return def;
 }
 
+/* Calculate the critical time of a node, the average measured processing time
+ * of the node and the longest chain of peers that it triggers in the same
+ * driver. */
+static uint64_t calc_critical_time(struct pw_impl_node *n)
+{
+	struct pw_node_peer *p;
+	uint64_t max = 0;
+
+	if (n->critical_checked)
+		return n->critical_time;
+
+	/* mark as checked first so that feedback loops end here */
+	n->critical_checked = true;
+	n->critical_time = 0;
+
+	spa_list_for_each(p, &n->peer_list, link) {
+		struct pw_impl_node *t = p->target.node;
+		if (t == NULL || t->driver_node != n->driver_node || t == n->driver_node)
+			continue;
+		max = SPA_MAX(max, calc_critical_time(t));
+	}
+	n->critical_time = n->critical_busy + max;
+	return n->critical_time;
+}
+
+static inline uint64_t target_critical_time(struct pw_node_target *t)
+{
+	return t->node ? t->node->critical_time : 0;
+}
+
+/* Called from the driver data loop. Sort the targets of the driver so that
+ * the nodes on the critical path are triggered first. */
+static int do_sort_targets(struct spa_loop *loop,
+		bool async, uint32_t seq, const void *data, size_t size, void *user_data)
+{
+	struct pw_impl_node *driver = user_data;
+	struct pw_node_target *t, *s;
+	struct spa_list sorted;
+
+	spa_list_init(&sorted);
+	spa_list_consume(t, &driver->rt.target_list, link) {
+		spa_list_remove(&t->link);
+		spa_list_for_each(s, &sorted, link) {
+			if (target_critical_time(t) > target_critical_time(s))
+				break;
+		}
+		/* insert before s or at the end of the list */
+		spa_list_append(&s->link, &t->link);
+	}
+	spa_list_insert_list(&driver->rt.target_list, &sorted);
+	return 0;
+}
+
+static void update_critical_path(struct pw_context *context, struct pw_impl_node *driver)
+{
+	struct pw_impl_node *s, *crit = NULL;
+
+	spa_list_for_each(s, &driver->follower_list, follower_link)
+		s->critical_checked = false;
+
+	driver->critical_time = 0;
+	driver->critical_checked = true;
+
+	spa_list_for_each(s, &driver->follower_list, follower_link) {
+		if (s == driver)
+			continue;
+		calc_critical_time(s);
+		if (crit == NULL || s->critical_time > crit->critical_time)
+			crit = s;
+	}
+	if (crit != NULL)
+		pw_log_debug("%p: driver %p '%s' critical path %"PRIu64"ns starts at %p '%s'",
+				context, driver, driver->name, crit->critical_time,
+				crit, crit->name);
+
+	/* don't wait for the data loop, the driver is unprepared with a blocking
+	 * invoke before it is freed so the sort always runs first */
+	pw_loop_invoke(driver->data_loop, do_sort_targets, 0, NULL, 0, false, driver);
+}
+
+/* Called from the driver data loop. Take the average processing time of
+ * the followers in the cycles since the last update. */
+static int do_collect_busy(struct spa_loop *loop,
+		bool async, uint32_t seq, const void *data, size_t size, void *user_data)
+{
+	struct pw_impl_node *driver = user_data, *s;
+
+	spa_list_for_each(s, &driver->follower_list, follower_link) {
+		if (s->rt.busy_count > 0)
+			s->critical_busy = s->rt.busy_time / s->rt.busy_count;
+		s->rt.busy_time = 0;
+		s->rt.busy_count = 0;
+	}
+	return 0;
+}
+
+static void critical_path_timeout(void *data, uint64_t expirations);
+
+static void critical_timer_update(struct impl *impl, bool enable)
+{
+	struct timespec value, interval;
+
+	if (impl->critical_armed == enable)
+		return;
+	if (impl->critical_timer == NULL) {
+		impl->critical_timer = pw_loop_add_timer(impl->this.main_loop,
+				critical_path_timeout, impl);
+		if (impl->critical_timer == NULL)
+			return;
+	}
+
+	value.tv_sec = interval.tv_sec = enable ? CRITICAL_INTERVAL / SPA_NSEC_PER_SEC : 0;
+	value.tv_nsec = interval.tv_nsec = enable ? CRITICAL_INTERVAL % SPA_NSEC_PER_SEC : 0;
+	pw_loop_update_timer(impl->this.main_loop, impl->critical_timer,
+			&value, &interval, false);
+	impl->critical_armed = enable;
+}
+
+static void critical_path_timeout(void *data, uint64_t expirations)
+{
+	struct impl *impl = data;
+	struct pw_context *this = &impl->this;
+	struct pw_impl_node *n;
+	bool running = false;
+
+	spa_list_for_each(n, &this->driver_list, driver_link) {
+		if (!n->driving || n->exported || n->info.state != PW_NODE_STATE_RUNNING)
+			continue;
+		pw_loop_invoke(n->data_loop, do_collect_busy, 0, NULL, 0, true, n);
+		update_critical_path(this, n);
+		running = true;
+	}
+	if (!running)
+		critical_timer_update(impl, false);
+}
+
 /* here we evaluate the complete state of the graph.
  *
  * It roughly operates in 3 stages:
@@ -1816,6 +2092,10 @@ again:
 			if (tmp < node_max_quantum)
 				node_max_quantum = tmp;
 		}
+		/* the adaptive quantum controller raises the quantum up to
+		 * these limits */
+		n->adaptive_max_quantum = (force_quantum || lock_quantum) ? 0 :
+			SPA_MIN(node_max_quantum, ceil_quantum);
 
 		current_quantum = n->target_quantum;
 		if (!restore_quantum && (lock_quantum || need_resume || !running)) {
@@ -1833,6 +2113,13 @@ again:
 			target_quantum = SPA_CLAMP(target_quantum, node_min_quantum, node_max_quantum);
 			target_quantum = SPA_CLAMP(target_quantum, floor_quantum, ceil_quantum);
 
+			/* the adaptive quantum controller raised the quantum because
+			 * of the load, it is reset when no longer needed */
+			if (n->adaptive_quantum <= target_quantum || force_quantum)
+				n->adaptive_quantum = 0;
+			else
+				target_quantum = SPA_MIN(n->adaptive_quantum, n->adaptive_max_quantum);
+
 			if (settings->clock_power_of_two_quantum && !force_quantum)
 				target_quantum = flp2(target_quantum);
 		}
@@ -1906,6 +2193,13 @@ again:
 			SPA_ATOMIC_STORE(n->rt.target.activation->command, transport);
 		}
 
+		/* trigger the followers on the critical path first, the path
+		 * is updated with the measured times while running */
+		if (running) {
+			update_critical_path(context, n);
+			critical_timer_update(impl, true);
+		}
+
 		/* now that all the followers are ready, start the driver */
 		ensure_state(n, running);
 	}
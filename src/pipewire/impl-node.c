@@ -151,16 +151,66 @@ static inline void deactivate_target(struct pw_impl_node *node, struct pw_node_t
 	}
 }
 
+/* check if the target is a local node that is processed in the same data-loop
+ * as node. Such targets can be processed directly without waking up the loop
+ * again with the eventfd. The driver is never part of this, it starts the
+ * cycle from its own wakeup and is signaled with the eventfd when the cycle
+ * completes, only the followers wake each other up directly. */
+static inline bool target_is_direct(struct pw_impl_node *node, struct pw_node_target *t)
+{
+	struct pw_impl_node *tn = t->node;
+
+	return node->direct_wakeup && tn != NULL && tn != node &&
+		!node->driving && !tn->driving &&
+		!tn->remote && !tn->exported &&
+		tn->data_loop == node->data_loop &&
+		t->activation == tn->rt.target.activation;
+}
+
+/* called from data-loop, like trigger_target_v1 but instead of writing the eventfd,
+ * the node is queued in the ready list */
+static inline int trigger_target_direct(struct pw_node_target *t, uint64_t nsec,
+		struct spa_list *ready)
+{
+	struct pw_node_activation *a = t->activation;
+	struct pw_node_activation_state *state = &a->state[0];
+	int32_t pending = SPA_ATOMIC_DEC(state->pending);
+	int res = pending == 0;
+
+	pw_log_trace_fp("%p: (%s-%u) direct state:%p pending:%d/%d", t->node,
+				t->name, t->id, state, pending, state->required);
+
+	if (res) {
+		if (SPA_LIKELY(SPA_ATOMIC_CAS(a->status,
+					PW_NODE_ACTIVATION_NOT_TRIGGERED,
+					PW_NODE_ACTIVATION_TRIGGERED))) {
+			a->signal_time = nsec;
+			if (spa_list_is_empty(&t->node->rt.ready_link))
+				spa_list_append(ready, &t->node->rt.ready_link);
+		} else {
+			pw_log_trace_fp("%p: (%s-%u) not ready %d", t->node,
+					t->name, t->id, a->status);
+			res = -EIO;
+		}
+	}
+	return res;
+}
+
 /* called from data-loop when all the targets of a node need to be triggered */
-static inline void trigger_targets(struct pw_impl_node *node, int status, uint64_t nsec)
+static inline void trigger_targets(struct pw_impl_node *node, int status, uint64_t nsec,
+		struct spa_list *ready)
 {
 	struct pw_node_target *ta;
 
 	pw_log_trace_fp("%p: (%s-%u) trigger targets %"PRIu64,
 			node, node->name, node->info.id, nsec);
 
-	spa_list_for_each(ta, &node->rt.target_list, link)
-		ta->trigger(ta, nsec);
+	spa_list_for_each(ta, &node->rt.target_list, link) {
+		if (target_is_direct(node, ta))
+			trigger_target_direct(ta, nsec, ready);
+		else
+			ta->trigger(ta, nsec);
+	}
 }
 
 /** \endcond */
@@ -1465,9 +1515,8 @@ static inline void calculate_stats(struct pw_impl_node *this,  struct pw_node_ac
  *
  * This code runs on the client and the server, depending on where the node is.
  */
-static inline int process_node(void *data, uint64_t nsec)
+static inline int process_node(struct pw_impl_node *this, uint64_t nsec, struct spa_list *ready)
 {
-	struct pw_impl_node *this = data;
 	struct pw_impl_port *p;
 	struct pw_node_activation *a = this->rt.target.activation;
 	struct spa_system *data_system = this->rt.target.system;
@@ -1523,7 +1572,7 @@ static inline int process_node(void *data, uint64_t nsec)
 	 * graph because that means we finished the graph. */
 	if (SPA_LIKELY(!this->driving)) {
 		if ((!this->async || a->server_version < 1) && was_awake)
-			trigger_targets(this, status, nsec);
+			trigger_targets(this, status, nsec, ready);
 	} else {
 		/* calculate CPU time when finished */
 		a->signal_time = this->driver_start;
@@ -1537,6 +1586,19 @@ static inline int process_node(void *data, uint64_t nsec)
 	return status;
 }
 
+/* process the nodes that were directly woken up by trigger_targets. This can
+ * queue more nodes that we then process as well. */
+static inline void process_ready(struct spa_list *ready)
+{
+	struct pw_impl_node *n;
+
+	spa_list_consume(n, ready, rt.ready_link) {
+		spa_list_remove(&n->rt.ready_link);
+		spa_list_init(&n->rt.ready_link);
+		process_node(n, get_time_ns(n->rt.target.system), ready);
+	}
+}
+
 int pw_impl_node_trigger(struct pw_impl_node *node)
 {
 	uint64_t nsec = get_time_ns(node->rt.target.system);
@@ -1571,7 +1633,10 @@ static void node_on_fd_events(struct spa_source *source)
 				this, this->remote, this->exported, this->name, this->info.id,
 				nsec);
 
-		process_node(this, nsec);
+		struct spa_list ready;
+		spa_list_init(&ready);
+		process_node(this, nsec, &ready);
+		process_ready(&ready);
 	}
 }
 
@@ -1694,6 +1759,7 @@ struct pw_impl_node *pw_context_create_node(struct pw_context *context,
 	spa_list_init(&this->rt.input_mix);
 	spa_list_init(&this->rt.output_mix);
 	spa_list_init(&this->rt.target_list);
+	spa_list_init(&this->rt.ready_link);
 
 	this->rt.target.activation = this->activation->map->ptr;
 	this->rt.target.node = this;
@@ -1708,6 +1774,8 @@ struct pw_impl_node *pw_context_create_node(struct pw_context *context,
 	this->rt.target.activation->server_version = PW_VERSION_NODE_ACTIVATION;
 	this->rt.target.activation->client_version = PW_VERSION_NODE_ACTIVATION;
 
+	this->direct_wakeup = context->settings.direct_wakeup;
+
 	this->rt.rate_limit.interval = 2 * SPA_NSEC_PER_SEC;
 	this->rt.rate_limit.burst = 1;
 
@@ -2064,6 +2132,7 @@ static int node_ready(void *data, int status)
 	struct spa_system *data_system = node->rt.target.system;
 	struct pw_node_target *t, *reposition_target = NULL;;
 	struct pw_impl_port *p;
+	struct spa_list ready;
 	struct spa_io_clock *cl = &node->rt.position->clock;
 	int sync_type, all_ready, update_sync, target_sync, old_status;
 	uint32_t owner[2], reposition_owner, pending;
@@ -2086,6 +2155,7 @@ static int node_ready(void *data, int status)
 	}
 
 	nsec = get_time_ns(data_system);
+	spa_list_init(&ready);
 
 	while (true) {
 		old_status = SPA_ATOMIC_LOAD(a->status);
@@ -2103,7 +2173,7 @@ static int node_ready(void *data, int status)
 				pw_impl_node_rt_emit_incomplete(driver);
 			}
 			SPA_FLAG_SET(cl->flags, SPA_IO_CLOCK_FLAG_XRUN_RECOVER);
-			process_node(node, nsec);
+			process_node(node, nsec, &ready);
 			SPA_FLAG_CLEAR(cl->flags, SPA_IO_CLOCK_FLAG_XRUN_RECOVER);
 			break;
 		}
@@ -2173,6 +2243,11 @@ retry_status:
 		} else {
 			all_ready &= ta->pending_sync == false;
 		}
+		/* for the critical path */
+		if (t->node != NULL && ta->finish_time > ta->awake_time) {
+			t->node->rt.busy_time += ta->finish_time - ta->awake_time;
+			t->node->rt.busy_count++;
+		}
 		ta->prev_signal_time = ta->signal_time;
 		ta->prev_awake_time = ta->awake_time;
 		ta->prev_finish_time = ta->finish_time;
@@ -2204,7 +2279,8 @@ retry_status:
 	pw_impl_node_rt_emit_start(node);
 
 	/* now signal all the nodes we drive */
-	trigger_targets(node, status, nsec);
+	trigger_targets(node, status, nsec, &ready);
+	process_ready(&ready);
 	return 0;
 }
 
@@ -52,6 +52,10 @@ struct settings {
 	unsigned int clock_power_of_two_quantum:1;
 	unsigned int check_quantum:1;
 	unsigned int check_rate:1;
+	unsigned int direct_wakeup:1;		/* process local nodes without eventfd */
+	unsigned int clock_adaptive_quantum:1;	/* adapt quantum to graph load */
+	uint32_t clock_adaptive_max_load;	/* load in percent to raise quantum */
+	uint32_t clock_adaptive_min_load;	/* load in percent to lower quantum */
 #define CLOCK_RATE_UPDATE_MODE_HARD 0
 #define CLOCK_RATE_UPDATE_MODE_SOFT 1
 	int clock_rate_update_mode;
@@ -797,6 +801,10 @@ struct pw_impl_node {
 	unsigned int sync:1;		/**< the sync-groups are active */
 	unsigned int async:1;		/**< async processing, one cycle latency */
 	unsigned int lazy:1;		/**< the graph is lazy scheduling */
+	unsigned int direct_wakeup:1;	/**< local targets in the same loop are processed
+					  *  without waking up the eventfd */
+	unsigned int critical_checked:1;	/**< critical_time is calculated */
+	unsigned int adaptive_checked:1;	/**< adaptive_xruns is valid */
 
 	uint32_t transport;		/**< latest transport request */
 
@@ -844,9 +852,16 @@ struct pw_impl_node {
 		struct pw_node_target target;		/* our target that is signaled by the
 							   driver */
 		struct spa_list driver_link;		/* our link in driver */
+		struct spa_list ready_link;		/* link in the ready queue when
+							 * woken up directly */
 
 		struct spa_ratelimit rate_limit;
 
+		uint64_t busy_time;			/**< processing time of the cycles
+							 *  since the last critical path update,
+							 *  summed by the driver */
+		uint32_t busy_count;			/**< number of cycles in busy_time */
+
 		bool prepared;				/**< the node was added to loop */
 	} rt;
 	struct pw_node_peer *to_driver_peer;		/* node -> driver */
@@ -855,6 +870,15 @@ struct pw_impl_node {
 	uint64_t target_quantum;
 
 	uint64_t driver_start;
+	uint64_t critical_busy;		/* average processing time of a cycle */
+	uint64_t critical_time;		/* measured processing time of the longest
+					 * chain of nodes starting at this node */
+	uint32_t adaptive_quantum;	/* minimum quantum set by the adaptive
+					 * quantum controller, 0 when unused */
+	uint32_t adaptive_max_quantum;	/* limit for the adaptive quantum, 0 when
+					 * the quantum can't change */
+	uint32_t adaptive_xruns;	/* xrun count at the last check */
+	uint32_t adaptive_low;		/* number of checks with low load */
 	uint64_t elapsed;		/* elapsed time in playing */
 
 	void *user_data;                /**< extra user data */
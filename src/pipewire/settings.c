@@ -37,6 +37,10 @@
 #define DEFAULT_MEM_ALLOW_MLOCK			true
 #define DEFAULT_CHECK_QUANTUM			false
 #define DEFAULT_CHECK_RATE			false
+#define DEFAULT_DIRECT_WAKEUP			false
+#define DEFAULT_CLOCK_ADAPTIVE_QUANTUM		false
+#define DEFAULT_CLOCK_ADAPTIVE_MAX_LOAD		80u
+#define DEFAULT_CLOCK_ADAPTIVE_MIN_LOAD		30u
 
 struct impl {
 	struct pw_context *context;
@@ -221,14 +225,25 @@ void pw_settings_init(struct pw_context *this)
 	d->log_level = get_default_int(p, "log.level", pw_log_level);
 	d->clock_power_of_two_quantum = get_default_bool(p, "clock.power-of-two-quantum",
 			DEFAULT_CLOCK_POWER_OF_TWO_QUANTUM);
+	d->clock_adaptive_quantum = get_default_bool(p, "clock.adaptive-quantum",
+			DEFAULT_CLOCK_ADAPTIVE_QUANTUM);
+	d->clock_adaptive_max_load = get_default_int(p, "clock.adaptive-quantum.max-load",
+			DEFAULT_CLOCK_ADAPTIVE_MAX_LOAD);
+	d->clock_adaptive_min_load = get_default_int(p, "clock.adaptive-quantum.min-load",
+			DEFAULT_CLOCK_ADAPTIVE_MIN_LOAD);
 	d->link_max_buffers = get_default_int(p, "link.max-buffers", DEFAULT_LINK_MAX_BUFFERS);
 	d->mem_warn_mlock = get_default_bool(p, "mem.warn-mlock", DEFAULT_MEM_WARN_MLOCK);
 	d->mem_allow_mlock = get_default_bool(p, "mem.allow-mlock", DEFAULT_MEM_ALLOW_MLOCK);
 
 	d->check_quantum = get_default_bool(p, "settings.check-quantum", DEFAULT_CHECK_QUANTUM);
 	d->check_rate = get_default_bool(p, "settings.check-rate", DEFAULT_CHECK_RATE);
+	d->direct_wakeup = get_default_bool(p, "context.data-loop.direct-wakeup",
+			DEFAULT_DIRECT_WAKEUP);
 
 	d->link_max_buffers = SPA_MAX(d->link_max_buffers, 1u);
+	d->clock_adaptive_max_load = SPA_CLAMP(d->clock_adaptive_max_load, 1u, 100u);
+	d->clock_adaptive_min_load = SPA_MIN(d->clock_adaptive_min_load,
+			d->clock_adaptive_max_load / 2);
 
 	d->clock_quantum_limit = SPA_CLAMP(d->clock_quantum_limit,
 			CLOCK_QUANTUM_FLOOR, CLOCK_QUANTUM_LIMIT);
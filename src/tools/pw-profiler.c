@@ -201,6 +201,37 @@ static int process_driver_block(struct data *d, const struct spa_pod *pod, struc
 	return 0;
 }
 
+static int process_critical_path(struct data *d, const struct spa_pod *pod)
+{
+	struct spa_pod_parser prs;
+	struct spa_pod_frame f[2];
+	uint64_t start = 0, end = 0, busy = 0;
+	int32_t id;
+	bool first = true;
+	int res;
+
+	if (!d->json_dump)
+		return 0;
+
+	spa_pod_parser_pod(&prs, pod);
+	if ((res = spa_pod_parser_push_struct(&prs, &f[0])) < 0 ||
+	    (res = spa_pod_parser_get(&prs,
+			SPA_POD_Long(&start),
+			SPA_POD_Long(&end),
+			SPA_POD_Long(&busy), NULL)) < 0 ||
+	    (res = spa_pod_parser_push_struct(&prs, &f[1])) < 0)
+		return res;
+
+	fprintf(stdout, "{ \"type\": \"critical\", \"start\": %"PRIu64", \"end\": %"PRIu64", "
+			"\"busy\": %"PRIu64", \"ids\": [", start, end, busy);
+	while (spa_pod_parser_get_int(&prs, &id) >= 0) {
+		fprintf(stdout, "%s %d", first ? "" : ",", id);
+		first = false;
+	}
+	fprintf(stdout, " ] },\n");
+	return 0;
+}
+
 static int find_follower(struct data *d, uint32_t id, const char *name)
 {
 	int i;
@@ -559,6 +590,9 @@ static void profiler_profile(void *data, const struct spa_pod *pod)
 			case SPA_PROFILER_driverBlock:
 				res = process_driver_block(d, &p->value, &point);
 				break;
+			case SPA_PROFILER_criticalPath:
+				process_critical_path(d, &p->value);
+				break;
 			case SPA_PROFILER_followerBlock:
 				process_follower_block(d, &p->value, &point);
 				break;
@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/eventfd.h>
 
 #include "pwtest.h"
@@ -435,6 +436,272 @@ PWTEST(cancel_thread_while_dispatching)
 	return PWTEST_PASS;
 }
 
+struct st_data {
+	struct pw_main_loop *ml;
+	struct pw_loop *l;
+	struct spa_source *timers[4];
+	int order[8];
+	int n_order;
+	int periodic;
+};
+
+static void st_on_timer(struct st_data *d, int idx)
+{
+	pwtest_int_lt(d->n_order, 8);
+	d->order[d->n_order++] = idx;
+}
+
+static void st_timer0(void *data, uint64_t expirations)
+{
+	st_on_timer(data, 0);
+}
+
+static void st_timer1(void *data, uint64_t expirations)
+{
+	struct st_data *d = data;
+	st_on_timer(d, 1);
+	/* destroy the timer that would expire next */
+	pw_loop_destroy_source(d->l, d->timers[2]);
+	d->timers[2] = NULL;
+}
+
+static void st_timer2(void *data, uint64_t expirations)
+{
+	st_on_timer(data, 2);
+}
+
+static void st_timer3(void *data, uint64_t expirations)
+{
+	struct st_data *d = data;
+	d->periodic += expirations;
+	if (d->periodic >= 3) {
+		st_on_timer(d, 3);
+		pw_loop_update_timer(d->l, d->timers[3], NULL, NULL, false);
+		pw_main_loop_quit(d->ml);
+	}
+}
+
+static void st_set_timer(struct st_data *d, int idx, uint64_t value, uint64_t interval)
+{
+	struct timespec v, i;
+	v.tv_sec = value / SPA_NSEC_PER_SEC;
+	v.tv_nsec = value % SPA_NSEC_PER_SEC;
+	i.tv_sec = interval / SPA_NSEC_PER_SEC;
+	i.tv_nsec = interval % SPA_NSEC_PER_SEC;
+	pwtest_neg_errno_ok(pw_loop_update_timer(d->l, d->timers[idx], &v, &i, false));
+}
+
+PWTEST(shared_timers)
+{
+	static const struct spa_dict_item loop_props_items[] = {
+		{ PW_KEY_LOOP_SHARED_TIMERS, "true" },
+	};
+	static const struct spa_dict loop_props = SPA_DICT_INIT_ARRAY(loop_props_items);
+	struct st_data data;
+	int i;
+
+	pw_init(0, NULL);
+
+	spa_zero(data);
+	data.ml = pw_main_loop_new(&loop_props);
+	pwtest_ptr_notnull(data.ml);
+
+	data.l = pw_main_loop_get_loop(data.ml);
+	pwtest_ptr_notnull(data.l);
+
+	data.timers[0] = pw_loop_add_timer(data.l, st_timer0, &data);
+	data.timers[1] = pw_loop_add_timer(data.l, st_timer1, &data);
+	data.timers[2] = pw_loop_add_timer(data.l, st_timer2, &data);
+	data.timers[3] = pw_loop_add_timer(data.l, st_timer3, &data);
+	for (i = 0; i < 4; i++) {
+		pwtest_ptr_notnull(data.timers[i]);
+		/* no timerfd per timer */
+		pwtest_int_eq(data.timers[i]->fd, -1);
+	}
+
+	st_set_timer(&data, 0, 20 * SPA_NSEC_PER_MSEC, 0);
+	st_set_timer(&data, 1, 10 * SPA_NSEC_PER_MSEC, 0);
+	st_set_timer(&data, 2, 30 * SPA_NSEC_PER_MSEC, 0);
+	st_set_timer(&data, 3, 50 * SPA_NSEC_PER_MSEC, 10 * SPA_NSEC_PER_MSEC);
+
+	pw_main_loop_run(data.ml);
+
+	pwtest_int_eq(data.n_order, 3);
+	pwtest_int_eq(data.order[0], 1);
+	pwtest_int_eq(data.order[1], 0);
+	pwtest_int_eq(data.order[2], 3);
+	pwtest_int_ge(data.periodic, 3);
+
+	pw_loop_destroy_source(data.l, data.timers[0]);
+	pw_loop_destroy_source(data.l, data.timers[1]);
+	pw_loop_destroy_source(data.l, data.timers[3]);
+	pw_main_loop_destroy(data.ml);
+
+	pw_deinit();
+
+	return PWTEST_PASS;
+}
+
+struct stt_data {
+	struct pw_thread_loop *tl;
+	int count;
+};
+
+static void stt_timer(void *data, uint64_t expirations)
+{
+	struct stt_data *d = data;
+	d->count += expirations;
+	pw_thread_loop_signal(d->tl, false);
+}
+
+PWTEST(shared_timers_thread)
+{
+	static const struct spa_dict_item loop_props_items[] = {
+		{ PW_KEY_LOOP_SHARED_TIMERS, "true" },
+	};
+	static const struct spa_dict loop_props = SPA_DICT_INIT_ARRAY(loop_props_items);
+	struct stt_data data;
+	struct spa_source *timer[2];
+	struct pw_loop *l;
+	struct timespec v;
+	int i;
+
+	pw_init(0, NULL);
+
+	spa_zero(data);
+	data.tl = pw_thread_loop_new("shared-timers", &loop_props);
+	pwtest_ptr_notnull(data.tl);
+	l = pw_thread_loop_get_loop(data.tl);
+
+	pwtest_neg_errno_ok(pw_thread_loop_start(data.tl));
+
+	/* add, update and destroy the timers from outside of the loop
+	 * thread while it is running */
+	pw_thread_loop_lock(data.tl);
+	for (i = 0; i < 2; i++) {
+		timer[i] = pw_loop_add_timer(l, stt_timer, &data);
+		pwtest_ptr_notnull(timer[i]);
+		v.tv_sec = 0;
+		v.tv_nsec = (i + 1) * 10 * SPA_NSEC_PER_MSEC;
+		pwtest_neg_errno_ok(pw_loop_update_timer(l, timer[i], &v, NULL, false));
+	}
+	while (data.count < 2)
+		pw_thread_loop_wait(data.tl);
+	for (i = 0; i < 2; i++)
+		pw_loop_destroy_source(l, timer[i]);
+	pw_thread_loop_unlock(data.tl);
+
+	pwtest_int_eq(data.count, 2);
+
+	pw_thread_loop_stop(data.tl);
+	pw_thread_loop_destroy(data.tl);
+
+	pw_deinit();
+
+	return PWTEST_PASS;
+}
+
+struct uring_data {
+	struct pw_main_loop *ml;
+	struct pw_loop *l;
+	int fds[2];
+	struct spa_source *idle;
+	uint64_t events;
+	int n_io;
+	int n_timer;
+	int n_idle;
+};
+
+static void uring_idle(void *data)
+{
+	struct uring_data *d = data;
+	/* the idle fd is read by the ring, disabling it should still
+	 * clear it, also when it was enabled again in between */
+	d->n_idle++;
+	pwtest_neg_errno_ok(pw_loop_enable_idle(d->l, d->idle, false));
+	pwtest_neg_errno_ok(pw_loop_enable_idle(d->l, d->idle, true));
+	pwtest_neg_errno_ok(pw_loop_enable_idle(d->l, d->idle, false));
+}
+
+static void uring_event(void *data, uint64_t count)
+{
+	struct uring_data *d = data;
+	d->events += count;
+}
+
+static void uring_io(void *data, int fd, uint32_t mask)
+{
+	struct uring_data *d = data;
+	char buf[16];
+
+	/* only consume the data the second time, the source should be
+	 * reported again until then */
+	if (++d->n_io == 2)
+		pwtest_int_eq(read(fd, buf, sizeof(buf)), 1);
+}
+
+static void uring_timer(void *data, uint64_t expirations)
+{
+	struct uring_data *d = data;
+	if (++d->n_timer == 2)
+		pw_main_loop_quit(d->ml);
+}
+
+PWTEST(uring_system)
+{
+	static const struct spa_dict_item loop_props_items[] = {
+		{ PW_KEY_LIBRARY_NAME_SYSTEM, "support/libspa-uring" },
+	};
+	static const struct spa_dict loop_props = SPA_DICT_INIT_ARRAY(loop_props_items);
+	struct uring_data data;
+	struct spa_source *ev, *io, *timer;
+	struct timespec value = { 0, 10 * SPA_NSEC_PER_MSEC };
+
+	pw_init(0, NULL);
+
+	spa_zero(data);
+	data.ml = pw_main_loop_new(&loop_props);
+	if (data.ml == NULL) {
+		pw_deinit();
+		return PWTEST_SKIP;
+	}
+	data.l = pw_main_loop_get_loop(data.ml);
+
+	pwtest_errno_ok(pipe2(data.fds, O_CLOEXEC | O_NONBLOCK));
+
+	ev = pw_loop_add_event(data.l, uring_event, &data);
+	pwtest_ptr_notnull(ev);
+	io = pw_loop_add_io(data.l, data.fds[0], SPA_IO_IN, true, uring_io, &data);
+	pwtest_ptr_notnull(io);
+	timer = pw_loop_add_timer(data.l, uring_timer, &data);
+	pwtest_ptr_notnull(timer);
+	data.idle = pw_loop_add_idle(data.l, true, uring_idle, &data);
+	pwtest_ptr_notnull(data.idle);
+
+	pwtest_neg_errno_ok(pw_loop_signal_event(data.l, ev));
+	pwtest_neg_errno_ok(pw_loop_signal_event(data.l, ev));
+	pwtest_int_eq(write(data.fds[1], "x", 1), 1);
+	pwtest_neg_errno_ok(pw_loop_update_timer(data.l, timer, &value, &value, false));
+
+	pw_main_loop_run(data.ml);
+
+	pwtest_int_eq(data.events, 2u);
+	pwtest_int_eq(data.n_io, 2);
+	pwtest_int_eq(data.n_timer, 2);
+	pwtest_int_eq(data.n_idle, 1);
+
+	pw_loop_destroy_source(data.l, data.idle);
+	pw_loop_destroy_source(data.l, ev);
+	pw_loop_destroy_source(data.l, io);
+	pw_loop_destroy_source(data.l, timer);
+	close(data.fds[1]);
+	pw_main_loop_destroy(data.ml);
+
+	pw_deinit();
+
+	return PWTEST_PASS;
+}
+
 PWTEST_SUITE(support)
 {
 	pwtest_add(pwtest_loop_destroy2, PWTEST_NOARG);
@@ -443,6 +710,9 @@ PWTEST_SUITE(support)
 	pwtest_add(destroy_managed_source_before_dispatch, PWTEST_NOARG);
 	pwtest_add(destroy_managed_source_before_dispatch_recurse, PWTEST_NOARG);
 	pwtest_add(cancel_thread_while_dispatching, PWTEST_NOARG);
+	pwtest_add(shared_timers, PWTEST_NOARG);
+	pwtest_add(shared_timers_thread, PWTEST_NOARG);
+	pwtest_add(uring_system, PWTEST_NOARG);
 
 	return PWTEST_PASS;
 }